@@ -0,0 +1,276 @@
+/**
+ * @file HelperThreadPool.h
+ * @brief Header file for class HelperThreadPool
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class HelperThreadPool
+ * with all of its public, protected and private members. The class is shared by
+ * the GAMs of different libraries, so that all of its methods are defined inline.
+ */
+
+#ifndef HELPERTHREADPOOL_H_
+#define HELPERTHREADPOOL_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+#include "AdvancedErrorManagement.h"
+#include "Atomic.h"
+#include "EmbeddedServiceMethodBinderI.h"
+#include "EventSem.h"
+#include "FastPollingMutexSem.h"
+#include "MultiThreadService.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+/**
+ * @brief Helper threads taking part in a list of independent jobs started by a real-time thread.
+ * @details Run() hands the jobs to the helpers, takes part in the work itself (as thread 0) and returns when all the jobs are done,
+ * so that it acts as a barrier. The jobs are assigned one at a time, so that the calling thread also completes them when the helpers
+ * are late or busy. The derived classes describe the jobs and implement ProcessJob.
+ *
+ * The helpers wait for a new Run on a semaphore (with a timeout, so that they can be stopped) and each of them takes part at most once
+ * in each Run. The derived classes shall call Stop() in their destructor, before the job descriptions are destroyed.
+ */
+class HelperThreadPool: public EmbeddedServiceMethodBinderI {
+public:
+    /**
+     * @brief Constructor. NOOP.
+     */
+    inline HelperThreadPool();
+
+    /**
+     * @brief Stops the helpers.
+     */
+    inline virtual ~HelperThreadPool();
+
+    /**
+     * @brief Starts the helpers.
+     * @param[in] numberOfHelpersIn number of helper threads.
+     * @param[in] cpuMask CPU mask of the helper threads.
+     * @param[in] stackSize stack size of the helper threads.
+     * @param[in] name name of the helper threads.
+     * @param[in] pinHelpers true to pin the i-th helper to the i-th CPU of cpuMask (wrapping around), false to let all of them run on cpuMask.
+     * @return true if the helpers are running.
+     */
+    inline bool Start(const uint32 numberOfHelpersIn, const uint32 cpuMask, const uint32 stackSize, const char8 * const name, const bool pinHelpers);
+
+    /**
+     * @brief Stops the helpers.
+     */
+    inline void Stop();
+
+    /**
+     * @brief Runs the jobs 0 to numberOfJobsIn - 1 with the helpers and returns when all of them are done.
+     */
+    inline void Run(const uint32 numberOfJobsIn);
+
+    /**
+     * @return the number of helper threads.
+     */
+    inline uint32 GetNumberOfHelpers() const;
+
+    /**
+     * @brief Callback of the helper threads: waits for a new Run and takes part in it.
+     */
+    inline virtual ErrorManagement::ErrorType Execute(ExecutionInfo &info);
+
+protected:
+    /**
+     * @brief Runs a job.
+     * @param[in] jobIdx the job, in [0, numberOfJobs).
+     * @param[in] threadIdx the thread running it (0 for the caller of Run(), i + 1 for the i-th helper).
+     */
+    virtual void ProcessJob(const uint32 jobIdx, const uint32 threadIdx) = 0;
+
+private:
+    /**
+     * @brief Runs the jobs of the current Run until none is left.
+     */
+    inline void RunJobs(const uint32 threadIdx);
+
+    /**
+     * The helper threads.
+     */
+    MultiThreadService helpers;
+    uint32 numberOfHelpers;
+    bool running;
+
+    /**
+     * Posted when a new Run is started.
+     */
+    EventSem startSem;
+
+    /**
+     * Protects the job assignment.
+     */
+    FastPollingMutexSem jobMutex;
+
+    /**
+     * The current Run.
+     */
+    int32 numberOfJobs;
+    int32 nextJob;
+    volatile int32 jobsDone;
+
+    /**
+     * Number of helpers running jobs.
+     */
+    volatile int32 activeHelpers;
+
+    /**
+     * Run counter and last Run served by each helper.
+     */
+    volatile uint32 generation;
+    uint32 *helperGeneration;
+};
+}
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * Maximum time (ms) the helpers wait for a Run, so that they can be stopped.
+ */
+static const uint32 HELPER_THREAD_POOL_WAIT_TIMEOUT = 100u;
+
+HelperThreadPool::HelperThreadPool() :
+        EmbeddedServiceMethodBinderI(),
+        helpers(*this) {
+    numberOfHelpers = 0u;
+    running = false;
+    numberOfJobs = 0;
+    nextJob = 0;
+    jobsDone = 0;
+    activeHelpers = 0;
+    generation = 0u;
+    helperGeneration = NULL_PTR(uint32 *);
+    (void) startSem.Create();
+    (void) startSem.Reset();
+    (void) jobMutex.Create();
+}
+
+HelperThreadPool::~HelperThreadPool() {
+    Stop();
+    if (helperGeneration != NULL_PTR(uint32 *)) {
+        delete[] helperGeneration;
+    }
+}
+
+bool HelperThreadPool::Start(const uint32 numberOfHelpersIn, const uint32 cpuMask, const uint32 stackSize, const char8 * const name,
+                             const bool pinHelpers) {
+    numberOfHelpers = numberOfHelpersIn;
+    helperGeneration = new uint32[numberOfHelpers];
+    for (uint32 i = 0u; i < numberOfHelpers; i++) {
+        helperGeneration[i] = 0u;
+    }
+    helpers.SetNumberOfPoolThreads(numberOfHelpers);
+    helpers.SetCPUMask(cpuMask);
+    helpers.SetStackSize(stackSize);
+    helpers.SetName(name);
+    if (pinHelpers) {
+        uint32 cpu = 31u;
+        for (uint32 i = 0u; (i < numberOfHelpers) && (cpuMask != 0u); i++) {
+            do {
+                cpu = (cpu + 1u) % 32u;
+            }
+            while (((cpuMask >> cpu) & 1u) == 0u);
+            helpers.SetCPUMaskThreadPool(1u << cpu, i);
+        }
+    }
+    running = (helpers.Start() == ErrorManagement::NoError);
+    if (!running) {
+        REPORT_ERROR(ErrorManagement::FatalError, "Could not start the helper threads %s", name);
+    }
+    return running;
+}
+
+void HelperThreadPool::Stop() {
+    if (running) {
+        if (helpers.Stop() != ErrorManagement::NoError) {
+            if (helpers.Stop() != ErrorManagement::NoError) {
+                REPORT_ERROR(ErrorManagement::FatalError, "Could not stop the helper threads");
+            }
+        }
+        running = false;
+    }
+}
+
+void HelperThreadPool::Run(const uint32 numberOfJobsIn) {
+    jobMutex.FastLock();
+    numberOfJobs = static_cast<int32>(numberOfJobsIn);
+    nextJob = 0;
+    jobsDone = 0;
+    generation++;
+    jobMutex.FastUnLock();
+    (void) startSem.Post();
+    RunJobs(0u);
+    //Wait for the jobs taken by the helpers
+    while ((jobsDone < numberOfJobs) || (activeHelpers > 0)) {
+    }
+    (void) startSem.Reset();
+}
+
+uint32 HelperThreadPool::GetNumberOfHelpers() const {
+    return numberOfHelpers;
+}
+
+void HelperThreadPool::RunJobs(const uint32 threadIdx) {
+    bool more = true;
+    while (more) {
+        jobMutex.FastLock();
+        int32 job = nextJob;
+        more = (job < numberOfJobs);
+        if (more) {
+            nextJob++;
+        }
+        jobMutex.FastUnLock();
+        if (more) {
+            ProcessJob(static_cast<uint32>(job), threadIdx);
+            Atomic::Increment(&jobsDone);
+        }
+    }
+}
+
+ErrorManagement::ErrorType HelperThreadPool::Execute(ExecutionInfo &info) {
+    ErrorManagement::ErrorType err = ErrorManagement::NoError;
+    if (info.GetStage() == ExecutionInfo::MainStage) {
+        uint32 helperIdx = info.GetThreadNumber();
+        if (startSem.Wait(HELPER_THREAD_POOL_WAIT_TIMEOUT) == ErrorManagement::NoError) {
+            if ((helperIdx < numberOfHelpers) && (helperGeneration[helperIdx] != generation)) {
+                helperGeneration[helperIdx] = generation;
+                Atomic::Increment(&activeHelpers);
+                RunJobs(helperIdx + 1u);
+                Atomic::Decrement(&activeHelpers);
+            }
+        }
+    }
+    return err;
+}
+
+}
+
+#endif /* HELPERTHREADPOOL_H_ */
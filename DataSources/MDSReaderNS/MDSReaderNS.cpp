@@ -3,14 +3,17 @@
 /*---------------------------------------------------------------------------*/
 /*                         Standard header includes                          */
 /*---------------------------------------------------------------------------*/
+#include <stdio.h>
 
 /*---------------------------------------------------------------------------*/
 /*                         Project header includes                           */
 /*---------------------------------------------------------------------------*/
 
 #include "AdvancedErrorManagement.h"
+#include "HighResolutionTimer.h"
 #include "MDSReaderNS.h"
-#include "MemoryMapSynchronisedInputBroker.h"
+#include "MDSReaderNSInputBroker.h"
+#include "MemoryMapOutputBroker.h"
 
 #define DEBUG
 
@@ -20,6 +23,11 @@
 
 /*lint -estring(1960, "*MDSplus::*") -estring(1960, "*std::*") Ignore errors that do not belong to this DataSource namespace*/
 
+/**
+ * Maximum time (ms) the executor waits for a notification, so that it can be stopped.
+ */
+static const MARTe::uint32 NOTIFY_WAIT_TIMEOUT = 100u;
+
 /*---------------------------------------------------------------------------*/
 /*                           Method definitions                              */
 /*---------------------------------------------------------------------------*/
@@ -27,13 +35,13 @@
 namespace MARTe {
 
 MDSReaderNS::MDSReaderNS() :
-        DataSourceI() {
+        DataSourceI(),
+        EmbeddedServiceMethodBinderI(),
+        executor(*this) {
     tree = NULL_PTR(MDSplus::Tree *);
     dataExpr = NULL_PTR(StreamString *);
     timebaseExpr = NULL_PTR(StreamString *);
     numberOfNodeNames = 0u;
-    nOfInputSignals = 0u;
-    nOfInputSignalsPerFunction = 0u;
     byteSizeSignals = NULL_PTR(uint32 *);
     shotNumber = 0;
     type = NULL_PTR(TypeDescriptor *);
@@ -42,24 +50,65 @@ MDSReaderNS::MDSReaderNS() :
     dataSourceMemory = NULL_PTR(char8 *);
     offsets = NULL_PTR(uint32 *);
 
-    currentTime = 0;
     frequency = 0.0;
     period = 0.0;
     endNode = NULL_PTR(bool *);
+    endNodeCycle = NULL_PTR(bool *);
     nodeSamplingTime = NULL_PTR(float64 *);
     
-    timebaseMode = 0;
+    timebaseMode = 0u;
+    speedFactor = 1.0;
+    clockSignalIdx = 0u;
+    clockSignalType = InvalidType;
+    consumers = NULL_PTR(MDSReaderNSConsumer *);
+    numberOfConsumers = 0u;
+    nodeSignalIdx = NULL_PTR(uint32 *);
+    nodeConsumer = NULL_PTR(uint32 *);
+    nodeDataOwner = NULL_PTR(uint32 *);
+    treeStamp = 0u;
+    nodeCache = NULL_PTR(MDSReaderNSCache *);
+    sampleStride = NULL_PTR(uint32 *);
+    elementStride = NULL_PTR(uint32 *);
     startTime = 0.;
-    signalData = NULL_PTR(float64 **);
-    signalTimebase = NULL_PTR(float64 **);
+    signalData = NULL_PTR(const float64 **);
+    signalTimebase = NULL_PTR(const float64 **);
     numSignalSamples = NULL_PTR(uint32 *);
     lastSignalSample = NULL_PTR(uint32 *);
     nElements = NULL_PTR(uint32 *);
     useColumnOrder = NULL_PTR(bool *);
+    dataManagement = NULL_PTR(uint8 *);
+    samplingTime = NULL_PTR(float64 *);
+    signalsEndedMsg = NULL_PTR(ReferenceT<Message> *);
+    nOfMessages = 0u;
+    signalsEndedNotified = false;
+    signalsEndedPending = false;
+    loopMsg = NULL_PTR(ReferenceT<Message> *);
+    nOfLoopMessages = 0u;
+    loopPending = false;
+    isNodeEndMessage = NULL_PTR(bool *);
+    nodeEndMessage = NULL_PTR(uint32 *);
+    nodeEndPending = NULL_PTR(bool *);
+    nodeEndNotify = NULL_PTR(bool *);
+    loopPlayback = 0u;
+    stackSize = THREADS_DEFAULT_STACKSIZE * 4u;
+    cpuMask = 0xffu;
+    if (!endMutex.Create()) {
+        REPORT_ERROR(ErrorManagement::FatalError, "Could not create the FastPollingMutexSem");
+    }
+    if (!notifySem.Create()) {
+        REPORT_ERROR(ErrorManagement::FatalError, "Could not create the EventSem");
+    }
 }
 
 /*lint -e{1551} the destructor must guarantee that the MDSplus are deleted and the shared memory freed*/
 MDSReaderNS::~MDSReaderNS() {
+    if (executor.GetStatus() != EmbeddedThreadI::OffState) {
+        if (executor.Stop() != ErrorManagement::NoError) {
+            if (executor.Stop() != ErrorManagement::NoError) {
+                REPORT_ERROR(ErrorManagement::FatalError, "Could not stop the executor");
+            }
+        }
+    }
 
     if (tree != NULL_PTR(MDSplus::Tree *)) {
         delete tree;
@@ -104,6 +153,10 @@ MDSReaderNS::~MDSReaderNS() {
         delete[] endNode;
         endNode = NULL_PTR(bool *);
     }
+    if (endNodeCycle != NULL_PTR(bool *)) {
+        delete[] endNodeCycle;
+        endNodeCycle = NULL_PTR(bool *);
+    }
     if (numberOfElements != NULL_PTR(uint32 *)) {
         delete[] numberOfElements;
         numberOfElements = NULL_PTR(uint32 *);
@@ -116,13 +169,35 @@ MDSReaderNS::~MDSReaderNS() {
         delete[] nodeSamplingTime;
         nodeSamplingTime = NULL_PTR(float64 *);
     }
-    if (signalData != NULL_PTR(float64 **)) {
+    for (uint32 i = 0u; (signalData != NULL_PTR(const float64 **)) && (signalTimebase != NULL_PTR(const float64 **)) && (i < numberOfNodeNames); i++) {
+        bool cached = false;
+        if (nodeCache != NULL_PTR(MDSReaderNSCache *)) {
+            cached = nodeCache[i].IsMapped();
+        }
+        bool shared = false;
+        if (nodeDataOwner != NULL_PTR(uint32 *)) {
+            shared = (nodeDataOwner[i] != i);
+        }
+        if ((!cached) && (!shared)) { //Otherwise the arrays belong to the mapped cache entry or to another node
+            if (signalData[i] != NULL_PTR(const float64 *)) {
+                delete[] signalData[i];
+            }
+            if (signalTimebase[i] != NULL_PTR(const float64 *)) {
+                delete[] signalTimebase[i];
+            }
+        }
+    }
+    if (signalData != NULL_PTR(const float64 **)) {
         delete[] signalData;
-        signalData = NULL_PTR(float64 **);
+        signalData = NULL_PTR(const float64 **);
     }
-    if (signalTimebase != NULL_PTR(float64 **)) {
+    if (signalTimebase != NULL_PTR(const float64 **)) {
         delete[] signalTimebase;
-        signalTimebase = NULL_PTR(float64 **);
+        signalTimebase = NULL_PTR(const float64 **);
+    }
+    if (nodeCache != NULL_PTR(MDSReaderNSCache *)) {
+        delete[] nodeCache;
+        nodeCache = NULL_PTR(MDSReaderNSCache *);
     }
     if (numSignalSamples != NULL_PTR(uint32 *)) {
         delete[] numSignalSamples;
@@ -140,6 +215,54 @@ MDSReaderNS::~MDSReaderNS() {
         delete[] nElements;
         nElements = NULL_PTR(uint32 *);
     }
+    if (sampleStride != NULL_PTR(uint32 *)) {
+        delete[] sampleStride;
+        sampleStride = NULL_PTR(uint32 *);
+    }
+    if (elementStride != NULL_PTR(uint32 *)) {
+        delete[] elementStride;
+        elementStride = NULL_PTR(uint32 *);
+    }
+    if (consumers != NULL_PTR(MDSReaderNSConsumer *)) {
+        delete[] consumers;
+        consumers = NULL_PTR(MDSReaderNSConsumer *);
+    }
+    if (nodeSignalIdx != NULL_PTR(uint32 *)) {
+        delete[] nodeSignalIdx;
+        nodeSignalIdx = NULL_PTR(uint32 *);
+    }
+    if (nodeConsumer != NULL_PTR(uint32 *)) {
+        delete[] nodeConsumer;
+        nodeConsumer = NULL_PTR(uint32 *);
+    }
+    if (nodeDataOwner != NULL_PTR(uint32 *)) {
+        delete[] nodeDataOwner;
+        nodeDataOwner = NULL_PTR(uint32 *);
+    }
+    if (signalsEndedMsg != NULL_PTR(ReferenceT<Message> *)) {
+        delete[] signalsEndedMsg;
+        signalsEndedMsg = NULL_PTR(ReferenceT<Message> *);
+    }
+    if (loopMsg != NULL_PTR(ReferenceT<Message> *)) {
+        delete[] loopMsg;
+        loopMsg = NULL_PTR(ReferenceT<Message> *);
+    }
+    if (isNodeEndMessage != NULL_PTR(bool *)) {
+        delete[] isNodeEndMessage;
+        isNodeEndMessage = NULL_PTR(bool *);
+    }
+    if (nodeEndMessage != NULL_PTR(uint32 *)) {
+        delete[] nodeEndMessage;
+        nodeEndMessage = NULL_PTR(uint32 *);
+    }
+    if (nodeEndPending != NULL_PTR(bool *)) {
+        delete[] nodeEndPending;
+        nodeEndPending = NULL_PTR(bool *);
+    }
+    if (nodeEndNotify != NULL_PTR(bool *)) {
+        delete[] nodeEndNotify;
+        nodeEndNotify = NULL_PTR(bool *);
+    }
     
 }
 
@@ -183,6 +306,81 @@ std::cout << "MDS READER INIT" <<std::endl;
             REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read StartTime");
         }
     }
+    if (ok) { //read TimebaseMode
+        if (!data.Read("TimebaseMode", timebaseMode)) {
+            timebaseMode = 0u;
+        }
+        ok = (timebaseMode < 4u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError,
+                         "Invalid TimebaseMode %d. It could be 0 (fixed period), 1 (input signal), 2 (speed multiplier) or 3 (free-run)", timebaseMode);
+        }
+    }
+    if (ok) {
+        if (timebaseMode == 1u) {
+            ok = data.Read("ClockSignal", clockSignalName);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "ClockSignal shall be specified when TimebaseMode = 1");
+            }
+        }
+        else if (timebaseMode == 2u) {
+            ok = data.Read("SpeedFactor", speedFactor);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "SpeedFactor shall be specified when TimebaseMode = 2");
+            }
+            if (ok) {
+                ok = (speedFactor > 0.);
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "SpeedFactor shall be positive");
+                }
+            }
+        }
+        else {
+
+        }
+    }
+    if (ok) { //read LoopPlayback
+        if (!data.Read("LoopPlayback", loopPlayback)) {
+            loopPlayback = 0u;
+        }
+        ok = (loopPlayback < 2u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "LoopPlayback shall be 0 or 1");
+        }
+    }
+    if (ok && (loopPlayback == 1u)) {
+        ok = (timebaseMode != 1u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "LoopPlayback = 1 is not applicable to TimebaseMode = 1");
+        }
+    }
+    if (ok) { //read the executor parameters
+        if (!data.Read("CPUs", cpuMask)) {
+            REPORT_ERROR(ErrorManagement::Information, "No CPUs defined. Using default = %d", cpuMask);
+        }
+        if (!data.Read("StackSize", stackSize)) {
+            REPORT_ERROR(ErrorManagement::Information, "No StackSize defined. Using default = %d", stackSize);
+        }
+        executor.SetStackSize(stackSize);
+        executor.SetCPUMask(cpuMask);
+    }
+    if (ok) { //read the optional CacheDirectory
+        if (data.Read("CacheDirectory", cacheDirectory)) {
+            int32 cacheShot = shotNumber;
+            if (cacheShot == 0) { //Resolve the current shot, otherwise the cache would survive a new pulse
+                try {
+                    cacheShot = MDSplus::Tree::getCurrent(treeName.Buffer());
+                }
+                catch (const MDSplus::MdsException &exc) {
+                    cacheShot = 0;
+                }
+            }
+            if ((cacheShot == 0) || (!MDSReaderNSCache::GetTreeStamp(treeName, cacheShot, treeStamp))) {
+                REPORT_ERROR(ErrorManagement::Warning, "Cannot locate the files of tree %s. The expressions cache is disabled", treeName.Buffer());
+                cacheDirectory = "";
+            }
+        }
+    }
     if (ok) {
         ok = data.MoveRelative("Signals");
         if (!ok) {
@@ -211,32 +409,51 @@ std::cout << "MDS READER INIT" <<std::endl;
     }
     
     if (ok) {
-        //Check if there are any Message elements set
-        nOfMessages = 0;
-        if (Size() > 0u) {
-            ReferenceT<ReferenceContainer> msgContainer = Get(0u);
+        //Check if there are any Message elements set. The LoopMessages container is optional and only used with LoopPlayback = 1
+        nOfMessages = 0u;
+        nOfLoopMessages = 0u;
+        bool messagesFound = false;
+        for (uint32 c = 0u; (c < Size()) && (ok); c++) {
+            ReferenceT<ReferenceContainer> msgContainer = Get(c);
             if (msgContainer.IsValid()) {
-                uint32 j;
-                nOfMessages = msgContainer->Size();
-		signalsEndedMsg = new MARTe::ReferenceT<MARTe::Message>[nOfMessages];
-                for (j = 0u; (j < nOfMessages) && (ok); j++) {
-                    ReferenceT<Message> msg = msgContainer->Get(j);
-                    ok = msg.IsValid();
+                StreamString containerName = msgContainer->GetName();
+                if (containerName == "LoopMessages") {
+                    ok = (loopPlayback == 1u);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::ParametersError, "LoopMessages are only supported with LoopPlayback = 1");
+                    }
                     if (ok) {
-                        StreamString msgName = msg->GetName();
-                        //if (msgName == "SignalsEnded") {
-                            signalsEndedMsg[j] = msg;
-                        //}
-                        //else {
-                       //     REPORT_ERROR(ErrorManagement::ParametersError, "Message %s is not supported.", msgName.Buffer());
-                      //      ok = false;
-                     //   }
+                        nOfLoopMessages = msgContainer->Size();
+                        loopMsg = new ReferenceT<Message>[nOfLoopMessages];
                     }
-                    else {
-                        REPORT_ERROR(ErrorManagement::ParametersError, "Found an invalid Message in container %s", msgContainer->GetName());
-                        ok = false;
+                    for (uint32 j = 0u; (j < nOfLoopMessages) && (ok); j++) {
+                        loopMsg[j] = msgContainer->Get(j);
+                        ok = loopMsg[j].IsValid();
+                        if (!ok) {
+                            REPORT_ERROR(ErrorManagement::ParametersError, "Found an invalid Message in container %s", msgContainer->GetName());
+                        }
+                    }
+                }
+                else if (!messagesFound) {
+                    messagesFound = true;
+                    uint32 j;
+                    nOfMessages = msgContainer->Size();
+                    signalsEndedMsg = new ReferenceT<Message>[nOfMessages];
+                    isNodeEndMessage = new bool[nOfMessages];
+                    for (j = 0u; (j < nOfMessages) && (ok); j++) {
+                        ReferenceT<Message> msg = msgContainer->Get(j);
+                        ok = msg.IsValid();
+                        if (ok) {
+                            signalsEndedMsg[j] = msg;
+                            isNodeEndMessage[j] = false;
+                        }
+                        else {
+                            REPORT_ERROR(ErrorManagement::ParametersError, "Found an invalid Message in container %s", msgContainer->GetName());
+                        }
                     }
-
+                }
+                else {
+                    //Only the first child container (other than LoopMessages) holds the end of data messages
                 }
             }
         }
@@ -254,59 +471,216 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
     if (!ok) {
         REPORT_ERROR(ErrorManagement::ParametersError, "DataSourceI::SetConfiguredDatabase(data) returned false");
     }
-    if (ok) { // Check that only one GAM is Connected to the MDSReaderNS
-        uint32 auxNumberOfFunctions = GetNumberOfFunctions();
-        ok = (auxNumberOfFunctions == 1u);
+    uint32 nOfSignals = GetNumberOfSignals();
+    if (ok && (timebaseMode == 1u)) {
+        ok = GetSignalIndex(clockSignalIdx, clockSignalName.Buffer());
         if (!ok) {
-            REPORT_ERROR(ErrorManagement::ParametersError, "Exactly one Function allowed to interact with this DataSourceI. number of Functions = %u",
-                         auxNumberOfFunctions);
+            REPORT_ERROR(ErrorManagement::ParametersError, "ClockSignal %s is not declared", clockSignalName.Buffer());
+        }
+        if (ok) {
+            clockSignalType = GetSignalType(clockSignalIdx);
+            ok = (clockSignalType == Float64Bit) || (clockSignalType == Float32Bit) || (clockSignalType == UnsignedInteger64Bit)
+                    || (clockSignalType == SignedInteger64Bit) || (clockSignalType == UnsignedInteger32Bit) || (clockSignalType == SignedInteger32Bit);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unsupported ClockSignal type. Possible types are: float64, float32, uint64, int64, uint32 or int32");
+            }
         }
     }
-    if (ok) { //read number of nodes per function numberOfNodeNames
-        //0u (second argument) because previously it is checked
-        ok = GetFunctionNumberOfSignals(InputSignals, 0u, nOfInputSignalsPerFunction);        //0u (second argument) because previously it is checked
-        if (!ok) {
-            REPORT_ERROR(ErrorManagement::ParametersError, "GetFunctionNumberOfSignals() returned false");
+    //Index of the node (or time signal) of each signal. nOfSignals if not a node (or not a time signal).
+    uint32 *signalNode = NULL_PTR(uint32 *);
+    uint32 *signalTime = NULL_PTR(uint32 *);
+    uint32 numberOfTimeSignals = 0u;
+    if (ok) { //The signals with a DataExpr are nodes, the others (but the clock signal) are time signals
+        signalNode = new uint32[nOfSignals];
+        signalTime = new uint32[nOfSignals];
+        numberOfNodeNames = 0u;
+        for (uint32 s = 0u; (s < nOfSignals) && ok; s++) {
+            signalNode[s] = nOfSignals;
+            signalTime[s] = nOfSignals;
+            ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(s));
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Cannot move to the children %u", s);
+            }
+            if (ok) {
+                StreamString auxExpr;
+                if (originalSignalInformation.Read("DataExpr", auxExpr)) {
+                    signalNode[s] = numberOfNodeNames;
+                    numberOfNodeNames++;
+                }
+                else if ((timebaseMode != 1u) || (s != clockSignalIdx)) {
+                    signalTime[s] = numberOfTimeSignals;
+                    numberOfTimeSignals++;
+                }
+                else {
+
+                }
+                ok = originalSignalInformation.MoveToAncestor(1u);
+            }
         }
-/*        if (ok) {
-            ok = (nOfInputSignalsPerFunction > 1u);
+        if (ok) {
+            ok = (numberOfTimeSignals > 0u);
             if (!ok) {
-                REPORT_ERROR(ErrorManagement::ParametersError, "The number of signals must be at least 2 (1 node and one time)");
+                REPORT_ERROR(ErrorManagement::ParametersError, "At least one time signal (a signal without DataExpr) shall be declared");
             }
-       }
-*/    }
-    if (ok) {
-        nOfInputSignals = GetNumberOfSignals();
-//	ok = (nOfInputSignals == nOfInputSignalsPerFunction);
-	ok = (nOfInputSignals == nOfInputSignalsPerFunction || nOfInputSignals == nOfInputSignalsPerFunction+1); //Time field may be excluded
-        if (!ok) {
-            REPORT_ERROR(ErrorManagement::ParametersError,
-                         "nOfInputSignals %d must be equal than number %d of signals per function (since only one function can be connected to this data source)",
-                         nOfInputSignals, nOfInputSignalsPerFunction);
         }
     }
-    if (ok) {
-        numberOfNodeNames = nOfInputSignals - 1u;
-    }
-    if (ok) {
-        for (uint32 n = 0u; (n < nOfInputSignals-1) && ok; n++) {
-            uint32 nSamples = 0u;
-            ok = GetFunctionSignalSamples(InputSignals, 0u, n, nSamples);
+    if (ok) { //Every Function reading from the MDSReaderNS is a consumer. Only the clock signal can be written
+        uint32 auxNumberOfFunctions = GetNumberOfFunctions();
+        uint32 nOfOutputSignals = 0u;
+        numberOfConsumers = 0u;
+        for (uint32 f = 0u; (f < auxNumberOfFunctions) && ok; f++) {
+            uint32 nIn = 0u;
+            uint32 nOut = 0u;
+            ok = GetFunctionNumberOfSignals(InputSignals, f, nIn);
             if (ok) {
-                ok = (nSamples == 1u);
+                ok = GetFunctionNumberOfSignals(OutputSignals, f, nOut);
+            }
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "GetFunctionNumberOfSignals() returned false");
             }
+            if (nIn > 0u) {
+                numberOfConsumers++;
+            }
+            nOfOutputSignals += nOut;
+        }
+        if (ok) {
+            ok = (numberOfConsumers > 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "At least one Function shall read from this DataSourceI");
+            }
+        }
+        if (ok) {
+            ok = (nOfOutputSignals == ((timebaseMode == 1u) ? 1u : 0u));
             if (!ok) {
-                REPORT_ERROR(ErrorManagement::ParametersError, "The number of samples shall be exactly 1", nSamples);
+                REPORT_ERROR(ErrorManagement::ParametersError, "Only the ClockSignal (TimebaseMode = 1) can be written into this DataSourceI");
+            }
+        }
+        if (ok) {
+            consumers = new MDSReaderNSConsumer[numberOfConsumers];
+            nodeSignalIdx = new uint32[numberOfNodeNames];
+            nodeConsumer = new uint32[numberOfNodeNames];
+            for (uint32 s = 0u; s < nOfSignals; s++) {
+                if (signalNode[s] < nOfSignals) {
+                    nodeSignalIdx[signalNode[s]] = s;
+                    nodeConsumer[signalNode[s]] = numberOfConsumers;
+                }
+            }
+            uint32 c = 0u;
+            for (uint32 f = 0u; (f < auxNumberOfFunctions) && ok; f++) {
+                uint32 nIn = 0u;
+                ok = GetFunctionNumberOfSignals(InputSignals, f, nIn);
+                if (ok && (nIn > 0u)) {
+                    consumers[c].functionIdx = f;
+                    consumers[c].timeSignalIdx = nOfSignals;
+                    consumers[c].currentTime = 0.;
+                    consumers[c].numCycles = 0u;
+                    consumers[c].startCounter = 0u;
+                    for (uint32 n = 0u; (n < nIn) && ok; n++) {
+                        StreamString signalName;
+                        uint32 s = 0u;
+                        ok = GetFunctionSignalAlias(InputSignals, f, n, signalName);
+                        if (ok) {
+                            ok = GetSignalIndex(s, signalName.Buffer());
+                        }
+                        if (ok) {
+                            uint32 nSamples = 0u;
+                            ok = GetFunctionSignalSamples(InputSignals, f, n, nSamples);
+                            if (ok) {
+                                ok = (nSamples == 1u);
+                            }
+                            if (!ok) {
+                                REPORT_ERROR(ErrorManagement::ParametersError, "The number of samples of signal %s shall be exactly 1", signalName.Buffer());
+                            }
+                        }
+                        if (ok) {
+                            if (signalNode[s] < nOfSignals) {
+                                ok = (nodeConsumer[signalNode[s]] == numberOfConsumers);
+                                if (!ok) {
+                                    REPORT_ERROR(ErrorManagement::ParametersError,
+                                                 "Signal %s is read by more than one Function. Declare another signal with the same DataExpr, the data will be shared",
+                                                 signalName.Buffer());
+                                }
+                                nodeConsumer[signalNode[s]] = c;
+                            }
+                            else if (signalTime[s] < nOfSignals) {
+                                ok = (consumers[c].timeSignalIdx == nOfSignals);
+                                if (!ok) {
+                                    REPORT_ERROR(ErrorManagement::ParametersError, "A Function can read only one time signal");
+                                }
+                                consumers[c].timeSignalIdx = s;
+                            }
+                            else {
+
+                            }
+                        }
+                    }
+                    c++;
+                }
             }
         }
+        //The time may be excluded by a single Function (and then it is the only time signal)
+        if (ok && (numberOfConsumers == 1u) && (numberOfTimeSignals == 1u) && (consumers[0].timeSignalIdx == nOfSignals)) {
+            for (uint32 s = 0u; s < nOfSignals; s++) {
+                if (signalTime[s] < nOfSignals) {
+                    consumers[0].timeSignalIdx = s;
+                }
+            }
+        }
+        for (uint32 c = 0u; (c < numberOfConsumers) && ok; c++) {
+            ok = (consumers[c].timeSignalIdx < nOfSignals);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Every Function reading from this DataSourceI shall read its own time signal");
+            }
+            for (uint32 d = 0u; (d < c) && ok; d++) {
+                ok = (consumers[d].timeSignalIdx != consumers[c].timeSignalIdx);
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "The same time signal cannot be read by more than one Function");
+                }
+            }
+        }
+        for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
+            ok = (nodeConsumer[i] < numberOfConsumers);
+            if (!ok) {
+                StreamString signalName;
+                (void) GetSignalName(nodeSignalIdx[i], signalName);
+                REPORT_ERROR(ErrorManagement::ParametersError, "Signal %s is not read by any Function", signalName.Buffer());
+            }
+        }
+    }
+    if (signalNode != NULL_PTR(uint32 *)) {
+        delete[] signalNode;
+    }
+    if (signalTime != NULL_PTR(uint32 *)) {
+        delete[] signalTime;
+    }
+    //read the optional Frequency and StartTime of each time signal. By default the ones of the DataSourceI
+    for (uint32 c = 0u; (c < numberOfConsumers) && ok; c++) {
+        float64 consumerFrequency = frequency;
+        consumers[c].startTime = startTime;
+        ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(consumers[c].timeSignalIdx));
+        if (ok) {
+            (void) originalSignalInformation.Read("Frequency", consumerFrequency);
+            (void) originalSignalInformation.Read("StartTime", consumers[c].startTime);
+            ok = originalSignalInformation.MoveToAncestor(1u);
+        }
+        if (ok) {
+            ok = (consumerFrequency > 0.);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Frequency shall be positive");
+            }
+        }
+        if (ok) {
+            consumers[c].period = 1.0 / consumerFrequency;
+        }
     }
 
     if (ok) { //read dataExpr and timebaseExpr from originalSignalInformation
         dataExpr = new StreamString[numberOfNodeNames];
         timebaseExpr = new StreamString[numberOfNodeNames];
 	useColumnOrder = new bool[numberOfNodeNames];
+	nodeEndMessage = new uint32[numberOfNodeNames];
         for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
-            ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(i));
+            ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(nodeSignalIdx[i]));
             if (!ok) {
                 uint32 auxIdx = i;
                 REPORT_ERROR(ErrorManagement::ParametersError, "Cannot move to the children %u", auxIdx);
@@ -339,6 +713,22 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
 		  ok = true; //Parameter is optional
 		useColumnOrder[i] = (useColumnOrderId == 1);
 	    }
+            if (ok) { //Optional message sent when this node ends, instead of when all the nodes end
+                nodeEndMessage[i] = nOfMessages;
+                StreamString endMessageName;
+                if (originalSignalInformation.Read("EndMessage", endMessageName)) {
+                    for (uint32 j = 0u; (j < nOfMessages) && (nodeEndMessage[i] == nOfMessages); j++) {
+                        if (endMessageName == signalsEndedMsg[j]->GetName()) {
+                            nodeEndMessage[i] = j;
+                            isNodeEndMessage[j] = true;
+                        }
+                    }
+                    ok = (nodeEndMessage[i] < nOfMessages);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::ParametersError, "EndMessage %s not found", endMessageName.Buffer());
+                    }
+                }
+            }
             if (ok) {
                 ok = originalSignalInformation.MoveToAncestor(1u);
                 if (!ok) { //Should never happen
@@ -348,9 +738,9 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
 	}
     }
     if (ok) { //read the type specified in the configuration file 
-        type = new TypeDescriptor[nOfInputSignals];
+        type = new TypeDescriptor[nOfSignals];
         //lint -e{613} Possible use of null pointer. type previously allocated (see previous line).
-        for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
+        for (uint32 i = 0u; (i < nOfSignals) && ok; i++) {
             type[i] = GetSignalType(i);
             ok = !(type[i] == InvalidType);
             if (!ok) {
@@ -358,22 +748,15 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
             }
         }
     }
-    if (ok) { //read the type of the time. It should be uin64
-        //lint -e{662} [MISRA C++ 5-0-16] Possible access out-of-bounds pointer. nOfInputSignals is always 1 unit larger than numberOfNodeNames.
-        //lint -e{661} [MISRA C++ 5-0-16] Possible access out-of-bounds pointer. nOfInputSignals is always 1 unit larger than numberOfNodeNames.
-        if (type != NULL_PTR(TypeDescriptor *)) {
-            type[numberOfNodeNames] = GetSignalType(numberOfNodeNames);
-            bool cond1 = (type[numberOfNodeNames] == UnsignedInteger64Bit);
-            bool cond2 = (type[numberOfNodeNames] == UnsignedInteger32Bit);
-            bool cond3 = (type[numberOfNodeNames] == SignedInteger32Bit);
-            bool cond4 = (type[numberOfNodeNames] == SignedInteger64Bit);
-            ok = cond1 || cond2 || cond3 || cond4;
-            if (!ok) {
-                REPORT_ERROR(ErrorManagement::ParametersError, "Unsupported time type. Possible time types are: uint64, int64, uin32 or int32\n");
-            }
-        }
-        else {
-            ok = false;
+    for (uint32 c = 0u; (c < numberOfConsumers) && ok; c++) { //read the type of the time signals. It should be uin64
+        uint32 timeIdx = consumers[c].timeSignalIdx;
+        bool cond1 = (type[timeIdx] == UnsignedInteger64Bit);
+        bool cond2 = (type[timeIdx] == UnsignedInteger32Bit);
+        bool cond3 = (type[timeIdx] == SignedInteger32Bit);
+        bool cond4 = (type[timeIdx] == SignedInteger64Bit);
+        ok = cond1 || cond2 || cond3 || cond4;
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Unsupported time type. Possible time types are: uint64, int64, uin32 or int32\n");
         }
     }
 
@@ -381,7 +764,7 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
         bytesType = new uint32[numberOfNodeNames];
         if ((bytesType != NULL_PTR(uint32 *)) && (type != NULL_PTR(TypeDescriptor *))) {
             for (uint32 i = 0u; i < numberOfNodeNames; i++) {
-                bytesType[i] = static_cast<uint32>(type[i].numberOfBits) / 8u;
+                bytesType[i] = static_cast<uint32>(type[nodeSignalIdx[i]].numberOfBits) / 8u;
             }
         }
         else {
@@ -390,8 +773,8 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
     }
 
     if (ok) { //read number of elements
-        numberOfElements = new uint32[nOfInputSignals];
-        for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
+        numberOfElements = new uint32[nOfSignals];
+        for (uint32 i = 0u; (i < nOfSignals) && ok; i++) {
             ok = GetSignalNumberOfElements(i, numberOfElements[i]);
             if (!ok) {
                 REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read NumberOfElements");
@@ -403,62 +786,29 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
                 }
             }
         }
-        if (ok) {
-            //lint -e{661} [MISRA C++ 5-0-16] Possible access out-of-bounds. nOfInputSignals is always 1 unit larger than numberOfNodeNames.
-            ok = GetSignalNumberOfElements(numberOfNodeNames, numberOfElements[numberOfNodeNames]);
-            if (!ok) {
-                REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read NumberOfElements");
-            }
-        }
-        if (ok) {
-            //lint -e{661} [MISRA C++ 5-0-16] Possible access out-of-bounds. nOfInputSignals is always 1 unit larger than numberOfNodeNames.
-            ok = numberOfElements[numberOfNodeNames] == 1u;
+        for (uint32 c = 0u; (c < numberOfConsumers) && ok; c++) {
+            ok = numberOfElements[consumers[c].timeSignalIdx] == 1u;
             if (!ok) {
                 REPORT_ERROR(ErrorManagement::ParametersError, "NumberOfElements for the time must be 1");
             }
         }
     }
-    //lint -e{661} [MISRA C++ 5-0-16] Possible access out-of-bounds. nOfInputSignals is always 1 unit larger than numberOfNodeNames.
-    if (ok) { //Count and allocate memory for dataSourceMemory, lastValue and lastTime
-        offsets = new uint32[nOfInputSignals];
-        byteSizeSignals = new uint32[nOfInputSignals];
+    if (ok) { //Count and allocate memory for dataSourceMemory
+        offsets = new uint32[nOfSignals];
+        byteSizeSignals = new uint32[nOfSignals];
 
 	//Count the number of bytes
         uint32 totalSignalMemory = 0u;
-        uint32 sumLastValueMemory = 0u;
-        if (type != NULL_PTR(TypeDescriptor *)) {
-            if ((offsets != NULL_PTR(uint32 *)) && (byteSizeSignals != NULL_PTR(uint32 *))) {
-                for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
-                    offsets[i] = totalSignalMemory;
-                    uint32 nBytes = 0u;
-                    ok = GetSignalByteSize(i, nBytes);
-
-                    byteSizeSignals[i] = nBytes;
-                    if (!ok) {
-                        uint32 auxIdx = i;
-                        REPORT_ERROR(ErrorManagement::ParametersError, "Error while GetSignalByteSize() for signal %u", auxIdx);
-                    }
-                    totalSignalMemory += nBytes;
-                    sumLastValueMemory += static_cast<uint32>(type[i].numberOfBits) / 8u;
-                }
-                if (ok) { // count the time as well
-                    offsets[numberOfNodeNames] = totalSignalMemory;
-                    uint32 nBytes = 0u;
-                    ok = GetSignalByteSize(numberOfNodeNames, nBytes);
-                    byteSizeSignals[numberOfNodeNames] = nBytes;
-                    if (!ok) {
-                        REPORT_ERROR(ErrorManagement::ParametersError, "Error while GetSignalByteSize() for signal %u", numberOfNodeNames);
-                    }
-                    totalSignalMemory += nBytes;
-
-                }
-            }
-            else {
-                ok = false;
+        for (uint32 i = 0u; (i < nOfSignals) && ok; i++) {
+            offsets[i] = totalSignalMemory;
+            uint32 nBytes = 0u;
+            ok = GetSignalByteSize(i, nBytes);
+            byteSizeSignals[i] = nBytes;
+            if (!ok) {
+                uint32 auxIdx = i;
+                REPORT_ERROR(ErrorManagement::ParametersError, "Error while GetSignalByteSize() for signal %u", auxIdx);
             }
-        }
-        else {
-            ok = false;
+            totalSignalMemory += nBytes;
         }
 
         //Allocate memory
@@ -468,15 +818,26 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
     }
     if (ok) { //read DataManagement from originalSignalInformation
         dataManagement = new uint8[numberOfNodeNames];
+        samplingTime = new float64[numberOfNodeNames];
         nodeSamplingTime = new float64[numberOfNodeNames];
-	signalData = new float64 *[numberOfNodeNames];
-	signalTimebase = new float64 *[numberOfNodeNames];
+	signalData = new const float64 *[numberOfNodeNames];
+	signalTimebase = new const float64 *[numberOfNodeNames];
 	numSignalSamples = new uint32[numberOfNodeNames];
 	lastSignalSample = new uint32[numberOfNodeNames];
 	nElements = new uint32[numberOfNodeNames];
+	nodeCache = new MDSReaderNSCache[numberOfNodeNames];
+	sampleStride = new uint32[numberOfNodeNames];
+	elementStride = new uint32[numberOfNodeNames];
+	nodeDataOwner = new uint32[numberOfNodeNames];
+        for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+            signalData[i] = NULL_PTR(const float64 *);
+            signalTimebase[i] = NULL_PTR(const float64 *);
+            nodeDataOwner[i] = i;
+            samplingTime[i] = consumers[nodeConsumer[i]].period;
+        }
         //lint -e{613} Possible use of null pointer. The pointer usage is protected by the ok variable.
         for (uint32 i = 0u; (i < numberOfNodeNames) && ok; i++) {
-            ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(i));
+            ok = originalSignalInformation.MoveRelative(originalSignalInformation.GetChildName(nodeSignalIdx[i]));
             if (!ok) {
                 uint32 auxIdx = i;
                 REPORT_ERROR(ErrorManagement::ParametersError, "Cannot move to the children %u", auxIdx);
@@ -499,23 +860,23 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
                 }
             }
             if (ok) {
-	        ok = GetNodeDataAndSamplingTime(i, signalData[i], nElements[i], signalTimebase[i],  numSignalSamples[i], nodeSamplingTime[i]);
+	        ok = LoadNodeData(i);
 	    }
 
 #ifdef DEBUG
 	    std::cout << "Number of elements: " << nElements[i] << "   Number of samples: " << numSignalSamples[i] << std::endl;
 	    for(int j  =0; j < nElements[i]; j++)
 	    {
-	        std::cout << signalData[i][j] << "  "; std::cout<< std::endl;
+	        std::cout << GetNodeValue(i, 0u, j) << "  "; std::cout<< std::endl;
 	    }	    
 #endif	    
 	    
 	    if(ok)  {
 		lastSignalSample[i] = 0;
-		if(nElements[i] != numberOfElements[i])
+		if(nElements[i] != numberOfElements[nodeSignalIdx[i]])
 		{
                     REPORT_ERROR(ErrorManagement::ParametersError, "Declared number of elements %d is different from actual number of elements %d  for dataExpr = %s", 
-				 numberOfElements[i], nElements[i], dataExpr[i].Buffer());
+				 numberOfElements[nodeSignalIdx[i]], nElements[i], dataExpr[i].Buffer());
 		    ok = false;
 		}
             }
@@ -541,60 +902,146 @@ bool MDSReaderNS::SetConfiguredDatabase(StructuredDataI & data) {
     }
     if (ok) {
         endNode = new bool[numberOfNodeNames];
+        endNodeCycle = new bool[numberOfNodeNames];
+        nodeEndPending = new bool[numberOfNodeNames];
+        nodeEndNotify = new bool[numberOfNodeNames];
         for (uint32 i = 0u; i < numberOfNodeNames; i++) {
             endNode[i] = false;
+            endNodeCycle[i] = false;
+            nodeEndPending[i] = false;
+            nodeEndNotify[i] = false;
+        }
+    }
+    if (ok && ((nOfMessages > 0u) || (nOfLoopMessages > 0u))) { //The messages are sent by the executor, never by the real-time threads
+        ok = (executor.Start() == ErrorManagement::NoError);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not start the executor");
         }
     }
-    numCycles = 0;
     return ok;
 }
 
 bool MDSReaderNS::Synchronise() {
-    currentTime = startTime + numCycles * period;
-#ifdef DEBUG
-    std::cout << "MDSReaderNS - Current time: " << currentTime << std::endl; 
-#endif   
-    for (uint32 i = 0u; i < numberOfNodeNames; i++) {
-        endNode[i] = !GetDataNode(i);
-    }
-    PublishTime();
-    if(AllNodesEnd() && !signalsEndedNotified)
-    {
-	signalsEndedNotified = true;
-//std::cout << "FINITO TUTTI" << std::endl;
-	notifySignalsEnded();
+    return SynchroniseConsumer(0u);
+}
+
+bool MDSReaderNS::SynchroniseConsumer(const uint32 consumerIdx) {
+    bool ok = (consumerIdx < numberOfConsumers);
+    if (ok) {
+        MDSReaderNSConsumer &consumer = consumers[consumerIdx];
+        UpdateCurrentTime(consumerIdx);
+        bool consumerEnded = true;
+        for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+            if (nodeConsumer[i] == consumerIdx) {
+                endNodeCycle[i] = !GetDataNode(i, consumer.currentTime);
+                consumerEnded = consumerEnded && endNodeCycle[i];
+            }
+        }
+        PublishTime(consumerIdx);
+        consumer.numCycles++;
+        //The messages are sent by the executor thread, here the pending notifications are only flagged. Consumers may run in different threads
+        bool notify = false;
+        if (endMutex.FastLock() == ErrorManagement::NoError) {
+            //endNode is read by AllNodesEnd() for all the consumers, so that it is only written under endMutex
+            bool nodeEnded = false;
+            for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+                if (nodeConsumer[i] == consumerIdx) {
+                    if (endNodeCycle[i] && (!endNode[i])) {
+                        nodeEnded = true;
+                    }
+                    endNode[i] = endNodeCycle[i];
+                }
+            }
+            if (nodeEnded) {
+                for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+                    if ((nodeConsumer[i] == consumerIdx) && (endNode[i]) && (nodeEndMessage[i] < nOfMessages)) {
+                        nodeEndPending[i] = true;
+                        notify = true;
+                    }
+                }
+            }
+            if (loopPlayback == 1u) {
+                if (consumerEnded) { //Rewind instead of ending. The SignalsEnded messages are never sent, the LoopMessages (if any) are sent instead
+                    for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+                        if (nodeConsumer[i] == consumerIdx) {
+                            lastSignalSample[i] = 0u;
+                            endNode[i] = false;
+                        }
+                    }
+                    consumer.numCycles = 0u;
+                    if (nOfLoopMessages > 0u) {
+                        loopPending = true;
+                        notify = true;
+                    }
+                }
+            }
+            else if (AllNodesEnd() && !signalsEndedNotified) {
+                signalsEndedNotified = true;
+                signalsEndedPending = true;
+                notify = true;
+            }
+            else {
+                if (!AllNodesEnd()) {
+                    signalsEndedNotified = false;
+                }
+            }
+            endMutex.FastUnLock();
+        }
+        if (notify) {
+            (void) notifySem.Post();
+        }
     }
-    else
-    {
-	if(!AllNodesEnd())
-	{
-	    signalsEndedNotified = false;
-	}
+    return ok;
+}
+
+ErrorManagement::ErrorType MDSReaderNS::Execute(ExecutionInfo &info) {
+    ErrorManagement::ErrorType err = ErrorManagement::NoError;
+    if (info.GetStage() == ExecutionInfo::MainStage) {
+        //Periodically wake up so that the executor can be stopped
+        (void) notifySem.Wait(NOTIFY_WAIT_TIMEOUT);
+        (void) notifySem.Reset();
+        bool signalsEnded = false;
+        bool looped = false;
+        if (endMutex.FastLock() == ErrorManagement::NoError) {
+            signalsEnded = signalsEndedPending;
+            signalsEndedPending = false;
+            looped = loopPending;
+            loopPending = false;
+            for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+                nodeEndNotify[i] = nodeEndPending[i];
+                nodeEndPending[i] = false;
+            }
+            endMutex.FastUnLock();
+        }
+        for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+            if (nodeEndNotify[i]) {
+                SendEndMessage(nodeEndMessage[i]);
+            }
+        }
+        if (signalsEnded) {
+            notifySignalsEnded();
+        }
+        if (looped) {
+            SendLoopMessages();
+        }
     }
-    numCycles++;
-    return true;
+    return err;
 }
 
-void MDSReaderNS::PublishTime() {
-    float64 auxFloat = currentTime * static_cast<float64>(1000000);
-    if (type[numberOfNodeNames] == UnsignedInteger32Bit) {
-        *reinterpret_cast<uint32 *>(&dataSourceMemory[offsets[numberOfNodeNames]]) = static_cast<uint32>(auxFloat);
+void MDSReaderNS::PublishTime(const uint32 consumerIdx) {
+    uint32 timeIdx = consumers[consumerIdx].timeSignalIdx;
+    float64 auxFloat = consumers[consumerIdx].currentTime * static_cast<float64>(1000000);
+    if (type[timeIdx] == UnsignedInteger32Bit) {
+        *reinterpret_cast<uint32 *>(&dataSourceMemory[offsets[timeIdx]]) = static_cast<uint32>(auxFloat);
     }
-    else if (type[numberOfNodeNames] == SignedInteger32Bit) {
-        //int32 auxInt = static_cast<int32>(auxFloat);
-        //MemoryOperationsHelper::Copy(reinterpret_cast<void *>(&dataSourceMemory[offsets[numberOfNodeNames]]), static_cast<void *>(&auxInt), 4u);
-        *reinterpret_cast<int32 *>(&dataSourceMemory[offsets[numberOfNodeNames]]) = static_cast<int32>(auxFloat);
+    else if (type[timeIdx] == SignedInteger32Bit) {
+        *reinterpret_cast<int32 *>(&dataSourceMemory[offsets[timeIdx]]) = static_cast<int32>(auxFloat);
     }
-    else if (type[numberOfNodeNames] == UnsignedInteger64Bit) {
-        uint32 auxIdx = offsets[numberOfNodeNames];
-        uint64 *ptr = reinterpret_cast<uint64 *>(&(dataSourceMemory[auxIdx]));
-        *ptr = static_cast<uint64>(auxFloat);
+    else if (type[timeIdx] == UnsignedInteger64Bit) {
+        *reinterpret_cast<uint64 *>(&dataSourceMemory[offsets[timeIdx]]) = static_cast<uint64>(auxFloat);
     }
-    else if (type[numberOfNodeNames] == SignedInteger64Bit) {
-        uint32 auxIdx = offsets[numberOfNodeNames];
-        char8 *ptr2 = &dataSourceMemory[auxIdx];
-        int64 *ptr = reinterpret_cast<int64 *>(ptr2);
-        *ptr = static_cast<int64>(auxFloat);
+    else if (type[timeIdx] == SignedInteger64Bit) {
+        *reinterpret_cast<int64 *>(&dataSourceMemory[offsets[timeIdx]]) = static_cast<int64>(auxFloat);
     }
     else {
 
@@ -602,6 +1049,85 @@ void MDSReaderNS::PublishTime() {
     return;
 }
 
+void MDSReaderNS::UpdateCurrentTime(const uint32 consumerIdx) {
+    MDSReaderNSConsumer &consumer = consumers[consumerIdx];
+    float64 previousTime = consumer.currentTime;
+    if (consumer.numCycles == 0u) {
+        consumer.startCounter = HighResolutionTimer::Counter();
+        consumer.currentTime = consumer.startTime;
+    }
+    else {
+        switch (timebaseMode) {
+        case 1u:
+            consumer.currentTime = GetClockSignalTime();
+            break;
+        case 2u:
+            consumer.currentTime = consumer.startTime
+                    + speedFactor * static_cast<float64>(HighResolutionTimer::Counter() - consumer.startCounter) * HighResolutionTimer::Period();
+            break;
+        case 3u:
+            consumer.currentTime = GetNextSampleTime(consumerIdx);
+            break;
+        default:
+            consumer.currentTime = consumer.startTime + consumer.numCycles * consumer.period;
+            break;
+        }
+    }
+    if ((consumer.numCycles > 0u) && (consumer.currentTime < previousTime)) { //Time went back: restart the search from the beginning of the nodes
+        for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+            if (nodeConsumer[i] == consumerIdx) {
+                lastSignalSample[i] = 0u;
+            }
+        }
+    }
+}
+
+float64 MDSReaderNS::GetClockSignalTime() const {
+    char8 *ptr = &dataSourceMemory[offsets[clockSignalIdx]];
+    float64 clockTime = 0.;
+    if (clockSignalType == Float64Bit) {
+        clockTime = *reinterpret_cast<float64 *>(ptr);
+    }
+    else if (clockSignalType == Float32Bit) {
+        clockTime = static_cast<float64>(*reinterpret_cast<float32 *>(ptr));
+    }
+    else if (clockSignalType == UnsignedInteger64Bit) {
+        clockTime = static_cast<float64>(*reinterpret_cast<uint64 *>(ptr)) / 1000000.;
+    }
+    else if (clockSignalType == SignedInteger64Bit) {
+        clockTime = static_cast<float64>(*reinterpret_cast<int64 *>(ptr)) / 1000000.;
+    }
+    else if (clockSignalType == UnsignedInteger32Bit) {
+        clockTime = static_cast<float64>(*reinterpret_cast<uint32 *>(ptr)) / 1000000.;
+    }
+    else if (clockSignalType == SignedInteger32Bit) {
+        clockTime = static_cast<float64>(*reinterpret_cast<int32 *>(ptr)) / 1000000.;
+    }
+    else {
+
+    }
+    return clockTime;
+}
+
+float64 MDSReaderNS::GetNextSampleTime(const uint32 consumerIdx) const {
+    bool found = false;
+    float64 currentTime = consumers[consumerIdx].currentTime;
+    float64 nextTime = currentTime + consumers[consumerIdx].period;
+    for (uint32 i = 0u; i < numberOfNodeNames; i++) {
+        if ((nodeConsumer[i] == consumerIdx) && (!endNode[i])) {
+            uint32 k;
+            for (k = lastSignalSample[i]; (k < numSignalSamples[i]) && (signalTimebase[i][k] <= currentTime); k++);
+            if (k < numSignalSamples[i]) {
+                if ((!found) || (signalTimebase[i][k] < nextTime)) {
+                    nextTime = signalTimebase[i][k];
+                    found = true;
+                }
+            }
+        }
+    }
+    return nextTime;
+}
+
 bool MDSReaderNS::AllNodesEnd() const {
     bool ret = true;
     if (endNode != NULL_PTR(bool *)) {
@@ -647,7 +1173,13 @@ const char8 *MDSReaderNS::GetBrokerName(StructuredDataI &data,
                                       const SignalDirection direction) {
     const char8* brokerName = "";
     if (direction == InputSignals) {
-        brokerName = "MemoryMapSynchronisedInputBroker";
+        brokerName = "MDSReaderNSInputBroker";
+    }
+    else if (timebaseMode == 1u) {
+        brokerName = "MemoryMapOutputBroker";
+    }
+    else {
+
     }
     return brokerName;
 }
@@ -655,20 +1187,37 @@ const char8 *MDSReaderNS::GetBrokerName(StructuredDataI &data,
 bool MDSReaderNS::GetInputBrokers(ReferenceContainer &inputBrokers,
                                 const char8* const functionName,
                                 void * const gamMemPtr) {
-    bool ok;
-    ReferenceT<MemoryMapSynchronisedInputBroker> broker("MemoryMapSynchronisedInputBroker");
-    ok = broker->Init(InputSignals, *this, functionName, gamMemPtr);
+    uint32 functionIdx = 0u;
+    bool ok = GetFunctionIndex(functionIdx, functionName);
+    uint32 consumerIdx = 0u;
+    if (ok) {
+        for (consumerIdx = 0u; (consumerIdx < numberOfConsumers) && (consumers[consumerIdx].functionIdx != functionIdx); consumerIdx++) {
+        }
+        ok = (consumerIdx < numberOfConsumers);
+    }
     if (ok) {
-        ok = inputBrokers.Insert(broker);
+        ReferenceT<MDSReaderNSInputBroker> broker("MDSReaderNSInputBroker");
+        ok = broker->Init(InputSignals, *this, functionName, gamMemPtr);
+        if (ok) {
+            broker->SetConsumer(this, consumerIdx);
+            ok = inputBrokers.Insert(broker);
+        }
     }
     return ok;
 }
 
-/*lint -e{715}  [MISRA C++ Rule 0-1-11], [MISRA C++ Rule 0-1-12]. Justification: InputBrokers are not supported. Function returns false irrespectively of the parameters.*/
 bool MDSReaderNS::GetOutputBrokers(ReferenceContainer &outputBrokers,
                                  const char8* const functionName,
                                  void * const gamMemPtr) {
-    return false;
+    bool ok = (timebaseMode == 1u);
+    if (ok) {
+        ReferenceT<MemoryMapOutputBroker> broker("MemoryMapOutputBroker");
+        ok = broker->Init(OutputSignals, *this, functionName, gamMemPtr);
+        if (ok) {
+            ok = outputBrokers.Insert(broker);
+        }
+    }
+    return ok;
 }
 
 bool MDSReaderNS::OpenTree() {
@@ -693,7 +1242,7 @@ bool MDSReaderNS::OpenTree() {
  * 1--> time found in a segment
  */
 
-bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
+bool MDSReaderNS::GetDataNode(const uint32 nodeNumber, const float64 currentTime) {
   
 //  std::cout << "GET DATA NODE " << nodeNumber << "  nElements: " << nElements[nodeNumber] << "Management: " << (int)dataManagement[nodeNumber] <<std::endl;  
   
@@ -703,7 +1252,7 @@ bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
 	      {
 		  for(uint32 i = 0; i < nElements[nodeNumber]; i++)
 		  {
-		      CopyValue(nodeNumber, i, signalData[nodeNumber][lastSignalSample[nodeNumber]*nElements[nodeNumber]+i]);
+		      CopyValue(nodeNumber, i, GetNodeValue(nodeNumber, lastSignalSample[nodeNumber], i));
 		  }
 		  (lastSignalSample[nodeNumber])++;
 		  return true;
@@ -737,11 +1286,11 @@ bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
 	    for(startIdx = lastSignalSample[nodeNumber]; startIdx < numSignalSamples[nodeNumber]-1 && signalTimebase[nodeNumber][startIdx+1] < currentTime; startIdx++);
 	    for(uint32 i = 0; i < nElements[nodeNumber]; i++)
 	    {
-		float64 interpValue = signalData[nodeNumber][startIdx*nElements[nodeNumber]+i] + (currentTime - signalTimebase[nodeNumber][startIdx])*
-		(signalData[nodeNumber][(startIdx+1)*nElements[nodeNumber]+i] - signalData[nodeNumber][startIdx*nElements[nodeNumber]+i])/(signalTimebase[nodeNumber][startIdx+1] - signalTimebase[nodeNumber][startIdx]);
+		float64 interpValue = GetNodeValue(nodeNumber, startIdx, i) + (currentTime - signalTimebase[nodeNumber][startIdx])*
+		(GetNodeValue(nodeNumber, startIdx+1, i) - GetNodeValue(nodeNumber, startIdx, i))/(signalTimebase[nodeNumber][startIdx+1] - signalTimebase[nodeNumber][startIdx]);
 		CopyValue(nodeNumber, i, interpValue);
 // std::cout << "startIdx: " << startIdx << "   Current time: " << currentTime << "Current Index: " << startIdx*nElements[nodeNumber]+i << 
-// "Val1: "<< signalData[nodeNumber][startIdx*nElements[nodeNumber]+i] <<
+// "Val1: "<< GetNodeValue(nodeNumber, startIdx, i) <<
 // "Interp Val: " << interpValue <<std::endl;
 	    }
 	    lastSignalSample[nodeNumber] = startIdx;
@@ -771,7 +1320,7 @@ bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
 	    {
 		for(uint32 i = 0; i < nElements[nodeNumber]; i++)
 		{
-		  CopyValue(nodeNumber, i, signalData[nodeNumber][startIdx*nElements[nodeNumber]+i]);
+		  CopyValue(nodeNumber, i, GetNodeValue(nodeNumber, startIdx, i));
 		}
 	    }
 	    else
@@ -780,14 +1329,14 @@ bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
 		{
 		    for(uint32 i = 0; i < nElements[nodeNumber]; i++)
 		    {
-			CopyValue(nodeNumber, i, signalData[nodeNumber][(startIdx+1)*nElements[nodeNumber]+i]);
+			CopyValue(nodeNumber, i, GetNodeValue(nodeNumber, startIdx+1, i));
 		    }
 		}
 		else
 		{
 		    for(uint32 i = 0; i < nElements[nodeNumber]; i++)
 		    {
-		      CopyValue(nodeNumber, i, signalData[nodeNumber][startIdx*nElements[nodeNumber]+i]);
+		      CopyValue(nodeNumber, i, GetNodeValue(nodeNumber, startIdx, i));
 		    }
 		}
 	    }
@@ -801,7 +1350,8 @@ bool MDSReaderNS::GetDataNode(const uint32 nodeNumber) {
     
  
 //lint -e{613} Possible use of null pointer. Not possible. If initialisation fails this function is not called.
-void MDSReaderNS::CopyValue(const uint32 idxNumber, uint32 element, float64 value) {
+void MDSReaderNS::CopyValue(const uint32 nodeNumber, uint32 element, float64 value) {
+    uint32 idxNumber = nodeSignalIdx[nodeNumber];
 
     if (type[idxNumber] == UnsignedInteger8Bit) {
         CopyValueTemplate<uint8>(idxNumber, element, value);
@@ -840,8 +1390,88 @@ void MDSReaderNS::CopyValue(const uint32 idxNumber, uint32 element, float64 valu
 }
 
 
+bool MDSReaderNS::LoadNodeData(const uint32 idx) {
+    bool ok = true;
+    bool cached = false;
+    uint32 dataSize = 0u;
+    StreamString key;
+    //Nodes with the same expressions (e.g. read by different Functions) share the same data
+    for (uint32 j = 0u; (j < idx) && (nodeDataOwner[idx] == idx); j++) {
+        if ((nodeDataOwner[j] == j) && (dataExpr[j] == dataExpr[idx]) && (timebaseExpr[j] == timebaseExpr[idx]) && (useColumnOrder[j] == useColumnOrder[idx])) {
+            nodeDataOwner[idx] = j;
+        }
+    }
+    bool shared = (nodeDataOwner[idx] != idx);
+    if (shared) {
+        uint32 owner = nodeDataOwner[idx];
+        signalData[idx] = signalData[owner];
+        signalTimebase[idx] = signalTimebase[owner];
+        nElements[idx] = nElements[owner];
+        numSignalSamples[idx] = numSignalSamples[owner];
+        nodeSamplingTime[idx] = nodeSamplingTime[owner];
+        sampleStride[idx] = sampleStride[owner];
+        elementStride[idx] = elementStride[owner];
+    }
+    else if (cacheDirectory.Size() > 0u) {
+        char8 shotStr[32];
+        (void) snprintf(shotStr, sizeof(shotStr), "%d", shotNumber);
+        key = treeName;
+        key += "\n";
+        key += shotStr;
+        key += "\n";
+        key += dataExpr[idx].Buffer();
+        key += "\n";
+        key += timebaseExpr[idx].Buffer();
+        key += "\n";
+        key += useColumnOrder[idx] ? "1" : "0";
+        cached = nodeCache[idx].Open(cacheDirectory, key, treeStamp);
+    }
+    else {
+
+    }
+    if ((!cached) && (!shared)) {
+        uint32 timebaseSize = 0u;
+        float64 *data = NULL_PTR(float64 *);
+        float64 *timebase = NULL_PTR(float64 *);
+        ok = GetNodeDataAndSamplingTime(idx, data, nElements[idx], timebase, numSignalSamples[idx], nodeSamplingTime[idx], dataSize, timebaseSize);
+        signalData[idx] = data;
+        signalTimebase[idx] = timebase;
+        if (ok && (cacheDirectory.Size() > 0u)) {
+            cached = nodeCache[idx].Store(cacheDirectory, key, treeStamp, signalData[idx], dataSize, nElements[idx], numSignalSamples[idx],
+                                          signalTimebase[idx], timebaseSize);
+            if (cached) { //From now on use the shared mapped copy
+                delete[] signalData[idx];
+                delete[] signalTimebase[idx];
+            }
+        }
+    }
+    if (cached) {
+        signalData[idx] = nodeCache[idx].GetData();
+        signalTimebase[idx] = nodeCache[idx].GetTimebase();
+        nElements[idx] = nodeCache[idx].GetNumberOfElements();
+        numSignalSamples[idx] = nodeCache[idx].GetNumberOfSamples();
+        dataSize = nodeCache[idx].GetDataSize();
+        uint32 timebaseSize = nodeCache[idx].GetTimebaseSize();
+        ok = (timebaseSize > 0u);
+        if (ok) {
+            nodeSamplingTime[idx] = (signalTimebase[idx][timebaseSize - 1u] - signalTimebase[idx][0]) / timebaseSize;
+        }
+    }
+    if (ok && (!shared)) { //Column order data is not transposed: the samples of each element are contiguous
+        if (useColumnOrder[idx]) {
+            sampleStride[idx] = 1u;
+            elementStride[idx] = (nElements[idx] > 0u) ? (dataSize / nElements[idx]) : 0u;
+        }
+        else {
+            sampleStride[idx] = nElements[idx];
+            elementStride[idx] = 1u;
+        }
+    }
+    return ok;
+}
+
 bool MDSReaderNS::GetNodeDataAndSamplingTime(const uint32 idx, float64 * &data, uint32 &numElements, float64 * &timebase, uint32 &numSamples,
-            float64 &tDiff) const
+            float64 &tDiff, uint32 &dataSize, uint32 &timebaseSize) const
 {
     int nDims;
     try {
@@ -868,16 +1498,9 @@ std::cout << "EvalData: " << evalData << std::endl;
 
 //std::cout << "NumElements: " << numElements << std::endl;
 //std::cout << "NumSamples: " << numSamples << std::endl;
-	    float64 *currData = evalData->getDoubleArray(&dataSamples);
-	    data = new float64[dataSamples];
-	    for(uint32 i = 0; i < numSamples; i++)
-	    {
-		for(uint32 j = 0; j < numElements; j++)
-		{
-		    data[i*numElements + j] = currData[j*numSamples+i];
-		}
-	    }
-	    delete [] currData;
+	    //Kept in column order, see GetNodeValue()
+	    data = evalData->getDoubleArray(&dataSamples);
+	    dataSize = dataSamples;
 	}
 	else
 	{
@@ -886,6 +1509,7 @@ std::cout << "EvalData: " << evalData << std::endl;
 	    for(int i = 1; i < nDims; i++)
 		numElements *= shape[i];
 	    data = evalData->getDoubleArray(&dataSamples);
+	    dataSize = dataSamples;
 	}
          MDSplus::deleteData(evalData);
     }catch(MDSplus::MdsException &exc)
@@ -898,6 +1522,7 @@ std::cout << "EvalData: " << evalData << std::endl;
          MDSplus::Data *nodeTimebase = MDSplus::compile(timebaseExpr[idx].Buffer(), tree);
 	 MDSplus::Data *dataTimebase = nodeTimebase->data();
         timebase = dataTimebase->getDoubleArray(&dimSamples);
+        timebaseSize = dimSamples;
 //std::cout << "Timebase: " << dataTimebase << std::endl;
         MDSplus::deleteData(dataTimebase);
         MDSplus::deleteData(nodeTimebase);
@@ -916,13 +1541,31 @@ void MDSReaderNS::notifySignalsEnded()
 {
     for(uint32 i = 0; i < nOfMessages; i++)
     {
-        if(signalsEndedMsg[i].IsValid())
-	{
-            if (!MessageI::SendMessage(signalsEndedMsg[i], this)) {
-                StreamString destination = signalsEndedMsg[i]->GetDestination();
-                StreamString function = signalsEndedMsg[i]->GetFunction();
-                REPORT_ERROR(ErrorManagement::FatalError, "Could not send TreeOpenedOK message to %s [%s]", destination.Buffer(), function.Buffer());
-            }
+        if(!isNodeEndMessage[i])
+        {
+            SendEndMessage(i);
+        }
+    }
+}
+
+void MDSReaderNS::SendLoopMessages() {
+    for (uint32 i = 0u; i < nOfLoopMessages; i++) {
+        if (!MessageI::SendMessage(loopMsg[i], this)) {
+            StreamString destination = loopMsg[i]->GetDestination();
+            StreamString function = loopMsg[i]->GetFunction();
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not send message to %s [%s]", destination.Buffer(), function.Buffer());
+        }
+    }
+}
+
+void MDSReaderNS::SendEndMessage(const uint32 msgIdx)
+{
+    if(signalsEndedMsg[msgIdx].IsValid())
+    {
+        if (!MessageI::SendMessage(signalsEndedMsg[msgIdx], this)) {
+            StreamString destination = signalsEndedMsg[msgIdx]->GetDestination();
+            StreamString function = signalsEndedMsg[msgIdx]->GetFunction();
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not send message to %s [%s]", destination.Buffer(), function.Buffer());
         }
     }
 }
@@ -13,7 +13,12 @@
 /*                        Project header includes                            */
 /*---------------------------------------------------------------------------*/
 #include "DataSourceI.h"
+#include "EmbeddedServiceMethodBinderI.h"
+#include "EventSem.h"
+#include "FastPollingMutexSem.h"
+#include "MDSReaderNSCache.h"
 #include "MessageI.h"
+#include "SingleThreadService.h"
 #include "StreamString.h"
 
 /*---------------------------------------------------------------------------*/
@@ -22,6 +27,42 @@
 
 namespace MARTe {
 
+/**
+ * @brief Playback state of each Function (consumer) reading from a MDSReaderNS.
+ */
+struct MDSReaderNSConsumer {
+    /**
+     * Index of the Function.
+     */
+    uint32 functionIdx;
+
+    /**
+     * Index of the time signal read by the Function.
+     */
+    uint32 timeSignalIdx;
+
+    /**
+     * Cycle period and time of the first cycle (s).
+     */
+    float64 period;
+    float64 startTime;
+
+    /**
+     * Playback time (s) of the current cycle.
+     */
+    float64 currentTime;
+
+    /**
+     * Number of cycles executed.
+     */
+    uint64 numCycles;
+
+    /**
+     * HighResolutionTimer counter at the first cycle (TimebaseMode 2).
+     */
+    uint64 startCounter;
+};
+
 /**
  * @brief MDSReaderNS is a data source which allows to read data from segmented and non segmented nodes a MDSplus tree.
  * @details MDSReaderNS is an input data source which takes data from MDSPlus nodes (as many as desired) and publishes it on a real time application.
@@ -32,8 +73,29 @@ namespace MARTe {
  * <li>Simulation, where the inputs are read from a pulse file.</li>
  * <li>Reference waveforms, normally defined in non segmented nodes as a signal defining few X and Y points and assuming interpolated values in between.</li>
  * </ul>
- * The timebase of MDSReaderNS data source is specified by Frequency and StartTime values. The last declared signal is the output time expressed in 
- * microseconds (supported types are int32, uint32, int64, uint64). At every cycle the the oputput time is updated as 1E6 * (StartTime + cycleCount/frequency)
+ * The timebase of MDSReaderNS data source is specified by Frequency and StartTime values. The signals without DataExpr (other than the ClockSignal)
+ * are output times expressed in microseconds (supported types are int32, uint32, int64, uint64).
+ *
+ * More than one Function (e.g. GAMs in threads running at different rates) can read from the same MDSReaderNS. Each Function is a consumer with its own
+ * playback time: it shall read exactly one time signal, whose optional Frequency and StartTime parameters override the ones of the data source, and the
+ * node signals it reads are updated at its own cycles. A node signal can be read by a single Function, but the node signals with the same DataExpr,
+ * TimebaseExpr and UseColumnOrder share the data loaded from the tree, so that the same channel replayed at different rates is read and stored only once.
+ * If a single Function reads from the data source it may omit the (single) time signal.
+ *
+ * How the playback time advances at every cycle is selected by the optional TimebaseMode parameter:
+ * <ul>
+ * <li>0 --> Fixed period (default). The output time is updated as 1E6 * (StartTime + cycleCount/frequency).</li>
+ * <li>1 --> Input signal. The time is written by a GAM into the signal named by ClockSignal (read by all the consumers).
+ * float32/float64 clock signals are expressed in seconds, int32/uint32/int64/uint64 clock signals in microseconds. StartTime is used until the first value is written.</li>
+ * <li>2 --> Speed multiplier. The time is StartTime + SpeedFactor * (wall-clock time elapsed since the first cycle), e.g. SpeedFactor = 10 replays at 10x real time.</li>
+ * <li>3 --> Free-run. At every cycle the time jumps to the next sample found in any of the node timebases, so that the replay runs as fast as the
+ * real-time thread and each recorded sample is published exactly once.</li>
+ * </ul>
+ * When the playback time goes backwards (TimebaseMode 1) the node cursors are rewound.
+ *
+ * If the optional CacheDirectory parameter is set, the arrays evaluated from DataExpr and TimebaseExpr are stored in a memory-mapped cache file
+ * (see MDSReaderNSCache) keyed by tree, shot, expressions and UseColumnOrder, and reused by later runs as long as the tree files are not modified.
+ * The cache is disabled if the tree files cannot be found locally through the <treename>_path environment variable.
  * DataManagement can take the following values:
  * <ul>
  * <li>0 --> MDSReaderNS takes the data from the tree as it is (raw). In this configuration, the frequency/numberOfElements must be the same than the node sampling frequency.</li>
@@ -46,6 +108,12 @@ namespace MARTe {
  * The MDSReaderNS can handle as many nodes as desired. Each node can have their on data type, maximum number of segments, elements per segment and sampling time. When the
  * end of a node is reached the data of the corresponding node is filled with 0 and the data source continuous running until all nodes reach the end.
  *
+ * The Messages declared in the (optional) first child container other than LoopMessages are sent when all the nodes reach the end. A node may declare an EndMessage, which is then sent
+ * when that node reaches the end (and not when all the nodes end). The real-time threads only flag the end of data: the messages are sent by a SingleThreadService
+ * (whose affinity and stack are set by CPUs and StackSize), so that the message handling never delays a real-time cycle.
+ * If LoopPlayback = 1 the cursors of a consumer are rewound to the beginning (and its playback time to its StartTime) as soon as all its nodes end. The
+ * data never ends, so the messages of the first container are not sent at a rewind: the Messages of the (optional) LoopMessages container are sent instead.
+ *
  * The supported types for the nodes are:
  * <ul>
  * <li>uint8</li>
@@ -78,6 +146,13 @@ namespace MARTe {
  *     ShotNumber = 1 //Compulsory. 0 --> last shot number (to use 0 shotid.sys must exist)
  *     Frequency = 1000 // in Hz. Is the cycle time of the real time application. 
  *     StartTime = 0 // in s. Time of the first iteration.
+ *     TimebaseMode = 0 // Optional. 0 (fixed period, default), 1 (input signal), 2 (speed multiplier) or 3 (free-run).
+ *     SpeedFactor = 10 // Compulsory only if TimebaseMode = 2. Must be positive.
+ *     ClockSignal = "ReplayTime" // Compulsory only if TimebaseMode = 1. Name of the signal (written by a GAM) carrying the playback time.
+ *     CacheDirectory = "/tmp/mdsreader" // Optional. Directory of the evaluated expressions cache. If not set the cache is disabled.
+ *     LoopPlayback = 0 // Optional. 1 to rewind (instead of ending) when the data ends. Not applicable to TimebaseMode = 1. Default 0.
+ *     CPUs = 0xff // Optional. Affinity of the thread sending the end of data messages. Default 0xff.
+ *     StackSize = 1048576 // Optional. Stack size of the thread sending the end of data messages. Default THREADS_DEFAULT_STACKSIZE * 4.
  *
  *     Signals = {
  *         S_uint8 = {
@@ -86,15 +161,56 @@ namespace MARTe {
  *             NumberOfElements = 32 //Dimension of the data sample. Must be consistent with the dimensionality of the MDSplus  data item. 
  * 	       Type = uint8   //Output Data type
  *             DataManagement = 0 //could be 0, 1 or 2
+ *             EndMessage = "S_uint8_Ended" // Optional. Name of the Message sent when this node ends.
  *         }
  *         ....
  *         ....
  *         ....
+ *         Time = { // The output time
+ *             Type = uint64
+ *         }
+ *         S_uint8_10k = { // Same data of S_uint8 (loaded only once) read by another Function
+ *             DataExpr = "S_uint8"
+ *             TimeExpr = "dim_of(S_uint8)"
+ *             NumberOfElements = 32
+ *             Type = uint8
+ *             DataManagement = 1
+ *         }
+ *         Time_10k = { // The output time of the other Function
+ *             Type = uint64
+ *             Frequency = 10000 // Optional. Default the data source Frequency.
+ *             StartTime = 0 // Optional. Default the data source StartTime.
+ *         }
+ *         ReplayTime = { // Only if TimebaseMode = 1. Written by a GAM, read at the following cycle.
+ *             Type = float64
+ *         }
+ *     }
+ *     +Messages = { // Optional.
+ *         Class = ReferenceContainer
+ *         +SignalsEnded = {
+ *             Class = Message
+ *             Destination = StateMachine
+ *             Function = STOP
+ *             Mode = ExpectsReply
+ *         }
+ *         +S_uint8_Ended = {
+ *             Class = Message
+ *             Destination = Logger
+ *             Function = NodeEnded
+ *         }
+ *     }
+ *     +LoopMessages = { // Optional. Only if LoopPlayback = 1. Sent at every rewind.
+ *         Class = ReferenceContainer
+ *         +Rewound = {
+ *             Class = Message
+ *             Destination = Logger
+ *             Function = PlaybackRewound
+ *         }
  *     }
  * }
  * </pre>
  */
-class MDSReaderNS: public DataSourceI {
+class MDSReaderNS: public DataSourceI, public EmbeddedServiceMethodBinderI {
 //TODO Add the macro DLL_API to the class declaration (i.e. class DLL_API MDSReaderNS)
 public:
     CLASS_REGISTER_DECLARATION()
@@ -110,12 +226,26 @@ MDSReaderNS    ();
     virtual ~MDSReaderNS();
 
     /**
-     * @brief Copy data from the tree nodes to the dataSourceMemory
-     * @details When a node does not have more data to retrieve the dataSourceMemory is filled with 0.
-     * @return true if all nodes read return false.
+     * @brief Synchronises the first consumer. See SynchroniseConsumer.
+     * @return true.
      */
     virtual bool Synchronise();
 
+    /**
+     * @brief Copy data from the tree nodes read by a consumer to the dataSourceMemory
+     * @details Called by the MDSReaderNSInputBroker of the Function. When a node does not have more data to retrieve the dataSourceMemory is filled with 0.
+     * @param[in] consumerIdx the consumer index.
+     * @return true if consumerIdx is valid.
+     */
+    bool SynchroniseConsumer(const uint32 consumerIdx);
+
+    /**
+     * @brief Sends the end of data messages flagged by the real-time threads.
+     * @details Waits (MainStage) for a notification from SynchroniseConsumer and sends the node EndMessages and/or the messages of all nodes ended.
+     * @return ErrorManagement::NoError.
+     */
+    virtual ErrorManagement::ErrorType Execute(ExecutionInfo &info);
+
     /**
      * @brief Reads, checks and initialises the DataSource parameters
      * @details Load from a configuration file the DataSource parameters.
@@ -180,15 +310,15 @@ MDSReaderNS    ();
 
     /**
      * @brief See DataSourceI::GetBrokerName.
-     * @details Only InputSignals are supported if TimebaseMode is 0 (FixedFrequency).
-     * @return MemoryMapSynchronisedInputBroker
+     * @details OutputSignals are supported only if TimebaseMode is 1 (the clock signal).
+     * @return MDSReaderNSInputBroker for InputSignals, MemoryMapOutputBroker for the clock signal.
      */
     virtual const char8 *GetBrokerName(StructuredDataI &data,
             const SignalDirection direction);
 
     /**
      * @brief See DataSourceI::GetInputBrokers.
-     * @details adds a MemoryMapSynchronisedInputBroker instance to the inputBrokers.
+     * @details adds a MDSReaderNSInputBroker instance, bound to the consumer of the Function, to the inputBrokers.
      */
     virtual bool GetInputBrokers(ReferenceContainer &inputBrokers,
             const char8* const functionName,
@@ -196,7 +326,8 @@ MDSReaderNS    ();
 
     /**
      * @brief See DataSourceI::GetOutputBrokers.
-     * @return false 
+     * @details adds a MemoryMapOutputBroker instance to the outputBrokers if TimebaseMode is 1.
+     * @return false if TimebaseMode is not 1.
      */
     virtual bool GetOutputBrokers(ReferenceContainer &outputBrokers,
             const char8* const functionName,
@@ -214,34 +345,68 @@ private:
      * @brief First determine the topology of the chunk of data to be read (i.e if there is enough data in the node, if the data has holes)
      * end then decides how to copy the data.
      * @param[in] nodeNumber node number to be copied to the dataSourceMemory.
+     * @param[in] currentTime the playback time of the consumer reading the node.
      * @return true if node data can be copied. false if is the end of the node
      */
-    bool GetDataNode(const uint32 nodeNumber);
+    bool GetDataNode(const uint32 nodeNumber, const float64 currentTime);
+
+    /**
+     * @brief copy the time internally generated for a consumer to the dataSourceMemory.
+     */
+    void PublishTime(const uint32 consumerIdx);
 
     /**
-     * @brief copy the time internally generated to the dataSourceMemory.
+     * @brief Computes the currentTime of a consumer for this cycle according to the TimebaseMode.
+     * @details Rewinds the cursors of the consumer nodes if the playback time went backwards.
      */
-    void PublishTime();
+    void UpdateCurrentTime(const uint32 consumerIdx);
+
+    /**
+     * @brief Reads the playback time (in seconds) from the clock signal written by a GAM (TimebaseMode 1).
+     */
+    float64 GetClockSignalTime() const;
+
+    /**
+     * @brief Gets the first sample time of the consumer nodes later than the consumer currentTime (TimebaseMode 3).
+     * @return the next sample time or currentTime + period if no more samples are available.
+     */
+    float64 GetNextSampleTime(const uint32 consumerIdx) const;
 
     /**
      * @brief Calculates values, timebase, numSamples and the (average) period
+     * @param[out] dataSize the number of values in data.
+     * @param[out] timebaseSize the number of values in timebase.
      * @return true on succeed.
      */
     bool GetNodeDataAndSamplingTime(const uint32 idx, float64 * &data, uint32 &numElements, float64 * &timebase, uint32 &numSamples,
-            float64 &tDiff) const;
+            float64 &tDiff, uint32 &dataSize, uint32 &timebaseSize) const;
+
+    /**
+     * @brief Loads the data and timebase of a node, either from the cache or evaluating the expressions (and then storing them in the cache).
+     * @return true on succeed.
+     */
+    bool LoadNodeData(const uint32 idx);
+
+    /**
+     * @brief Gets an element of a node sample, for both row order (samples contiguous) and column order (elements contiguous) data.
+     * @param[in] nodeNumber the node.
+     * @param[in] sample the sample index.
+     * @param[in] element the element index within the sample.
+     */
+    inline float64 GetNodeValue(const uint32 nodeNumber, const uint32 sample, const uint32 element) const;
 
     /**
      * @brief Copy the same value as many times as indicated.
      * @details this function decides the type of data to copy and then calls the MDSReaderNS::CopyTheSameValue()
-     * @param[in] idxNumber is the node number from which the data must be copied.
+     * @param[in] nodeNumber is the node number from which the data must be copied.
      * @param[in] numberOfTimes how many samples must be copied.
      * @param[in] samplesOffset indicates how many samples has already copied.
      */
-    void CopyValue(const uint32 idxNumber, uint32 element, float64 value);
+    void CopyValue(const uint32 nodeNumber, uint32 element, float64 value);
 
     /**
      * @brief Template functions which actually performs the copy
-     * @param[in] idxNumber is the node number from which the data must be copied.
+     * @param[in] idxNumber is the signal index of the node from which the data must be copied.
      * @param[in] numberOfTimes how many samples must be copied.
      * @param[in] samplesOffset indicates how many samples has already copied.
      */
@@ -262,8 +427,21 @@ private:
 
     bool AllNodesEnd() const;
 
-    
+    /**
+     * @brief Sends the messages not declared as EndMessage of a node. Called by the executor.
+     */
     void notifySignalsEnded();
+
+    /**
+     * @brief Sends a message of the Messages container. Called by the executor.
+     */
+    void SendEndMessage(const uint32 msgIdx);
+
+    /**
+     * @brief Sends the messages of the LoopMessages container. Called by the executor.
+     */
+    void SendLoopMessages();
+
     /**
      * The name of the MDSplus tree to be opened.
      */
@@ -292,14 +470,21 @@ private:
     uint32 numberOfNodeNames;
 
     /**
-     * The number of input signals.
+     * The Functions reading from the data source.
      */
-    uint32 nOfInputSignals;
+    MDSReaderNSConsumer *consumers;
+    uint32 numberOfConsumers;
 
     /**
-     * The number of input on each function.
+     * Signal index and consumer of each node.
      */
-    uint32 nOfInputSignalsPerFunction;
+    uint32 *nodeSignalIdx;
+    uint32 *nodeConsumer;
+
+    /**
+     * Index of the node whose data (signalData, signalTimebase) is used. Different from the node index if the data is shared with another node.
+     */
+    uint32 *nodeDataOwner;
 
 
     uint32 *byteSizeSignals;
@@ -344,18 +529,8 @@ private:
      */
     uint32 *nElements;
 
-     /**
-     * Time in seconds. It indicates the time of each sample. At the beginning of each cycle currentTime = time.
-     */
-    float64 currentTime;
-
-     /**
-     * Total number of cyccles.
-     */
-    uint64 numCycles;
-
     /**
-     * Time increment between Synchronisations. It is he inverse of frequency;
+     * Default time increment between Synchronisations. It is he inverse of frequency;
      */
     float64 period;
 
@@ -389,11 +564,57 @@ private:
 
  
     bool *endNode;
+
+    /**
+     * End of data of each node at the current cycle, written by its consumer and copied into endNode under endMutex.
+     */
+    bool *endNodeCycle;
     float64 *nodeSamplingTime;
 ///GABRIELE    
-    int timebaseMode; //Not used now
-    float64 **signalData;
-    float64 **signalTimebase;
+    /**
+     * How the playback time advances.
+     * 0 --> fixed period
+     * 1 --> input (clock) signal
+     * 2 --> speed multiplier of the wall-clock time
+     * 3 --> free-run (next sample)
+     */
+    uint8 timebaseMode;
+
+    /**
+     * Playback speed with respect to the wall-clock time (TimebaseMode 2).
+     */
+    float64 speedFactor;
+
+    /**
+     * Name, index and type of the signal carrying the playback time (TimebaseMode 1).
+     */
+    StreamString clockSignalName;
+    uint32 clockSignalIdx;
+    TypeDescriptor clockSignalType;
+
+    /**
+     * Directory of the evaluated expressions cache. Empty if the cache is not used.
+     */
+    StreamString cacheDirectory;
+
+    /**
+     * Stamp of the tree files, used to invalidate the cache entries.
+     */
+    uint64 treeStamp;
+
+    /**
+     * Cache entries for each node. When mapped, signalData and signalTimebase point inside the entry.
+     */
+    MDSReaderNSCache *nodeCache;
+
+    /**
+     * Distance in signalData between consecutive samples and between consecutive elements of a sample.
+     * Column order data is used as it is, instead of being transposed, since only a couple of samples are read at every cycle.
+     */
+    uint32 *sampleStride;
+    uint32 *elementStride;
+    const float64 **signalData;
+    const float64 **signalTimebase;
     uint32 *numSignalSamples;
     /**
      * hold the last signalSample considered in output generation where the t was found. It is used for optimization since the time could not go back.
@@ -405,6 +626,56 @@ private:
     ReferenceT<Message> *signalsEndedMsg;
     uint32 nOfMessages;
     bool signalsEndedNotified;
+
+    /**
+     * The messages to send when the playback is rewound (LoopPlayback = 1).
+     */
+    ReferenceT<Message> *loopMsg;
+    uint32 nOfLoopMessages;
+
+    /**
+     * Notifications flagged by the real-time threads and not yet sent by the executor.
+     */
+    bool signalsEndedPending;
+    bool loopPending;
+    bool *nodeEndPending;
+
+    /**
+     * Notifications being sent by the executor.
+     */
+    bool *nodeEndNotify;
+
+    /**
+     * True for the messages declared as EndMessage of a node.
+     */
+    bool *isNodeEndMessage;
+
+    /**
+     * Index of the EndMessage of each node. nOfMessages if not declared.
+     */
+    uint32 *nodeEndMessage;
+
+    /**
+     * 1 if the playback is rewound when all the nodes of a consumer end.
+     */
+    uint8 loopPlayback;
+
+    /**
+     * The thread sending the end of data messages, its affinity and stack size.
+     */
+    SingleThreadService executor;
+    uint32 cpuMask;
+    uint32 stackSize;
+
+    /**
+     * Posted by the real-time threads when a notification is pending.
+     */
+    EventSem notifySem;
+
+    /**
+     * Protects the end of data flags, shared by the consumers (which may run in different threads) and by the executor.
+     */
+    FastPollingMutexSem endMutex;
     bool *useColumnOrder;
 
 };
@@ -413,6 +684,10 @@ private:
 /*---------------------------------------------------------------------------*/
 /*                        Inline method definitions                          */
 /*---------------------------------------------------------------------------*/
+float64 MDSReaderNS::GetNodeValue(const uint32 nodeNumber, const uint32 sample, const uint32 element) const {
+    return signalData[nodeNumber][(sample * sampleStride[nodeNumber]) + (element * elementStride[nodeNumber])];
+}
+
 template<typename T>
 void MDSReaderNS::CopyValueTemplate(uint32 idxNumber, uint32 element, float64 value) {
     T *ptr = reinterpret_cast<T *>(&dataSourceMemory[offsets[idxNumber]]);
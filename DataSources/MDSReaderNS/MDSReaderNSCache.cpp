@@ -0,0 +1,312 @@
+/**
+ * @file MDSReaderNSCache.cpp
+ * @brief Source file for class MDSReaderNSCache
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for
+ * the class MDSReaderNSCache (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+#include "AdvancedErrorManagement.h"
+#include "MDSReaderNSCache.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+static const uint32 CACHE_MAGIC = 0x4D445343u; // "MDSC"
+static const uint32 CACHE_VERSION = 2u; // 2: column order data is stored untransposed
+
+/**
+ * Fixed header at the beginning of each cache file. Followed by the key (padded to 8 bytes), the data and the timebase.
+ */
+struct MDSReaderNSCacheHeader {
+    uint32 magic;
+    uint32 version;
+    uint64 treeStamp;
+    uint32 keySize;
+    uint32 numberOfElements;
+    uint32 numberOfSamples;
+    uint32 dataSize;
+    uint32 timebaseSize;
+    uint32 padding;
+};
+
+static uint64 HashBytes(uint64 hash, const void * const buffer, const uint64 size) {
+    const uint8 *bytes = reinterpret_cast<const uint8 *>(buffer);
+    for (uint64 i = 0u; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static const uint64 HASH_SEED = 0xCBF29CE484222325ull;
+
+static uint64 PaddedKeySize(const uint64 keySize) {
+    return (keySize + 7u) & ~static_cast<uint64>(7u);
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+MDSReaderNSCache::MDSReaderNSCache() {
+    mappedMemory = NULL_PTR(char8 *);
+    mappedSize = 0u;
+    data = NULL_PTR(const float64 *);
+    timebase = NULL_PTR(const float64 *);
+    dataSize = 0u;
+    numberOfElements = 0u;
+    numberOfSamples = 0u;
+    timebaseSize = 0u;
+}
+
+MDSReaderNSCache::~MDSReaderNSCache() {
+    Close();
+}
+
+void MDSReaderNSCache::Close() {
+    if (mappedMemory != NULL_PTR(char8 *)) {
+        (void) munmap(mappedMemory, mappedSize);
+        mappedMemory = NULL_PTR(char8 *);
+    }
+    mappedSize = 0u;
+    data = NULL_PTR(const float64 *);
+    timebase = NULL_PTR(const float64 *);
+}
+
+bool MDSReaderNSCache::GetTreeStamp(const StreamString &treeName, const int32 shotNumber, uint64 &stamp) {
+    char8 lowerName[256];
+    uint32 nameLen = static_cast<uint32>(treeName.Size());
+    bool ok = (nameLen > 0u) && (nameLen < 200u);
+    if (ok) {
+        for (uint32 i = 0u; i <= nameLen; i++) {
+            lowerName[i] = static_cast<char8>(tolower(treeName.Buffer()[i]));
+        }
+    }
+    const char8 *treePath = NULL_PTR(const char8 *);
+    if (ok) {
+        char8 envName[256];
+        (void) snprintf(envName, sizeof(envName), "%s_path", lowerName);
+        treePath = getenv(envName);
+        if (treePath == NULL_PTR(const char8 *)) {
+            (void) snprintf(envName, sizeof(envName), "%s_path", treeName.Buffer());
+            treePath = getenv(envName);
+        }
+        ok = (treePath != NULL_PTR(const char8 *));
+    }
+    bool found = false;
+    if (ok) {
+        char8 shotStr[32];
+        if (shotNumber == -1) {
+            (void) snprintf(shotStr, sizeof(shotStr), "model");
+        }
+        else {
+            (void) snprintf(shotStr, sizeof(shotStr), "%03d", shotNumber);
+        }
+        //The path may be a list of directories separated by ';'. Remote (host::path) entries cannot be checked.
+        const char8 *dirStart = treePath;
+        while ((!found) && (*dirStart != '\0')) {
+            const char8 *dirEnd = strchr(dirStart, ';');
+            uint32 dirLen = (dirEnd != NULL_PTR(const char8 *)) ? static_cast<uint32>(dirEnd - dirStart) : static_cast<uint32>(strlen(dirStart));
+            if ((dirLen > 0u) && (dirLen < 1024u)) {
+                char8 dir[1024];
+                (void) memcpy(dir, dirStart, dirLen);
+                dir[dirLen] = '\0';
+                if (strstr(dir, "::") == NULL_PTR(char8 *)) {
+                    char8 treeFile[1400];
+                    char8 dataFile[1400];
+                    struct stat treeStat;
+                    struct stat dataStat;
+                    (void) snprintf(treeFile, sizeof(treeFile), "%s/%s_%s.tree", dir, lowerName, shotStr);
+                    (void) snprintf(dataFile, sizeof(dataFile), "%s/%s_%s.datafile", dir, lowerName, shotStr);
+                    if ((stat(treeFile, &treeStat) == 0) && (stat(dataFile, &dataStat) == 0)) {
+                        uint64 fileInfo[6] = { static_cast<uint64>(treeStat.st_ino), static_cast<uint64>(treeStat.st_mtime), static_cast<uint64>(treeStat.st_size),
+                                static_cast<uint64>(dataStat.st_ino), static_cast<uint64>(dataStat.st_mtime), static_cast<uint64>(dataStat.st_size) };
+                        stamp = HashBytes(HASH_SEED, &fileInfo[0], sizeof(fileInfo));
+                        found = true;
+                    }
+                }
+            }
+            dirStart = (dirEnd != NULL_PTR(const char8 *)) ? (dirEnd + 1) : (dirStart + dirLen);
+        }
+    }
+    return found;
+}
+
+void MDSReaderNSCache::GetFileName(const StreamString &directory, const StreamString &key, StreamString &fileName) {
+    char8 name[1100];
+    uint64 hash = HashBytes(HASH_SEED, key.Buffer(), key.Size());
+    (void) snprintf(name, sizeof(name), "%s/%016llx.mdscache", directory.Buffer(), static_cast<unsigned long long>(hash));
+    fileName = name;
+}
+
+bool MDSReaderNSCache::Open(const StreamString &directory, const StreamString &key, const uint64 treeStamp) {
+    Close();
+    StreamString fileName;
+    GetFileName(directory, key, fileName);
+    int32 fd = open(fileName.Buffer(), O_RDONLY);
+    bool ok = (fd >= 0);
+    struct stat fileStat;
+    if (ok) {
+        ok = (fstat(fd, &fileStat) == 0);
+    }
+    if (ok) {
+        ok = (static_cast<uint64>(fileStat.st_size) >= sizeof(MDSReaderNSCacheHeader));
+    }
+    if (ok) {
+        mappedSize = static_cast<uint64>(fileStat.st_size);
+        void *mem = mmap(NULL_PTR(void *), mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+        ok = (mem != MAP_FAILED);
+        if (ok) {
+            mappedMemory = reinterpret_cast<char8 *>(mem);
+        }
+    }
+    if (fd >= 0) {
+        (void) close(fd);
+    }
+    if (ok) {
+        const MDSReaderNSCacheHeader *header = reinterpret_cast<const MDSReaderNSCacheHeader *>(mappedMemory);
+        ok = (header->magic == CACHE_MAGIC) && (header->version == CACHE_VERSION) && (header->treeStamp == treeStamp)
+                && (header->keySize == key.Size());
+        if (ok) {
+            uint64 dataOffset = sizeof(MDSReaderNSCacheHeader) + PaddedKeySize(header->keySize);
+            uint64 expectedSize = dataOffset + (static_cast<uint64>(header->dataSize) + header->timebaseSize) * sizeof(float64);
+            ok = (expectedSize == mappedSize);
+            if (ok) {
+                ok = (memcmp(&mappedMemory[sizeof(MDSReaderNSCacheHeader)], key.Buffer(), header->keySize) == 0);
+            }
+            if (ok) {
+                dataSize = header->dataSize;
+                numberOfElements = header->numberOfElements;
+                numberOfSamples = header->numberOfSamples;
+                timebaseSize = header->timebaseSize;
+                data = reinterpret_cast<const float64 *>(&mappedMemory[dataOffset]);
+                timebase = &data[header->dataSize];
+            }
+        }
+    }
+    if (!ok) {
+        Close();
+    }
+    return ok;
+}
+
+bool MDSReaderNSCache::Store(const StreamString &directory, const StreamString &key, const uint64 treeStamp, const float64 * const dataIn,
+                             const uint32 dataSize, const uint32 numberOfElementsIn, const uint32 numberOfSamplesIn, const float64 * const timebaseIn,
+                             const uint32 timebaseSizeIn) {
+    StreamString fileName;
+    GetFileName(directory, key, fileName);
+    char8 tmpFileName[1200];
+    (void) snprintf(tmpFileName, sizeof(tmpFileName), "%s.%d.tmp", fileName.Buffer(), static_cast<int32>(getpid()));
+
+    MDSReaderNSCacheHeader header;
+    (void) memset(&header, 0, sizeof(header));
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.treeStamp = treeStamp;
+    header.keySize = static_cast<uint32>(key.Size());
+    header.numberOfElements = numberOfElementsIn;
+    header.numberOfSamples = numberOfSamplesIn;
+    header.dataSize = dataSize;
+    header.timebaseSize = timebaseSizeIn;
+
+    FILE *file = fopen(tmpFileName, "wb");
+    bool ok = (file != NULL_PTR(FILE *));
+    if (!ok) {
+        REPORT_ERROR_STATIC(ErrorManagement::Warning, "Cannot create cache file %s", tmpFileName);
+    }
+    if (ok) {
+        const char8 padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        ok = (fwrite(&header, sizeof(header), 1u, file) == 1u);
+        if (ok && (header.keySize > 0u)) {
+            ok = (fwrite(key.Buffer(), header.keySize, 1u, file) == 1u);
+        }
+        uint64 nPad = PaddedKeySize(header.keySize) - header.keySize;
+        if (ok && (nPad > 0u)) {
+            ok = (fwrite(&padding[0], nPad, 1u, file) == 1u);
+        }
+        if (ok && (dataSize > 0u)) {
+            ok = (fwrite(dataIn, sizeof(float64), dataSize, file) == dataSize);
+        }
+        if (ok && (timebaseSizeIn > 0u)) {
+            ok = (fwrite(timebaseIn, sizeof(float64), timebaseSizeIn, file) == timebaseSizeIn);
+        }
+        ok = (fclose(file) == 0) && ok;
+        if (ok) {
+            ok = (rename(tmpFileName, fileName.Buffer()) == 0);
+        }
+        if (!ok) {
+            (void) unlink(tmpFileName);
+            REPORT_ERROR_STATIC(ErrorManagement::Warning, "Cannot write cache file %s", fileName.Buffer());
+        }
+    }
+    if (ok) {
+        ok = Open(directory, key, treeStamp);
+    }
+    return ok;
+}
+
+bool MDSReaderNSCache::IsMapped() const {
+    return (mappedMemory != NULL_PTR(char8 *));
+}
+
+const float64 *MDSReaderNSCache::GetData() const {
+    return data;
+}
+
+const float64 *MDSReaderNSCache::GetTimebase() const {
+    return timebase;
+}
+
+uint32 MDSReaderNSCache::GetDataSize() const {
+    return dataSize;
+}
+
+uint32 MDSReaderNSCache::GetNumberOfElements() const {
+    return numberOfElements;
+}
+
+uint32 MDSReaderNSCache::GetNumberOfSamples() const {
+    return numberOfSamples;
+}
+
+uint32 MDSReaderNSCache::GetTimebaseSize() const {
+    return timebaseSize;
+}
+
+}
@@ -0,0 +1,164 @@
+/**
+ * @file MDSReaderNSCache.h
+ * @brief Header file for class MDSReaderNSCache
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class MDSReaderNSCache
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef DATASOURCES_MDSREADERNS_MDSREADERNSCACHE_H_
+#define DATASOURCES_MDSREADERNS_MDSREADERNSCACHE_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+#include "StreamString.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * @brief Memory-mapped on-disk cache of the arrays evaluated by MDSReaderNS.
+ * @details Each cache entry is a flat file holding a fixed header, the key string, the data array and the timebase array (all float64).
+ * The file name is the 64 bit FNV-1a hash of the key, the full key is stored in the file to detect collisions.
+ * The entries are mapped read-only and shared, so that concurrent replay processes share the same pages through the page cache.
+ * An entry is valid only if its tree stamp (computed from the modification time and size of the tree files) matches the current one.
+ */
+class MDSReaderNSCache {
+public:
+    /**
+     * @brief Constructor. NOOP.
+     */
+    MDSReaderNSCache();
+
+    /**
+     * @brief Unmaps the entry, if mapped.
+     */
+    ~MDSReaderNSCache();
+
+    /**
+     * @brief Computes the stamp of the tree files.
+     * @details The tree files are searched in the directories listed in the <treename>_path environment variable.
+     * @param[in] treeName the MDSplus tree name.
+     * @param[in] shotNumber the shot number (-1 for the model).
+     * @param[out] stamp the computed stamp.
+     * @return true if the .tree and .datafile files were found.
+     */
+    static bool GetTreeStamp(const StreamString &treeName, const int32 shotNumber, uint64 &stamp);
+
+    /**
+     * @brief Maps a cache entry.
+     * @param[in] directory the cache directory.
+     * @param[in] key the cache entry key.
+     * @param[in] treeStamp the current tree stamp.
+     * @return true if a valid entry was found and mapped.
+     */
+    bool Open(const StreamString &directory, const StreamString &key, const uint64 treeStamp);
+
+    /**
+     * @brief Writes a new cache entry (atomically, through a temporary file) and maps it.
+     * @return true if the entry was written and mapped.
+     */
+    bool Store(const StreamString &directory, const StreamString &key, const uint64 treeStamp, const float64 * const data, const uint32 dataSize,
+               const uint32 numberOfElements, const uint32 numberOfSamples, const float64 * const timebase, const uint32 timebaseSize);
+
+    /**
+     * @return true if an entry is mapped.
+     */
+    bool IsMapped() const;
+
+    /**
+     * @return the mapped data array.
+     */
+    const float64 *GetData() const;
+
+    /**
+     * @return the mapped timebase array.
+     */
+    const float64 *GetTimebase() const;
+
+    /**
+     * @return the number of values in the data array.
+     */
+    uint32 GetDataSize() const;
+
+    /**
+     * @return the number of elements of each sample.
+     */
+    uint32 GetNumberOfElements() const;
+
+    /**
+     * @return the number of samples.
+     */
+    uint32 GetNumberOfSamples() const;
+
+    /**
+     * @return the number of timebase samples.
+     */
+    uint32 GetTimebaseSize() const;
+
+private:
+    /**
+     * @brief Unmaps the entry.
+     */
+    void Close();
+
+    /**
+     * @brief Builds the entry file name from the key hash.
+     */
+    static void GetFileName(const StreamString &directory, const StreamString &key, StreamString &fileName);
+
+    /**
+     * The mapped file.
+     */
+    char8 *mappedMemory;
+
+    /**
+     * The size of the mapped file.
+     */
+    uint64 mappedSize;
+
+    /**
+     * Pointers into the mapped file.
+     */
+    const float64 *data;
+    const float64 *timebase;
+
+    /**
+     * Array sizes.
+     */
+    uint32 dataSize;
+    uint32 numberOfElements;
+    uint32 numberOfSamples;
+    uint32 timebaseSize;
+};
+
+}
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+#endif /* DATASOURCES_MDSREADERNS_MDSREADERNSCACHE_H_ */
@@ -0,0 +1,73 @@
+/**
+ * @file MDSReaderNSInputBroker.cpp
+ * @brief Source file for class MDSReaderNSInputBroker
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for
+ * the class MDSReaderNSInputBroker (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+#include "MDSReaderNS.h"
+#include "MDSReaderNSInputBroker.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+MDSReaderNSInputBroker::MDSReaderNSInputBroker() :
+        MemoryMapInputBroker() {
+    reader = NULL_PTR(MDSReaderNS *);
+    consumerIdx = 0u;
+}
+
+MDSReaderNSInputBroker::~MDSReaderNSInputBroker() {
+    reader = NULL_PTR(MDSReaderNS *);
+}
+
+void MDSReaderNSInputBroker::SetConsumer(MDSReaderNS * const readerIn, const uint32 consumerIdxIn) {
+    reader = readerIn;
+    consumerIdx = consumerIdxIn;
+}
+
+bool MDSReaderNSInputBroker::Execute() {
+    bool ok = (reader != NULL_PTR(MDSReaderNS *));
+    if (ok) {
+        ok = reader->SynchroniseConsumer(consumerIdx);
+    }
+    if (ok) {
+        ok = MemoryMapInputBroker::Execute();
+    }
+    return ok;
+}
+
+CLASS_REGISTER(MDSReaderNSInputBroker, "1.0")
+}
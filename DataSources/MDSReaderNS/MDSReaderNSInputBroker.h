@@ -0,0 +1,94 @@
+/**
+ * @file MDSReaderNSInputBroker.h
+ * @brief Header file for class MDSReaderNSInputBroker
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class MDSReaderNSInputBroker
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef DATASOURCES_MDSREADERNS_MDSREADERNSINPUTBROKER_H_
+#define DATASOURCES_MDSREADERNS_MDSREADERNSINPUTBROKER_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+#include "MemoryMapInputBroker.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+class MDSReaderNS;
+
+/**
+ * @brief Input broker of MDSReaderNS.
+ * @details Same as the MemoryMapSynchronisedInputBroker, but it tells the MDSReaderNS which Function (consumer) is being synchronised,
+ * so that every Function reading from the same MDSReaderNS advances its own playback time at its own rate.
+ */
+class MDSReaderNSInputBroker: public MemoryMapInputBroker {
+public:
+    CLASS_REGISTER_DECLARATION()
+
+    /**
+     * @brief Constructor. NOOP.
+     */
+    MDSReaderNSInputBroker();
+
+    /**
+     * @brief Destructor. NOOP.
+     */
+    virtual ~MDSReaderNSInputBroker();
+
+    /**
+     * @brief Sets the MDSReaderNS and the consumer index to be synchronised at every Execute.
+     * @param[in] readerIn the MDSReaderNS owning the signals.
+     * @param[in] consumerIdxIn the consumer index of the Function.
+     */
+    void SetConsumer(MDSReaderNS * const readerIn, const uint32 consumerIdxIn);
+
+    /**
+     * @brief Calls MDSReaderNS::SynchroniseConsumer and then copies the signals (see MemoryMapInputBroker::Execute).
+     * @return true if both operations succeed.
+     */
+    virtual bool Execute();
+
+private:
+    /**
+     * The MDSReaderNS owning the signals.
+     */
+    MDSReaderNS *reader;
+
+    /**
+     * The consumer index of the Function.
+     */
+    uint32 consumerIdx;
+};
+
+}
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+#endif /* DATASOURCES_MDSREADERNS_MDSREADERNSINPUTBROKER_H_ */
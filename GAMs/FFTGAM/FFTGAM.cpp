@@ -26,146 +26,1162 @@
 /*---------------------------------------------------------------------------*/
 /*                         Standard header includes                          */
 /*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
 
 /*---------------------------------------------------------------------------*/
 /*                         Project header includes                           */
 /*---------------------------------------------------------------------------*/
 #include "FFTGAM.h"
 #include "AdvancedErrorManagement.h"
+#include "Sleep.h"
+#include <mdsobjects.h>
 #include <iostream>
 /*---------------------------------------------------------------------------*/
 /*                           Static definitions                              */
 /*---------------------------------------------------------------------------*/
 
+/**
+ * Time (s) the planning thread sleeps between two checks once the plan is built.
+ */
+static const MARTe::float64 PLANNER_IDLE_TIME = 0.1;
+
+static void DestroyPlan(fftw_plan plan) {
+    fftw_destroy_plan(plan);
+}
+
+static void DestroyPlan(fftwf_plan plan) {
+    fftwf_destroy_plan(plan);
+}
+
+/**
+ * Destroys the plan in use and, if different, the initial (estimated) and the background plans.
+ */
+template<typename P>
+static void DestroyPlans(P plan, P initial, P background) {
+    if ((initial != NULL_PTR(P)) && (initial != plan)) {
+        DestroyPlan(initial);
+    }
+    if ((background != NULL_PTR(P)) && (background != plan)) {
+        DestroyPlan(background);
+    }
+    if (plan != NULL_PTR(P)) {
+        DestroyPlan(plan);
+    }
+}
+
 namespace MARTe {
 
-FFTGAM::FFTGAM() : GAM()
+FastPollingMutexSem FFTGAM::plannerMutex;
+
+FFTGAM::FFTGAM() : GAM(), EmbeddedServiceMethodBinderI(), executor(*this)
 {
-    outSignalMemory[0] = outSignalMemory[1] = NULL;
+    inSignalMemory = NULL_PTR(void **);
+    outSignalMemory = NULL_PTR(float64 **);
+    outFullSpectrum = NULL_PTR(bool *);
+    products = NULL_PTR(FFTGAMProduct *);
+    numberOfProducts = 0u;
+    stageFunctions = NULL_PTR(StageFunction *);
+    stageFunctionsF = NULL_PTR(StageFunctionF *);
+    numberOfChannels = 0u;
+    numberOfElements = 0u;
+    inputStride = 0u;
+    outputStride = 0u;
+    fftSize = 0u;
+    hopSize = 0u;
+    samplesSinceTransform = 0u;
+    ring = NULL_PTR(double *);
+    ringPos = 0u;
+    window = NULL_PTR(double *);
+    in = NULL_PTR(double *);
+    out = NULL_PTR(fftw_complex *);
+    p = NULL_PTR(fftw_plan);
+    plannerFlag = FFTW_MEASURE;
+    planningTimeLimit = FFTW_NO_TIMELIMIT;
+    backgroundPlanning = 0u;
+    cpuMask = 0xffu;
+    stackSize = THREADS_DEFAULT_STACKSIZE;
+    backgroundPlan = NULL_PTR(fftw_plan);
+    initialPlan = NULL_PTR(fftw_plan);
+    waitingForPlan = false;
+    planningDone = false;
+    singlePrecision = false;
+    inF = NULL_PTR(float *);
+    outF = NULL_PTR(fftwf_complex *);
+    pF = NULL_PTR(fftwf_plan);
+    ringF = NULL_PTR(float *);
+    windowF = NULL_PTR(float *);
+    backgroundPlanF = NULL_PTR(fftwf_plan);
+    initialPlanF = NULL_PTR(fftwf_plan);
+    numberOfThreads = 1u;
+    threadsCpuMask = 0xffu;
+    threadPoolAcquired = false;
+    numberOfPairs = 0u;
+    pairs = NULL_PTR(uint32 *);
+    crossProducts = NULL_PTR(FFTGAMCrossProduct *);
+    numberOfCrossProducts = 0u;
+    crossOutSignalMemory = NULL_PTR(float64 **);
+    coherenceAveraging = 0.1;
+    crossAverage = NULL_PTR(float64 *);
+    numberOfPeaks = 0u;
+    peakThreshold = 0.;
+    peakInterpolation = FFTGAMPeakParabolic;
+    samplingFrequency = 0.;
+    peakOutSignalMemory = NULL_PTR(float64 **);
+    peakPower = NULL_PTR(float64 *);
+    peakBins = NULL_PTR(uint32 *);
+    filterMode = false;
+    filterCoefficients = NULL_PTR(float64 *);
+    numberOfFilterCoefficients = 0u;
+    filterIsResponse = false;
+    response = NULL_PTR(fftw_complex *);
+    inversePlan = NULL_PTR(fftw_plan);
+    filtered = NULL_PTR(double *);
+    (void) planMutex.Create();
 }
 
 FFTGAM::~FFTGAM() {
-    fftw_destroy_plan(p);
-    fftw_free(in); 
-    fftw_free(out);
+    if (executor.GetStatus() != EmbeddedThreadI::OffState) {
+        if (executor.Stop() != ErrorManagement::NoError) {
+            if (executor.Stop() != ErrorManagement::NoError) {
+                REPORT_ERROR(ErrorManagement::FatalError, "Could not stop the planning thread");
+            }
+        }
+    }
+    DestroyPlans(p, initialPlan, backgroundPlan);
+    DestroyPlans(pF, initialPlanF, backgroundPlanF);
+    if (inversePlan != NULL_PTR(fftw_plan)) {
+        fftw_destroy_plan(inversePlan);
+    }
+    if (threadPoolAcquired) {
+        plannerMutex.FastLock();
+        FFTGAMThreadPool::Release();
+        plannerMutex.FastUnLock();
+    }
+    if (in != NULL_PTR(double *)) {
+        fftw_free(in);
+    }
+    if (out != NULL_PTR(fftw_complex *)) {
+        fftw_free(out);
+    }
+    if (inF != NULL_PTR(float *)) {
+        fftw_free(inF);
+    }
+    if (outF != NULL_PTR(fftwf_complex *)) {
+        fftw_free(outF);
+    }
+    if (ringF != NULL_PTR(float *)) {
+        fftw_free(ringF);
+    }
+    if (windowF != NULL_PTR(float *)) {
+        fftw_free(windowF);
+    }
+    if (response != NULL_PTR(fftw_complex *)) {
+        fftw_free(response);
+    }
+    if (filtered != NULL_PTR(double *)) {
+        fftw_free(filtered);
+    }
+    if (filterCoefficients != NULL_PTR(float64 *)) {
+        delete [] filterCoefficients;
+    }
+    if (pairs != NULL_PTR(uint32 *)) {
+        delete [] pairs;
+    }
+    if (crossProducts != NULL_PTR(FFTGAMCrossProduct *)) {
+        delete [] crossProducts;
+    }
+    if (crossOutSignalMemory != NULL_PTR(float64 **)) {
+        delete [] crossOutSignalMemory;
+    }
+    if (crossAverage != NULL_PTR(float64 *)) {
+        delete [] crossAverage;
+    }
+    if (peakOutSignalMemory != NULL_PTR(float64 **)) {
+        delete [] peakOutSignalMemory;
+    }
+    if (peakPower != NULL_PTR(float64 *)) {
+        delete [] peakPower;
+    }
+    if (peakBins != NULL_PTR(uint32 *)) {
+        delete [] peakBins;
+    }
+    if (inSignalMemory != NULL_PTR(void **)) {
+        delete [] inSignalMemory;
+    }
+    if (outSignalMemory != NULL_PTR(float64 **)) {
+        delete [] outSignalMemory;
+    }
+    if (outFullSpectrum != NULL_PTR(bool *)) {
+        delete [] outFullSpectrum;
+    }
+    if (products != NULL_PTR(FFTGAMProduct *)) {
+        delete [] products;
+    }
+    if (stageFunctions != NULL_PTR(StageFunction *)) {
+        delete [] stageFunctions;
+    }
+    if (stageFunctionsF != NULL_PTR(StageFunctionF *)) {
+        delete [] stageFunctionsF;
+    }
+    if (ring != NULL_PTR(double *)) {
+        fftw_free(ring);
+    }
+    if (window != NULL_PTR(double *)) {
+        fftw_free(window);
+    }
 }
 
 bool FFTGAM::Setup() {
-    bool ok = (GetNumberOfInputSignals() == 1);
+    uint32 numberOfInputSignals = GetNumberOfInputSignals();
+    bool ok = (numberOfInputSignals > 0u);
     if (!ok) {
-        REPORT_ERROR(ErrorManagement::ParametersError, "There shall be one input signal");
+        REPORT_ERROR(ErrorManagement::ParametersError, "There shall be at least one input signal");
 	return ok;
     }
-    ok = (GetNumberOfOutputSignals() == 2);
+    uint32 numberOfPeakOutputs = (numberOfPeaks > 0u) ? numberOfInputSignals : 0u;
+    ok = (GetNumberOfOutputSignals() == ((numberOfProducts * numberOfInputSignals) + numberOfCrossProducts + numberOfPeakOutputs));
     if (!ok) {
-        REPORT_ERROR(ErrorManagement::ParametersError, "There shall be two output signals (module and phase)");
-    }
-    inputType  = GetSignalType(InputSignals, 0);
-    if(inputType != Float64Bit 
-	&& inputType != Float32Bit 
-	&& inputType != UnsignedInteger16Bit
-	&& inputType != SignedInteger16Bit
-	&& inputType != UnsignedInteger32Bit
-	&& inputType != SignedInteger32Bit)
+        if (filterMode) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "There shall be an output signal for each input signal");
+        }
+        else {
+            REPORT_ERROR(ErrorManagement::ParametersError, "There shall be %d output signals (one for each of the Outputs, plus the peaks if requested) for each input signal and %d (one for each of the CrossOutputs)",
+                         numberOfProducts + ((numberOfPeaks > 0u) ? 1u : 0u), numberOfCrossProducts);
+        }
+	return ok;
+    }
+    uint32 numberOfDimensions = 0u;
+    if (numberOfInputSignals == 1u) {
+        ok = GetSignalNumberOfDimensions(InputSignals, 0u, numberOfDimensions);
+    }
+    if (ok) {
+        if (numberOfDimensions == 2u) { //NumberOfChannels rows of samples
+            ok = (numberOfChannels > 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "NumberOfChannels shall be specified for a 2D input signal");
+            }
+        }
+        else {
+            numberOfChannels = numberOfInputSignals;
+        }
+    }
+    if (ok) {
+        inSignalMemory = new void *[numberOfChannels];
+        if (singlePrecision) {
+            stageFunctionsF = new StageFunctionF[numberOfChannels];
+        }
+        else {
+            stageFunctions = new StageFunction[numberOfChannels];
+        }
+        outSignalMemory = new float64 *[numberOfProducts * numberOfChannels];
+        outFullSpectrum = new bool[numberOfProducts * numberOfChannels];
+        if (numberOfPeaks > 0u) {
+            peakOutSignalMemory = new float64 *[numberOfChannels];
+        }
+    }
+    uint32 channelIdx = 0u;
+    for (uint32 inIdx = 0u; (inIdx < numberOfInputSignals) && ok; inIdx++) {
+        TypeDescriptor signalType = GetSignalType(InputSignals, inIdx);
+        StageFunction stageFunction = NULL_PTR(StageFunction);
+        StageFunctionF stageFunctionF = NULL_PTR(StageFunctionF);
+        if (singlePrecision) { //Only the types exactly represented by a float
+            ok = (signalType == Float32Bit) || (signalType == UnsignedInteger16Bit) || (signalType == SignedInteger16Bit);
+            if (ok) {
+                ok = GetStageFunction(signalType, stageFunctionF);
+            }
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Only float32 and integers (16 bits) types supported as input with Precision = Single");
+            }
+        }
+        else {
+            ok = GetStageFunction(signalType, stageFunction);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Only Float (32/64 bits) and integers (16/32 bits) types supported as input");
+            }
+        }
+        if (ok) {
+            ok = GetSignalNumberOfDimensions(InputSignals, inIdx, numberOfDimensions);
+        }
+        if (ok) {
+            ok = (numberOfDimensions == 1 || (numberOfDimensions == 0) || ((numberOfDimensions == 2) && (numberOfInputSignals == 1u)));
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Input signal will be either 1D (single samples), scalar (multiple samples) or 2D (single input signal, one row per channel)");
+            }
+        }
+        uint32 signalElements = 0u;
+        if (ok) {
+            if(numberOfDimensions > 0)
+            {
+                ok = GetSignalNumberOfElements(InputSignals, inIdx, signalElements);
+            }
+            else
+            {
+                ok = GetSignalNumberOfSamples(InputSignals, inIdx, signalElements);
+            }
+        }
+        uint32 signalChannels = (numberOfDimensions == 2u) ? numberOfChannels : 1u;
+        if (ok) {
+            ok = ((signalElements % signalChannels) == 0u) && (signalElements > 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "The number of elements of the 2D input signal shall be a multiple of NumberOfChannels");
+            }
+        }
+        if (ok) {
+            uint32 channelElements = signalElements / signalChannels;
+            if (inIdx == 0u) {
+                numberOfElements = channelElements;
+            }
+            ok = (channelElements == numberOfElements);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "All the channels shall have the same number of samples (%d)", numberOfElements);
+            }
+        }
+        if (ok && (inIdx == 0u) && filterMode) {
+            ok = SetupFilterSize();
+        }
+        else if (ok && (inIdx == 0u)) {
+            if (fftSize == 0u) {
+                fftSize = numberOfElements;
+            }
+            if (hopSize == 0u) {
+                hopSize = numberOfElements;
+            }
+            ok = ((fftSize % numberOfElements) == 0u) && ((hopSize % numberOfElements) == 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "WindowLength and HopSize shall be multiples of the number of samples per cycle (%d)", numberOfElements);
+            }
+        }
+        if (ok) {
+            char8 *signalMemory = reinterpret_cast<char8 *>(GetInputSignalMemory(inIdx));
+            uint32 channelSize = numberOfElements * (static_cast<uint32>(signalType.numberOfBits) / 8u);
+            for (uint32 c = 0u; c < signalChannels; c++) {
+                inSignalMemory[channelIdx] = &signalMemory[c * channelSize];
+                if (singlePrecision) {
+                    stageFunctionsF[channelIdx] = stageFunctionF;
+                }
+                else {
+                    stageFunctions[channelIdx] = stageFunction;
+                }
+                channelIdx++;
+            }
+        }
+        for(uint32 outIdx = 0; (outIdx < numberOfProducts) && ok; outIdx++)
+        {
+            uint32 outSignalIdx = (numberOfProducts * inIdx) + outIdx;
+            TypeDescriptor outType = GetSignalType(OutputSignals, outSignalIdx);
+            if(outType != Float64Bit)
+            {
+                ok = false;
+                REPORT_ERROR(ErrorManagement::ParametersError, "Output signal type shall be Float64");
+            }
+            uint32 outDimensions = 0u;
+            if (ok) {
+                ok = GetSignalNumberOfDimensions(OutputSignals, outSignalIdx, outDimensions);
+            }
+            if (ok) {
+                ok = (outDimensions == ((signalChannels > 1u) ? 2u : 1u));
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall be 1D (2D for a 2D input signal)");
+                }
+            }
+            uint32 outElements = 0u;
+            if (ok) {
+                ok = GetSignalNumberOfElements(OutputSignals, outSignalIdx, outElements);
+            }
+            //Half (or full) spectrum, two values per bin for the complex product. The filtered samples in filter mode
+            uint32 valuesPerBin = ((!filterMode) && (products[outIdx] == FFTGAMComplex)) ? 2u : 1u;
+            uint32 halfElements = ((fftSize / 2u) + 1u) * valuesPerBin;
+            uint32 fullElements = fftSize * valuesPerBin;
+            if (ok && filterMode) {
+                ok = (outElements == (numberOfElements * signalChannels));
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall have %d elements (as the input signal)", numberOfElements * signalChannels);
+                }
+                halfElements = numberOfElements;
+            }
+            else if (ok) {
+                ok = (outElements == (halfElements * signalChannels)) || (outElements == (fullElements * signalChannels));
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall have %d (half spectrum) or %d (full spectrum) elements",
+                                 halfElements * signalChannels, fullElements * signalChannels);
+                }
+            }
+            if (ok) {
+                bool full = (outElements == (fullElements * signalChannels));
+                uint32 channelOutElements = full ? fullElements : halfElements;
+                float64 *signalMemory = reinterpret_cast<float64 *>(GetOutputSignalMemory(outSignalIdx));
+                for (uint32 c = 0u; c < signalChannels; c++) {
+                    uint32 outMemoryIdx = (outIdx * numberOfChannels) + (channelIdx - signalChannels + c);
+                    outSignalMemory[outMemoryIdx] = &signalMemory[c * channelOutElements];
+                    outFullSpectrum[outMemoryIdx] = full;
+                }
+            }
+        }
+        if (ok && (numberOfPeaks > 0u)) {
+            uint32 peakSignalIdx = (numberOfProducts * numberOfInputSignals) + numberOfCrossProducts + inIdx;
+            ok = SetupPeakOutput(peakSignalIdx, channelIdx - signalChannels, signalChannels);
+        }
+    }
+    if (ok && (numberOfCrossProducts > 0u)) {
+        ok = SetupCrossProducts(numberOfProducts * numberOfInputSignals);
+    }
+    if (ok && (numberOfPeaks > 0u)) {
+        peakPower = new float64[(fftSize / 2u) + 1u];
+        peakBins = new uint32[numberOfPeaks];
+    }
+    if (ok) {
+        ok = CreateWindow();
+    }
+    if (ok && singlePrecision && (window != NULL_PTR(double *))) {
+        ok = AllocateBlock(windowF, fftSize);
+        for (uint32 i = 0u; (i < fftSize) && ok; i++) {
+            windowF[i] = static_cast<float>(window[i]);
+        }
+    }
+    if (ok && (fftSize > numberOfElements)) {
+        ok = singlePrecision ? AllocateBlock(ringF, fftSize * numberOfChannels) : AllocateBlock(ring, fftSize * numberOfChannels);
+    }
+    if (ok && (numberOfThreads > 1u)) {
+        plannerMutex.FastLock();
+        ok = FFTGAMThreadPool::Acquire(numberOfThreads - 1u, threadsCpuMask, stackSize);
+        plannerMutex.FastUnLock();
+        threadPoolAcquired = ok;
+    }
+    if(ok)
     {
-        ok = false;
-        REPORT_ERROR(ErrorManagement::ParametersError, "Only Float (32/64 bits) and integers (16/32 bits) types supported as input");
+        //All the channels are transformed by a single plan. Strides are padded to keep every channel 32 bytes aligned
+        if (singlePrecision) {
+            inputStride = (fftSize + 7u) & ~7u;
+            outputStride = (fftSize + 3u) & ~3u;
+            ok = PlanTransform(inF, outF, pF, initialPlanF);
+        }
+        else {
+            inputStride = (fftSize + 3u) & ~3u;
+            outputStride = (fftSize + 1u) & ~1u;
+            ok = PlanTransform(in, out, p, initialPlan);
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not create the FFTW plan");
+        }
+    }
+    if (ok && filterMode) {
+        ok = SetupFilter();
+    }
+    return ok;
+}
+
+bool FFTGAM::SetupCrossProducts(const uint32 firstOutputIdx) {
+    bool ok = true;
+    for (uint32 i = 0u; (i < (2u * numberOfPairs)) && ok; i++) {
+        ok = (pairs[i] < numberOfChannels);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "CrossPairs channel %d shall be less than the number of channels (%d)", pairs[i], numberOfChannels);
+        }
+    }
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    if (ok) {
+        crossOutSignalMemory = new float64 *[numberOfCrossProducts];
+    }
+    for (uint32 x = 0u; (x < numberOfCrossProducts) && ok; x++) {
+        uint32 outSignalIdx = firstOutputIdx + x;
+        ok = (GetSignalType(OutputSignals, outSignalIdx) == Float64Bit);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Output signal type shall be Float64");
+        }
+        uint32 outElements = 0u;
+        if (ok) {
+            ok = GetSignalNumberOfElements(OutputSignals, outSignalIdx, outElements);
+        }
+        uint32 crossElements = numberOfBins * numberOfPairs * ((crossProducts[x] == FFTGAMCrossPower) ? 2u : 1u);
+        if (ok) {
+            ok = (outElements == crossElements);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Cross output signal %d shall have %d elements", x, crossElements);
+            }
+        }
+        if (ok) {
+            crossOutSignalMemory[x] = reinterpret_cast<float64 *>(GetOutputSignalMemory(outSignalIdx));
+            if ((crossProducts[x] == FFTGAMCoherence) && (crossAverage == NULL_PTR(float64 *))) {
+                crossAverage = new float64[4u * numberOfBins * numberOfPairs];
+                for (uint32 i = 0u; i < (4u * numberOfBins * numberOfPairs); i++) {
+                    crossAverage[i] = 0.;
+                }
+            }
+        }
     }
-    uint32 numberOfDimensions;
-    GetSignalNumberOfDimensions(InputSignals, 0, numberOfDimensions);
-    ok = (numberOfDimensions == 1 || (numberOfDimensions == 0));
+    return ok;
+}
+
+bool FFTGAM::SetupPeakOutput(const uint32 outSignalIdx, const uint32 firstChannelIdx, const uint32 signalChannels) {
+    bool ok = (GetSignalType(OutputSignals, outSignalIdx) == Float64Bit);
     if (!ok) {
-        REPORT_ERROR(ErrorManagement::ParametersError, "Input signal will be either 1D (single samples) or scarar (multiple samples)");
+        REPORT_ERROR(ErrorManagement::ParametersError, "Output signal type shall be Float64");
     }
-    
-    if(numberOfDimensions == 1)
-    {
-    	ok = GetSignalNumberOfElements(InputSignals, 0, numberOfElements);
+    uint32 outElements = 0u;
+    if (ok) {
+        ok = GetSignalNumberOfElements(OutputSignals, outSignalIdx, outElements);
     }
-    else
-    {
-	ok = GetSignalNumberOfSamples(InputSignals, 0, numberOfElements);
+    if (ok) {
+        ok = (outElements == (3u * numberOfPeaks * signalChannels));
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Peak output signal shall have %d elements (3 * Peaks for each channel)", 3u * numberOfPeaks * signalChannels);
+        }
     }
     if (ok) {
-            inSignalMemory = (float64 *) GetInputSignalMemory(0);
+        float64 *signalMemory = reinterpret_cast<float64 *>(GetOutputSignalMemory(outSignalIdx));
+        for (uint32 c = 0u; c < signalChannels; c++) {
+            peakOutSignalMemory[firstChannelIdx + c] = &signalMemory[3u * numberOfPeaks * c];
+        }
     }
+    return ok;
+}
 
-    for(uint32 outIdx = 0; outIdx < 2; outIdx++)
-    {
-	TypeDescriptor outType = GetSignalType(OutputSignals, outIdx);
-        if(outType != Float64Bit)
-        {
-            ok = false;
-            REPORT_ERROR(ErrorManagement::ParametersError, "Output signal type shall be Float64");
+bool FFTGAM::SetupFilterSize() {
+    //Overlap-save: every cycle the last fftSize samples are filtered and the last numberOfElements results are valid if taps <= fftSize - numberOfElements + 1
+    hopSize = numberOfElements;
+    uint32 numberOfTaps = filterIsResponse ? 0u : numberOfFilterCoefficients;
+    if (fftSize == 0u) {
+        if (filterIsResponse) {
+            fftSize = (numberOfFilterCoefficients / 2u) - 1u;
+            fftSize *= 2u;
+        }
+        else {
+            for (fftSize = 1u; fftSize < (numberOfElements + numberOfTaps - 1u); fftSize *= 2u) {
+            }
         }
-    	GetSignalNumberOfDimensions(OutputSignals, outIdx, numberOfDimensions);
-        ok = (numberOfDimensions == 1);
+    }
+    bool ok = (fftSize >= numberOfElements);
+    if (!ok) {
+        REPORT_ERROR(ErrorManagement::ParametersError, "WindowLength shall not be less than the number of samples per cycle (%d)", numberOfElements);
+    }
+    if (ok && filterIsResponse) {
+        ok = (numberOfFilterCoefficients == (2u * ((fftSize / 2u) + 1u)));
         if (!ok) {
-            REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall be 1D");
-    	}
-	uint32 outElements;	
-    	GetSignalNumberOfElements(OutputSignals, outIdx, outElements);
-	ok = (outElements == numberOfElements);
+            REPORT_ERROR(ErrorManagement::ParametersError, "FilterResponse shall have %d values (WindowLength / 2 + 1 complex gains)", 2u * ((fftSize / 2u) + 1u));
+        }
+    }
+    if (ok && !filterIsResponse) {
+        ok = (numberOfTaps <= (fftSize - numberOfElements + 1u));
         if (!ok) {
-            REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall have %d elements", numberOfElements);
-    	}
-    	if (ok) {
-            outSignalMemory[outIdx] = (float64 *) GetOutputSignalMemory(outIdx);
-	}
+            REPORT_ERROR(ErrorManagement::ParametersError, "Too many FilterTaps: at most %d with WindowLength = %d", fftSize - numberOfElements + 1u, fftSize);
+        }
     }
-    if(ok)
-    {
-        in = (double *)fftw_malloc(sizeof(double ) * numberOfElements); 
-        out = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * numberOfElements); 
-	p = fftw_plan_dft_r2c_1d(numberOfElements, in, out, FFTW_MEASURE);
+    return ok;
+}
+
+bool FFTGAM::SetupFilter() {
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    bool ok = AllocateBlock(response, numberOfBins);
+    if (ok) {
+        ok = AllocateBlock(filtered, inputStride * numberOfChannels);
+    }
+    if (ok && filterIsResponse) {
+        memcpy(response, filterCoefficients, numberOfBins * sizeof(fftw_complex));
+    }
+    else if (ok) { //Transform of the (zero padded) taps
+        double *taps = NULL_PTR(double *);
+        ok = AllocateBlock(taps, fftSize);
+        if (ok) {
+            for (uint32 i = 0u; i < numberOfFilterCoefficients; i++) {
+                taps[i] = filterCoefficients[i];
+            }
+            plannerMutex.FastLock();
+            FFTGAMThreadPool::SetPlannerThreads(1u);
+            fftw_plan tapsPlan = fftw_plan_dft_r2c_1d(static_cast<int>(fftSize), taps, response, FFTW_ESTIMATE);
+            plannerMutex.FastUnLock();
+            ok = (tapsPlan != NULL_PTR(fftw_plan));
+            if (ok) {
+                fftw_execute(tapsPlan);
+                plannerMutex.FastLock();
+                fftw_destroy_plan(tapsPlan);
+                plannerMutex.FastUnLock();
+            }
+            fftw_free(taps);
+        }
+    }
+    else {
+
+    }
+    if (ok) { //FFTW transforms are not normalised
+        double scale = 1. / fftSize;
+        for (uint32 k = 0u; k < numberOfBins; k++) {
+            response[k][0] *= scale;
+            response[k][1] *= scale;
+        }
+        int n = static_cast<int>(fftSize);
+        plannerMutex.FastLock();
+        FFTGAMThreadPool::SetPlannerThreads(numberOfThreads);
+        fftw_set_timelimit(planningTimeLimit);
+        inversePlan = fftw_plan_many_dft_c2r(1, &n, static_cast<int>(numberOfChannels), out, NULL_PTR(int *), 1, static_cast<int>(outputStride),
+                                             filtered, NULL_PTR(int *), 1, static_cast<int>(inputStride), plannerFlag);
+        plannerMutex.FastUnLock();
+        ok = (inversePlan != NULL_PTR(fftw_plan));
+        if (ok && (plannerFlag != FFTW_ESTIMATE)) {
+            ExportWisdom();
+        }
+        if (ok) { //The planner may have overwritten the blocks
+            memset(out, 0, sizeof(fftw_complex) * outputStride * numberOfChannels);
+            memset(filtered, 0, sizeof(double) * inputStride * numberOfChannels);
+        }
+        else {
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not create the inverse FFTW plan");
+        }
     }
     return ok;
 }
 
-bool FFTGAM::Execute() {
+void FFTGAM::Filter() {
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    for (uint32 c = 0u; c < numberOfChannels; c++) {
+        fftw_complex *bins = &out[c * outputStride];
+        for (uint32 k = 0u; k < numberOfBins; k++) {
+            double re = (bins[k][0] * response[k][0]) - (bins[k][1] * response[k][1]);
+            double im = (bins[k][0] * response[k][1]) + (bins[k][1] * response[k][0]);
+            bins[k][0] = re;
+            bins[k][1] = im;
+        }
+    }
+    fftw_execute_dft_c2r(inversePlan, out, filtered);
+    //The first fftSize - numberOfElements samples are affected by the circular wrap
+    for (uint32 c = 0u; c < numberOfChannels; c++) {
+        memcpy(outSignalMemory[c], &filtered[(c * inputStride) + fftSize - numberOfElements], numberOfElements * sizeof(double));
+    }
+}
 
-static int xx;
-printf("FFT %d\n", xx++);
+bool FFTGAM::ReadCrossProducts(StructuredDataI &data) {
+    bool ok = true;
+    AnyType pairsDescription = data.GetType("CrossPairs");
+    if (pairsDescription.GetDataPointer() != NULL_PTR(void *)) {
+        numberOfPairs = pairsDescription.GetNumberOfElements(1u);
+        ok = (numberOfPairs > 0u) && (pairsDescription.GetNumberOfElements(0u) == 2u);
+        if (ok) {
+            Matrix<uint32> pairsMatrix(numberOfPairs, 2u);
+            ok = data.Read("CrossPairs", pairsMatrix);
+            if (ok) {
+                pairs = new uint32[2u * numberOfPairs];
+                for (uint32 i = 0u; i < numberOfPairs; i++) {
+                    pairs[2u * i] = pairsMatrix[i][0u];
+                    pairs[(2u * i) + 1u] = pairsMatrix[i][1u];
+                }
+            }
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "CrossPairs shall be a matrix with two columns, e.g. { {0 1} {0 2} }");
+        }
+        AnyType crossOutputsDescription = data.GetType("CrossOutputs");
+        if (ok && (crossOutputsDescription.GetDataPointer() != NULL_PTR(void *))) {
+            numberOfCrossProducts = crossOutputsDescription.GetNumberOfElements(0u);
+            ok = (numberOfCrossProducts > 0u);
+            Vector<StreamString> crossProductNames(numberOfCrossProducts);
+            if (ok) {
+                ok = data.Read("CrossOutputs", crossProductNames);
+            }
+            if (ok) {
+                crossProducts = new FFTGAMCrossProduct[numberOfCrossProducts];
+                for (uint32 x = 0u; (x < numberOfCrossProducts) && ok; x++) {
+                    ok = GetCrossProduct(crossProductNames[x], crossProducts[x]);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::ParametersError, "Unknown cross output %s. Possible values are CrossPower, PhaseDifference, Coherence",
+                                     crossProductNames[x].Buffer());
+                    }
+                }
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read CrossOutputs");
+            }
+        }
+        else if (ok) { //Phase difference and coherence
+            numberOfCrossProducts = 2u;
+            crossProducts = new FFTGAMCrossProduct[numberOfCrossProducts];
+            crossProducts[0] = FFTGAMPhaseDifference;
+            crossProducts[1] = FFTGAMCoherence;
+        }
+        else {
 
-    for(uint32 i = 0; i < numberOfElements; i++)
-    {
-	if (inputType == Float32Bit)
-	{
-		in[i] = ((float32 *)inSignalMemory)[i];
-	}
-	else if (inputType == Float64Bit)
-	{
-		in[i] = ((float64 *)inSignalMemory)[i];
-	}
-	else if (inputType == UnsignedInteger16Bit)
-	{
-		in[i] = ((uint16 *)inSignalMemory)[i];
-	}
-	else if (inputType == SignedInteger16Bit)
-	{
-		in[i] = ((int16 *)inSignalMemory)[i];
-	}
-	else if (inputType == UnsignedInteger32Bit)
-	{
-		in[i] = ((uint32 *)inSignalMemory)[i];
-	}
-	else if (inputType == SignedInteger32Bit)
-	{
-		in[i] = ((int32 *)inSignalMemory)[i];
-	}
-	else printf("OHIBO'!!!!!!!!\n");
-    }
-    fftw_execute(p);
-    for(uint32 i = 0; i < numberOfElements; i++)
-    {
-	outSignalMemory[0][i] = sqrt(out[i][0]*out[i][0]+out[i][1]*out[i][1]);
-	outSignalMemory[1][i] = atan2(out[i][1], out[i][0]);
+        }
+        if (ok) {
+            if (!data.Read("CoherenceAveraging", coherenceAveraging)) {
+                coherenceAveraging = 0.1;
+            }
+            ok = (coherenceAveraging > 0.) && (coherenceAveraging <= 1.);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "CoherenceAveraging shall be in (0, 1]");
+            }
+        }
+    }
+    return ok;
+}
+
+bool FFTGAM::ReadPeaks(StructuredDataI &data) {
+    bool ok = true;
+    if (!data.Read("Peaks", numberOfPeaks)) {
+        numberOfPeaks = 0u;
+    }
+    if (numberOfPeaks > 0u) {
+        if (!data.Read("PeakThreshold", peakThreshold)) {
+            peakThreshold = 0.;
+        }
+        if (!data.Read("SamplingFrequency", samplingFrequency)) {
+            samplingFrequency = 0.;
+        }
+        StreamString interpolation;
+        if (data.Read("PeakInterpolation", interpolation)) {
+            static const char8 * const interpolationNames[] = { "None", "Parabolic", "Gaussian" };
+            static const FFTGAMPeakInterpolation interpolationCodes[] = { FFTGAMPeakNone, FFTGAMPeakParabolic, FFTGAMPeakGaussian };
+            uint32 k;
+            for (k = 0u; (k < 3u) && (interpolation != interpolationNames[k]); k++) {
+            }
+            ok = (k < 3u);
+            if (ok) {
+                peakInterpolation = interpolationCodes[k];
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unknown PeakInterpolation %s. Possible values are None, Parabolic, Gaussian",
+                             interpolation.Buffer());
+            }
+        }
+    }
+    return ok;
+}
+
+bool FFTGAM::ReadFilter(StructuredDataI &data) {
+    bool ok = (!singlePrecision) && (backgroundPlanning == 0u) && (windowName == "Rectangular");
+    if (!ok) {
+        REPORT_ERROR(ErrorManagement::ParametersError, "Mode = Filter requires Precision = Double, the Rectangular Window and no BackgroundPlanning");
+    }
+    StreamString filterTree;
+    StreamString filterExpr;
+    if (ok && data.Read("FilterTree", filterTree)) {
+        int32 filterShot = -1;
+        if (!data.Read("FilterShot", filterShot)) {
+            filterShot = -1;
+        }
+        StreamString filterExprType;
+        if (!data.Read("FilterExprType", filterExprType)) {
+            filterExprType = "Taps";
+        }
+        ok = data.Read("FilterExpr", filterExpr);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "FilterExpr shall be specified with FilterTree");
+        }
+        if (ok) {
+            ok = (filterExprType == "Taps") || (filterExprType == "Response");
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unknown FilterExprType %s. Possible values are Taps, Response", filterExprType.Buffer());
+            }
+        }
+        if (ok) {
+            filterIsResponse = (filterExprType == "Response");
+            ok = LoadFilter(filterTree, filterShot, filterExpr);
+        }
+    }
+    else if (ok) {
+        AnyType tapsDescription = data.GetType("FilterTaps");
+        AnyType responseDescription = data.GetType("FilterResponse");
+        filterIsResponse = (tapsDescription.GetDataPointer() == NULL_PTR(void *));
+        AnyType coefficientsDescription = filterIsResponse ? responseDescription : tapsDescription;
+        ok = (coefficientsDescription.GetDataPointer() != NULL_PTR(void *));
+        if (ok) {
+            numberOfFilterCoefficients = coefficientsDescription.GetNumberOfElements(0u);
+            Vector<float64> coefficients(numberOfFilterCoefficients);
+            ok = data.Read(filterIsResponse ? "FilterResponse" : "FilterTaps", coefficients);
+            if (ok) {
+                filterCoefficients = new float64[numberOfFilterCoefficients];
+                for (uint32 i = 0u; i < numberOfFilterCoefficients; i++) {
+                    filterCoefficients[i] = coefficients[i];
+                }
+            }
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Either FilterTaps, FilterResponse or FilterTree and FilterExpr shall be specified");
+        }
+    }
+    else {
+
+    }
+    if (ok) {
+        ok = filterIsResponse ? ((numberOfFilterCoefficients >= 4u) && ((numberOfFilterCoefficients % 2u) == 0u)) : (numberOfFilterCoefficients > 0u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "The filter shall have at least one tap or two complex gains (real and imaginary parts)");
+        }
+    }
+    //One output (the filtered samples) for each input
+    numberOfProducts = 1u;
+    return ok;
+}
+
+bool FFTGAM::LoadFilter(const StreamString &treeName, const int32 shotNumber, const StreamString &expression) {
+    bool ok = true;
+    MDSplus::Tree *tree = NULL_PTR(MDSplus::Tree *);
+    try {
+        tree = new MDSplus::Tree(treeName.Buffer(), shotNumber);
+        MDSplus::Data *expressionData = MDSplus::compile(expression.Buffer(), tree);
+        MDSplus::Data *evalData = expressionData->data();
+        int numberOfValues = 0;
+        double *values = evalData->getDoubleArray(&numberOfValues);
+        MDSplus::deleteData(evalData);
+        MDSplus::deleteData(expressionData);
+        numberOfFilterCoefficients = static_cast<uint32>(numberOfValues);
+        filterCoefficients = new float64[numberOfFilterCoefficients];
+        for (uint32 i = 0u; i < numberOfFilterCoefficients; i++) {
+            filterCoefficients[i] = values[i];
+        }
+        delete [] values;
+    }
+    catch (const MDSplus::MdsException &exc) {
+        REPORT_ERROR(ErrorManagement::ParametersError, "Cannot evaluate %s in tree %s, shot %d: %s", expression.Buffer(), treeName.Buffer(), shotNumber,
+                     exc.what());
+        ok = false;
+    }
+    if (tree != NULL_PTR(MDSplus::Tree *)) {
+        delete tree;
+    }
+    return ok;
+}
+
+bool FFTGAM::CreatePlan(const uint32 flags, double * const planIn, fftw_complex * const planOut, fftw_plan &plan) const {
+    int n = static_cast<int>(fftSize);
+    plannerMutex.FastLock();
+    FFTGAMThreadPool::SetPlannerThreads(numberOfThreads);
+    fftw_set_timelimit(planningTimeLimit);
+    plan = fftw_plan_many_dft_r2c(1, &n, static_cast<int>(numberOfChannels), planIn, NULL_PTR(int *), 1, static_cast<int>(inputStride),
+                                  planOut, NULL_PTR(int *), 1, static_cast<int>(outputStride), flags);
+    plannerMutex.FastUnLock();
+    return (plan != NULL_PTR(fftw_plan));
+}
+
+bool FFTGAM::CreatePlan(const uint32 flags, float * const planIn, fftwf_complex * const planOut, fftwf_plan &plan) const {
+    int n = static_cast<int>(fftSize);
+    plannerMutex.FastLock();
+    FFTGAMThreadPool::SetPlannerThreads(numberOfThreads);
+    fftwf_set_timelimit(planningTimeLimit);
+    plan = fftwf_plan_many_dft_r2c(1, &n, static_cast<int>(numberOfChannels), planIn, NULL_PTR(int *), 1, static_cast<int>(inputStride),
+                                   planOut, NULL_PTR(int *), 1, static_cast<int>(outputStride), flags);
+    plannerMutex.FastUnLock();
+    return (plan != NULL_PTR(fftwf_plan));
+}
+
+void FFTGAM::ImportWisdom() const {
+    if (wisdomFile.Size() > 0u) {
+        plannerMutex.FastLock();
+        int imported = singlePrecision ? fftwf_import_wisdom_from_filename(wisdomFile.Buffer()) : fftw_import_wisdom_from_filename(wisdomFile.Buffer());
+        plannerMutex.FastUnLock();
+        if (imported == 0) {
+            REPORT_ERROR(ErrorManagement::Information, "Could not import the FFTW wisdom from %s. It will be created", wisdomFile.Buffer());
+        }
+    }
+}
+
+void FFTGAM::ExportWisdom() const {
+    if (wisdomFile.Size() > 0u) {
+        StreamString tmpFile = wisdomFile;
+        tmpFile += ".tmp";
+        plannerMutex.FastLock();
+        int exported = singlePrecision ? fftwf_export_wisdom_to_filename(tmpFile.Buffer()) : fftw_export_wisdom_to_filename(tmpFile.Buffer());
+        plannerMutex.FastUnLock();
+        bool ok = (exported != 0);
+        if (ok) {
+            ok = (rename(tmpFile.Buffer(), wisdomFile.Buffer()) == 0);
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::Warning, "Could not export the FFTW wisdom to %s", wisdomFile.Buffer());
+        }
+    }
+}
+
+ErrorManagement::ErrorType FFTGAM::Execute(ExecutionInfo &info) {
+    ErrorManagement::ErrorType err = ErrorManagement::NoError;
+    if (info.GetStage() == ExecutionInfo::MainStage) {
+        if (!planningDone) {
+            planningDone = true;
+            fftw_plan plan = NULL_PTR(fftw_plan);
+            fftwf_plan planF = NULL_PTR(fftwf_plan);
+            bool ok = singlePrecision ? PlanOnScratch<float, fftwf_complex>(planF) : PlanOnScratch<double, fftw_complex>(plan);
+            if (ok) {
+                ExportWisdom();
+                planMutex.FastLock();
+                backgroundPlan = plan;
+                backgroundPlanF = planF;
+                planMutex.FastUnLock();
+                REPORT_ERROR(ErrorManagement::Information, "FFTW plan built in background");
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::Warning, "Could not build the FFTW plan in background. The estimated plan will be kept");
+            }
+        }
+        else {
+            Sleep::Sec(PLANNER_IDLE_TIME);
+        }
+    }
+    return err;
+}
+
+bool FFTGAM::Execute() {
+    if (waitingForPlan) { //Never wait for the planning thread
+        if (planMutex.FastTryLock()) {
+            if (backgroundPlan != NULL_PTR(fftw_plan)) {
+                p = backgroundPlan;
+                waitingForPlan = false;
+            }
+            if (backgroundPlanF != NULL_PTR(fftwf_plan)) {
+                pF = backgroundPlanF;
+                waitingForPlan = false;
+            }
+            planMutex.FastUnLock();
+        }
+    }
+    if (filterMode) {
+        if (StageInput(in, ring, window, stageFunctions)) {
+            fftw_execute_dft_r2c(p, in, out);
+            Filter();
+        }
+    }
+    else if (singlePrecision) {
+        if (StageInput(inF, ringF, windowF, stageFunctionsF)) {
+            fftwf_execute_dft_r2c(pF, inF, outF);
+            WriteProducts(outF);
+            WriteCrossProducts(outF);
+            if (numberOfPeaks > 0u) {
+                WritePeaks(outF);
+            }
+        }
+    }
+    else {
+        if (StageInput(in, ring, window, stageFunctions)) {
+            fftw_execute_dft_r2c(p, in, out);
+            WriteProducts(out);
+            WriteCrossProducts(out);
+            if (numberOfPeaks > 0u) {
+                WritePeaks(out);
+            }
+        }
     }
     return true;
 }
 
+bool FFTGAM::GetPlannerFlag(const StreamString &name, uint32 &flag) {
+    static const char8 * const plannerNames[] = { "Estimate", "Measure", "Patient", "Exhaustive" };
+    static const uint32 plannerFlags[] = { FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT, FFTW_EXHAUSTIVE };
+    uint32 k;
+    for (k = 0u; (k < 4u) && (name != plannerNames[k]); k++) {
+    }
+    bool ok = (k < 4u);
+    if (ok) {
+        flag = plannerFlags[k];
+    }
+    return ok;
+}
+
+bool FFTGAM::GetCrossProduct(const StreamString &name, FFTGAMCrossProduct &product) {
+    static const char8 * const crossProductNames[] = { "CrossPower", "PhaseDifference", "Coherence" };
+    static const FFTGAMCrossProduct crossProductCodes[] = { FFTGAMCrossPower, FFTGAMPhaseDifference, FFTGAMCoherence };
+    uint32 k;
+    for (k = 0u; (k < 3u) && (name != crossProductNames[k]); k++) {
+    }
+    bool ok = (k < 3u);
+    if (ok) {
+        product = crossProductCodes[k];
+    }
+    return ok;
+}
+
+bool FFTGAM::GetProduct(const StreamString &name, FFTGAMProduct &product) {
+    static const char8 * const productNames[] = { "Complex", "Power", "Magnitude", "Phase", "dB" };
+    static const FFTGAMProduct productCodes[] = { FFTGAMComplex, FFTGAMPower, FFTGAMMagnitude, FFTGAMPhase, FFTGAMdB };
+    uint32 k;
+    for (k = 0u; (k < 5u) && (name != productNames[k]); k++) {
+    }
+    bool ok = (k < 5u);
+    if (ok) {
+        product = productCodes[k];
+    }
+    return ok;
+}
+
+void FFTGAM::MirrorProduct(const FFTGAMProduct product, float64 * const dest, const uint32 fftSize) {
+    //X[N - i] = conj(X[i]) for a real input
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    if (product == FFTGAMComplex) {
+        for (uint32 i = numberOfBins; i < fftSize; i++) {
+            dest[2u * i] = dest[2u * (fftSize - i)];
+            dest[(2u * i) + 1u] = -dest[(2u * (fftSize - i)) + 1u];
+        }
+    }
+    else if (product == FFTGAMPhase) {
+        for (uint32 i = numberOfBins; i < fftSize; i++) {
+            dest[i] = -dest[fftSize - i];
+        }
+    }
+    else {
+        for (uint32 i = numberOfBins; i < fftSize; i++) {
+            dest[i] = dest[fftSize - i];
+        }
+    }
+}
+
+bool FFTGAM::CreateWindow() {
+    //Generalised cosine windows: w[i] = a0 - a1 cos(x) + a2 cos(2x) - a3 cos(3x) + a4 cos(4x), x = 2 pi i / N
+    static const char8 * const windowNames[] = { "Hann", "Hamming", "BlackmanHarris", "FlatTop" };
+    static const double windowCoefficients[][5] = {
+        { 0.5, 0.5, 0., 0., 0. },
+        { 0.54, 0.46, 0., 0., 0. },
+        { 0.35875, 0.48829, 0.14128, 0.01168, 0. },
+        { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 }
+    };
+    bool ok = true;
+    if ((windowName.Size() > 0u) && (windowName != "Rectangular")) {
+        uint32 w;
+        for (w = 0u; (w < 4u) && (windowName != windowNames[w]); w++) {
+        }
+        ok = (w < 4u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Unknown Window %s. Possible values are Rectangular, Hann, Hamming, BlackmanHarris, FlatTop",
+                         windowName.Buffer());
+        }
+        if (ok) {
+            window = (double *)fftw_malloc(sizeof(double) * fftSize);
+            ok = (window != NULL_PTR(double *));
+        }
+        if (ok) {
+            const double *a = windowCoefficients[w];
+            for (uint32 i = 0u; i < fftSize; i++) {
+                double x = (2. * M_PI * i) / fftSize;
+                window[i] = a[0] - (a[1] * cos(x)) + (a[2] * cos(2. * x)) - (a[3] * cos(3. * x)) + (a[4] * cos(4. * x));
+            }
+        }
+    }
+    return ok;
+}
+
 bool FFTGAM::Initialise(StructuredDataI & data) {
     bool ok = GAM::Initialise(data);
+    if (ok) {
+        if (!data.Read("NumberOfChannels", numberOfChannels)) {
+            numberOfChannels = 0u;
+        }
+        if (!data.Read("WindowLength", fftSize)) {
+            fftSize = 0u;
+        }
+        if (!data.Read("HopSize", hopSize)) {
+            hopSize = 0u;
+        }
+        if (!data.Read("Window", windowName)) {
+            windowName = "Rectangular";
+        }
+        StreamString precision;
+        if (data.Read("Precision", precision)) {
+            ok = (precision == "Single") || (precision == "Double");
+            if (ok) {
+                singlePrecision = (precision == "Single");
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unknown Precision %s. Possible values are Single, Double", precision.Buffer());
+            }
+        }
+        StreamString plannerName;
+        if (ok && data.Read("Planner", plannerName)) {
+            ok = GetPlannerFlag(plannerName, plannerFlag);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unknown Planner %s. Possible values are Estimate, Measure, Patient, Exhaustive",
+                             plannerName.Buffer());
+            }
+        }
+        if (data.Read("PlanningTimeLimit", planningTimeLimit)) {
+            if (planningTimeLimit <= 0.) {
+                planningTimeLimit = FFTW_NO_TIMELIMIT;
+            }
+        }
+        if (!data.Read("WisdomFile", wisdomFile)) {
+            wisdomFile = "";
+        }
+        if (!data.Read("BackgroundPlanning", backgroundPlanning)) {
+            backgroundPlanning = 0u;
+        }
+        if (!data.Read("NumberOfThreads", numberOfThreads)) {
+            numberOfThreads = 1u;
+        }
+        if (numberOfThreads == 0u) {
+            numberOfThreads = 1u;
+        }
+        if ((backgroundPlanning == 1u) || (numberOfThreads > 1u)) { //read the planning and helper threads parameters
+            if (!data.Read("StackSize", stackSize)) {
+                REPORT_ERROR(ErrorManagement::Information, "No StackSize defined. Using default = %d", stackSize);
+            }
+        }
+        if (backgroundPlanning == 1u) {
+            if (!data.Read("CPUs", cpuMask)) {
+                REPORT_ERROR(ErrorManagement::Information, "No CPUs defined. Using default = %d", cpuMask);
+            }
+            executor.SetStackSize(stackSize);
+            executor.SetCPUMask(cpuMask);
+        }
+        if (numberOfThreads > 1u) {
+            if (!data.Read("ThreadsCPUs", threadsCpuMask)) {
+                REPORT_ERROR(ErrorManagement::Information, "No ThreadsCPUs defined. Using default = %d", threadsCpuMask);
+            }
+        }
+    }
+    if (ok) {
+        StreamString mode;
+        if (data.Read("Mode", mode)) {
+            ok = (mode == "Spectrum") || (mode == "Filter");
+            if (ok) {
+                filterMode = (mode == "Filter");
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Unknown Mode %s. Possible values are Spectrum, Filter", mode.Buffer());
+            }
+        }
+    }
+    if (ok) {
+        ok = ReadCrossProducts(data);
+    }
+    if (ok) {
+        ok = ReadPeaks(data);
+    }
+    if (ok && filterMode) {
+        ok = (numberOfPairs == 0u) && (numberOfPeaks == 0u);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "CrossPairs and Peaks cannot be specified with Mode = Filter");
+        }
+    }
+    if (ok && filterMode) {
+        ok = ReadFilter(data);
+    }
+    else if (ok) {
+        AnyType outputsDescription = data.GetType("Outputs");
+        if (outputsDescription.GetDataPointer() != NULL_PTR(void *)) {
+            numberOfProducts = outputsDescription.GetNumberOfElements(0u);
+            ok = (numberOfProducts > 0u);
+            Vector<StreamString> productNames(numberOfProducts);
+            if (ok) {
+                ok = data.Read("Outputs", productNames);
+            }
+            if (ok) {
+                products = new FFTGAMProduct[numberOfProducts];
+                for (uint32 k = 0u; (k < numberOfProducts) && ok; k++) {
+                    ok = GetProduct(productNames[k], products[k]);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::ParametersError, "Unknown output %s. Possible values are Complex, Power, Magnitude, Phase, dB",
+                                     productNames[k].Buffer());
+                    }
+                }
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read Outputs");
+            }
+        }
+        else if ((numberOfPairs > 0u) || (numberOfPeaks > 0u)) { //Only the cross products and the peaks
+            numberOfProducts = 0u;
+        }
+        else { //Magnitude and phase
+            numberOfProducts = 2u;
+            products = new FFTGAMProduct[numberOfProducts];
+            products[0] = FFTGAMMagnitude;
+            products[1] = FFTGAMPhase;
+        }
+    }
     return ok;
 }
 
@@ -27,13 +27,19 @@
 /*---------------------------------------------------------------------------*/
 /*                        Standard header includes                           */
 /*---------------------------------------------------------------------------*/
+#include <string.h>
 
 /*---------------------------------------------------------------------------*/
 /*                        Project header includes                            */
 /*---------------------------------------------------------------------------*/
+#include "AdvancedErrorManagement.h"
 #include "GAM.h"
 #include "StructuredDataI.h"
 #include "MessageI.h"
+#include "EmbeddedServiceMethodBinderI.h"
+#include "FastPollingMutexSem.h"
+#include "SingleThreadService.h"
+#include "FFTGAMThreadPool.h"
 #include <math.h>
 #include <fftw3.h>
 /*---------------------------------------------------------------------------*/
@@ -41,7 +47,126 @@
 /*---------------------------------------------------------------------------*/
 
 namespace MARTe {
-class FFTGAM : public GAM {
+/**
+ * Spectral products which can be produced by the FFTGAM.
+ */
+enum FFTGAMProduct {
+    FFTGAMComplex = 0, //Real and imaginary part (two elements per bin)
+    FFTGAMPower, //|X|^2
+    FFTGAMMagnitude, //|X|
+    FFTGAMPhase, //arg(X)
+    FFTGAMdB //10 log10(|X|^2)
+};
+
+/**
+ * Cross-spectral products which can be produced by the FFTGAM for a pair of channels (a, b).
+ */
+enum FFTGAMCrossProduct {
+    FFTGAMCrossPower = 0, //Xa conj(Xb), real and imaginary part (two elements per bin)
+    FFTGAMPhaseDifference, //arg(Xa conj(Xb))
+    FFTGAMCoherence //|<Xa conj(Xb)>|^2 / (<|Xa|^2> <|Xb|^2>), <> exponential average across transforms
+};
+
+/**
+ * Refinement of the spectral peaks found by the FFTGAM.
+ */
+enum FFTGAMPeakInterpolation {
+    FFTGAMPeakNone = 0, //Frequency and amplitude of the bin
+    FFTGAMPeakParabolic, //Parabola through the magnitude of the bin and of its neighbours
+    FFTGAMPeakGaussian //Parabola through the log magnitude (exact for a Gaussian window)
+};
+
+/**
+ * @brief Computes the FFT (magnitude, phase or any other FFTGAMProduct) of one or more channels.
+ * @details The channels are either N input signals (each 1D or scalar with multiple samples) or a single 2D input signal holding
+ * NumberOfChannels rows of samples. All the channels shall have the same number of samples and are transformed by a single batched FFTW plan.
+ * For every input signal there shall be a float64 output signal for every product listed in Outputs (in the same order), with
+ * WindowLength / 2 + 1 elements (the non-redundant half spectrum of the real input) for each channel, twice as many for Complex.
+ * Outputs with WindowLength elements (or 2 * WindowLength for Complex) are also accepted: the redundant half is then filled by symmetry.
+ * Only the requested products are computed (e.g. Power does not compute any square root, the phase is computed only if requested).
+ * With Precision = Single the transform is computed in single precision (fftwf), which halves the memory traffic and doubles the SIMD width.
+ * This is allowed only if all the inputs are float32, int16 or uint16, which are exactly represented. The outputs are still float64.
+ * CrossPairs lists pairs of channels (indexes from 0, as they are transformed) whose CrossOutputs (CrossPower, PhaseDifference, Coherence) are
+ * computed from the same transforms. For every cross product there shall be one more float64 output signal (after the per-channel outputs) with
+ * WindowLength / 2 + 1 elements (twice as many for CrossPower) for each pair. The coherence is computed from the cross and auto power spectra averaged
+ * with weight CoherenceAveraging (default 0.1) for the last transform. If CrossPairs is specified and Outputs is not, no per-channel output is produced.
+ * If Peaks (K) is specified, the K largest local maxima of the magnitude above PeakThreshold are found in the spectrum of each channel, refined by
+ * PeakInterpolation (None, Parabolic, Gaussian) and written as (frequency, amplitude, phase) triples, largest first, to one more float64 output signal
+ * for each input signal (after the cross outputs) with 3 * K elements for each channel. The frequency is in Hz if SamplingFrequency is specified,
+ * in (fractional) bins otherwise. The amplitude is the (interpolated) magnitude, not corrected for the window gain, the phase is the one of the bin.
+ * The unused triples are zero. If Peaks is specified and Outputs is not, no per-channel spectrum is produced.
+ * With Mode = Filter the GAM is instead a FIR filter computed in the frequency domain (overlap-save): every cycle the last WindowLength samples
+ * of each channel are transformed, multiplied by the frequency response of the filter, transformed back and the last samples (as many as the samples
+ * per cycle) are written to the output signal, which shall be float64 with the same number of elements of the input signal (one output per input).
+ * The filter is given either as FilterTaps (impulse response, up to WindowLength - samples per cycle + 1 taps, WindowLength defaults to the smallest
+ * power of two holding samples per cycle + taps - 1) or as FilterResponse (WindowLength / 2 + 1 complex gains, real and imaginary part interleaved).
+ * Both can be evaluated from an MDSplus expression instead (FilterTree, FilterShot, FilterExpr, FilterExprType = Taps or Response).
+ * The filter mode requires Precision = Double, the Rectangular window and no background planning.
+ * Very large transforms can be split among NumberOfThreads threads (the real-time thread and NumberOfThreads - 1 helpers). The helpers run
+ * with the ThreadsCPUs mask, so that they stay off the cores of the other real-time threads (see FFTGAMThreadPool). The helpers are shared by all
+ * the FFTGAM instances and are created with the parameters of the first instance using them. Small transforms do not benefit from threads.
+ *
+ * By default each cycle transforms the samples received in the cycle. If WindowLength is larger than the number of samples per cycle (short-time
+ * Fourier transform), the last WindowLength samples of each channel are kept in a ring and a transform of the whole window is computed every HopSize
+ * samples (the outputs hold the last spectrum in between). Until the ring is filled the missing samples are zero.
+ * Before the transform the samples are multiplied by the (periodic) Window: Rectangular (default), Hann, Hamming, BlackmanHarris or FlatTop.
+ *
+ * The plan is built in Setup with the Planner rigour (Estimate, Measure, Patient or Exhaustive), within PlanningTimeLimit seconds if specified.
+ * If WisdomFile is specified the FFTW wisdom is imported from it before planning and exported to it (atomically) after planning, so that the
+ * following runs get the same plan in a fraction of the time (single and double precision wisdom are different: do not share the file). With BackgroundPlanning = 1 Setup does not wait for the planner: unless the wisdom
+ * already holds the plan, an estimated plan is used until the planned one is built by a low priority thread (CPUs, StackSize) and then swapped in.
+ *
+ * <pre>
+ * +FFT = {
+ *     Class = FFTGAM
+ *     NumberOfChannels = 32 // Compulsory only if the input signal is 2D.
+ *     WindowLength = 8192 // Optional. Number of samples transformed. Shall be a multiple of the samples per cycle. Default the samples per cycle.
+ *     HopSize = 1024 // Optional. Samples between two transforms. Shall be a multiple of the samples per cycle. Default the samples per cycle.
+ *     Window = Hann // Optional. Rectangular, Hann, Hamming, BlackmanHarris or FlatTop. Default Rectangular.
+ *     Outputs = { Magnitude Phase } // Optional. Any of Complex, Power, Magnitude, Phase, dB. Default { Magnitude Phase }.
+ *     Planner = Patient // Optional. Estimate, Measure, Patient or Exhaustive. Default Measure.
+ *     PlanningTimeLimit = 5.0 // Optional. Maximum planning time in seconds. Default no limit.
+ *     WisdomFile = "/var/lib/marte/fftw.wisdom" // Optional. File the FFTW wisdom is imported from and exported to.
+ *     BackgroundPlanning = 1 // Optional. If 1 the plan is built by a separate thread. Default 0.
+ *     Precision = Single // Optional. Single or Double. Default Double.
+ *     CrossPairs = { {0 1} {0 2} } // Optional. Pairs of channels.
+ *     CrossOutputs = { PhaseDifference Coherence } // Optional. Any of CrossPower, PhaseDifference, Coherence. Default { PhaseDifference Coherence }.
+ *     CoherenceAveraging = 0.05 // Optional. Weight of the last transform in the averaged spectra (0, 1]. Default 0.1.
+ *     Peaks = 4 // Optional. Number of peaks for each channel. Default 0 (no peak output).
+ *     PeakThreshold = 1e-3 // Optional. Minimum magnitude of a peak. Default 0.
+ *     PeakInterpolation = Gaussian // Optional. None, Parabolic or Gaussian. Default Parabolic.
+ *     SamplingFrequency = 1e6 // Optional. If specified the peak frequencies are in Hz.
+ *     NumberOfThreads = 4 // Optional. Number of threads computing each transform. Default 1.
+ *     ThreadsCPUs = 0xf0 // Optional. CPU mask of the helper threads. Default 0xff.
+ *     CPUs = 0x1 // Optional. CPU mask of the planning thread. Default 0xff.
+ *     InputSignals = {
+ *         Probes = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 32768 Type = float32 } // 32 x 1024
+ *     }
+ *     OutputSignals = {
+ *         ProbesMod = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 131104 Type = float64 } // 32 x 4097
+ *         ProbesPhase = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 131104 Type = float64 }
+ *     }
+ * }
+ * </pre>
+ *
+ * <pre>
+ * +LowPass = {
+ *     Class = FFTGAM
+ *     Mode = Filter
+ *     FilterTree = filters // Optional. Evaluate the filter from FilterExpr instead of FilterTaps.
+ *     FilterShot = -1
+ *     FilterExpr = "FILTERS:LOWPASS_2K"
+ *     FilterExprType = Taps // Optional. Taps or Response. Default Taps.
+ *     InputSignals = {
+ *         Probe = { DataSource = DDB NumberOfDimensions = 1 NumberOfElements = 1024 Type = int16 }
+ *     }
+ *     OutputSignals = {
+ *         ProbeFiltered = { DataSource = DDB NumberOfDimensions = 1 NumberOfElements = 1024 Type = float64 }
+ *     }
+ * }
+ * </pre>
+ */
+class FFTGAM : public GAM, public EmbeddedServiceMethodBinderI {
 public:
     CLASS_REGISTER_DECLARATION()
 
@@ -54,14 +179,330 @@ public:
     virtual bool Execute();
 
     virtual bool Initialise(StructuredDataI & data);
-    float64 *outSignalMemory[2];
-    void *inSignalMemory;
 
-    TypeDescriptor inputType;
+    /**
+     * @brief Callback of the planning thread (BackgroundPlanning = 1). Builds the plan once, then idles until stopped.
+     */
+    virtual ErrorManagement::ErrorType Execute(ExecutionInfo &info);
+
+    /**
+     * @brief Builds the batched plan for the given arrays with the given planner flags, serialising the access to the (global) FFTW planner.
+     * @return true if the plan was created.
+     */
+    bool CreatePlan(const uint32 flags, double * const planIn, fftw_complex * const planOut, fftw_plan &plan) const;
+    bool CreatePlan(const uint32 flags, float * const planIn, fftwf_complex * const planOut, fftwf_plan &plan) const;
+
+    /**
+     * @brief Imports the wisdom from WisdomFile, if specified.
+     */
+    void ImportWisdom() const;
+
+    /**
+     * @brief Exports the wisdom to WisdomFile, if specified. The file is written to a temporary file which is then renamed.
+     */
+    void ExportWisdom() const;
+
+    /**
+     * @brief Gets the planner flag from its name.
+     * @return false if the name is unknown.
+     */
+    static bool GetPlannerFlag(const StreamString &name, uint32 &flag);
+
+    /**
+     * Kernels converting the input samples of a channel to double or float.
+     */
+    typedef void (*StageFunction)(const void * const source, double * const dest, const uint32 nSamples, const uint32 sampleOffset);
+    typedef void (*StageFunctionF)(const void * const source, float * const dest, const uint32 nSamples, const uint32 sampleOffset);
+
+    /**
+     * @brief Converts nSamples samples of type T, starting at sampleOffset, to R.
+     */
+    template<typename T, typename R>
+    static void StageSamples(const void * const source, R * const dest, const uint32 nSamples, const uint32 sampleOffset);
+
+    /**
+     * @brief Selects the StageSamples kernel for the input type.
+     * @return false if the type is not supported.
+     */
+    template<typename R>
+    static bool GetStageFunction(const TypeDescriptor &type, void (*&stageFunction)(const void * const, R * const, const uint32, const uint32));
+
+    /**
+     * @brief Stages the samples received in this cycle (in the ring, if any) and, if a transform is due, copies the windowed samples to inBlock.
+     * @return true if a transform is due.
+     */
+    template<typename R>
+    bool StageInput(R * const inBlock, R * const ringBlock, const R * const windowTable,
+                    void (* const * const stage)(const void * const, R * const, const uint32, const uint32));
+
+    /**
+     * @brief Computes the products of every channel from the transformed block.
+     */
+    template<typename C>
+    void WriteProducts(const C * const outBlock);
+
+    /**
+     * @brief Computes the cross products of every pair from the transformed block (and updates the averaged spectra).
+     */
+    template<typename C>
+    void WriteCrossProducts(const C * const outBlock);
+
+    /**
+     * @brief Finds the peaks of every channel in the transformed block and writes their triples.
+     */
+    template<typename C>
+    void WritePeaks(const C * const outBlock);
+
+    /**
+     * @brief Reads Peaks, PeakThreshold, PeakInterpolation and SamplingFrequency.
+     * @return false if they are not valid.
+     */
+    bool ReadPeaks(StructuredDataI &data);
+
+    /**
+     * @brief Checks and binds the peak output signal of the signalChannels channels starting from firstChannelIdx.
+     * @return false if the signal is not valid.
+     */
+    bool SetupPeakOutput(const uint32 outSignalIdx, const uint32 firstChannelIdx, const uint32 signalChannels);
+
+    /**
+     * @brief Gets the cross product from its name.
+     * @return false if the name is unknown.
+     */
+    static bool GetCrossProduct(const StreamString &name, FFTGAMCrossProduct &product);
+
+    /**
+     * @brief Allocates (with fftw_malloc) and clears a block of nElements elements.
+     * @return false if the memory could not be allocated.
+     */
+    template<typename R>
+    static bool AllocateBlock(R *&block, const uint32 nElements);
+
+    /**
+     * @brief Allocates the in and out blocks, imports the wisdom and builds the plan (or the initial plan for background planning).
+     */
+    template<typename R, typename C, typename P>
+    bool PlanTransform(R *&inBlock, C *&outBlock, P &plan, P &initial);
+
+    /**
+     * @brief Builds the plan with the planner rigour on scratch blocks with the same layout of in and out.
+     */
+    template<typename R, typename C, typename P>
+    bool PlanOnScratch(P &plan) const;
+
+    /**
+     * @brief Gets the product from its name.
+     * @return false if the name is unknown.
+     */
+    static bool GetProduct(const StreamString &name, FFTGAMProduct &product);
+
+    /**
+     * @brief Computes a product of the half spectrum.
+     * @param[in] product the product.
+     * @param[in] bins the numberOfBins complex bins (fftw_complex or fftwf_complex).
+     * @param[out] dest the product (numberOfBins elements, 2 * numberOfBins for FFTGAMComplex).
+     */
+    template<typename C>
+    static void ComputeProduct(const FFTGAMProduct product, const C * const bins, const uint32 numberOfBins, float64 * const dest);
+
+    /**
+     * @brief Fills the redundant half of a product computed by ComputeProduct for a real input of fftSize samples.
+     */
+    static void MirrorProduct(const FFTGAMProduct product, float64 * const dest, const uint32 fftSize);
+
+    /**
+     * @brief Reads CrossPairs, CrossOutputs and CoherenceAveraging.
+     * @return false if they are not valid.
+     */
+    bool ReadCrossProducts(StructuredDataI &data);
+
+    /**
+     * @brief Checks the pairs and binds the cross output signals, starting from firstOutputIdx.
+     * @return false if the pairs or the signals are not valid.
+     */
+    bool SetupCrossProducts(const uint32 firstOutputIdx);
+
+    /**
+     * @brief Filter mode: checks the filter against the samples per cycle and computes WindowLength (if not specified).
+     * @return false if the filter does not fit.
+     */
+    bool SetupFilterSize();
+
+    /**
+     * @brief Filter mode: computes the frequency response (scaled by 1 / WindowLength) and builds the inverse plan.
+     * @return false if the plan could not be created.
+     */
+    bool SetupFilter();
+
+    /**
+     * @brief Filter mode: applies the response to the transformed block, transforms back and writes the filtered samples.
+     */
+    void Filter();
+
+    /**
+     * @brief Filter mode: reads the filter from the configuration or from MDSplus.
+     * @return false if the filter is not specified or is not valid.
+     */
+    bool ReadFilter(StructuredDataI &data);
+
+    /**
+     * @brief Evaluates the filter (taps or response) from an MDSplus expression.
+     * @return false if the tree could not be opened or the expression could not be evaluated.
+     */
+    bool LoadFilter(const StreamString &treeName, const int32 shotNumber, const StreamString &expression);
+
+    /**
+     * @brief Computes the window table.
+     * @return false if the window name is unknown.
+     */
+    bool CreateWindow();
+
+    /**
+     * Input memory and staging kernel (selected from the input type in Setup) of each channel.
+     */
+    void **inSignalMemory;
+    StageFunction *stageFunctions;
+    StageFunctionF *stageFunctionsF;
+
+    /**
+     * The products to be computed.
+     */
+    FFTGAMProduct *products;
+    uint32 numberOfProducts;
+
+    /**
+     * Output memory of each product and channel (index product * numberOfChannels + channel) and whether the full spectrum shall be written.
+     */
+    float64 **outSignalMemory;
+    bool *outFullSpectrum;
+
+    /**
+     * Number of channels and of samples of each channel received every cycle.
+     */
+    uint32 numberOfChannels;
     uint32 numberOfElements;
+
+    /**
+     * Number of samples transformed (WindowLength) and number of samples between two transforms (HopSize).
+     */
+    uint32 fftSize;
+    uint32 hopSize;
+
+    /**
+     * Samples received since the last transform.
+     */
+    uint32 samplesSinceTransform;
+
+    /**
+     * Last fftSize samples of each channel (only if fftSize is larger than numberOfElements) and position of the oldest sample.
+     */
+    double *ring;
+    uint32 ringPos;
+
+    /**
+     * The window name and table (NULL for the rectangular window).
+     */
+    StreamString windowName;
+    double *window;
+
+    /**
+     * Distance between the channels in the in and out blocks. Padded so that every channel is aligned.
+     */
+    uint32 inputStride;
+    uint32 outputStride;
+
     double *in;
     fftw_complex *out;
-    fftw_plan p;  
+    fftw_plan p;
+
+    /**
+     * Single precision path (Precision = Single): blocks, ring, window and plans.
+     */
+    bool singlePrecision;
+    float *inF;
+    fftwf_complex *outF;
+    fftwf_plan pF;
+    float *ringF;
+    float *windowF;
+    fftwf_plan backgroundPlanF;
+    fftwf_plan initialPlanF;
+
+    /**
+     * Planner flag (FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT or FFTW_EXHAUSTIVE), planning time limit (FFTW_NO_TIMELIMIT if not set)
+     * and wisdom file (empty if not set).
+     */
+    uint32 plannerFlag;
+    float64 planningTimeLimit;
+    StreamString wisdomFile;
+
+    /**
+     * Background planning. The plan built by the planning thread is published in backgroundPlan (under planMutex)
+     * and swapped in by the real-time thread (which keeps the estimated plan in initialPlan, to be destroyed at the end).
+     */
+    uint32 backgroundPlanning;
+    SingleThreadService executor;
+    uint32 cpuMask;
+    uint32 stackSize;
+    FastPollingMutexSem planMutex;
+    fftw_plan backgroundPlan;
+    fftw_plan initialPlan;
+    bool waitingForPlan;
+    bool planningDone;
+
+    /**
+     * Channel pairs (two indexes for each pair), cross products and their output memory (all the pairs of a cross product are in one signal).
+     */
+    uint32 numberOfPairs;
+    uint32 *pairs;
+    FFTGAMCrossProduct *crossProducts;
+    uint32 numberOfCrossProducts;
+    float64 **crossOutSignalMemory;
+
+    /**
+     * Weight of the last transform and averaged spectra (real and imaginary part of the cross power, auto powers of a and b) of each pair and bin.
+     * Allocated only if the coherence is requested.
+     */
+    float64 coherenceAveraging;
+    float64 *crossAverage;
+
+    /**
+     * Peak extraction: number of peaks, threshold, interpolation, frequency of a bin (1 if SamplingFrequency is not specified) and output memory of
+     * each channel. The power of the bins and the bins of the peaks found are kept in peakPower and peakBins.
+     */
+    uint32 numberOfPeaks;
+    float64 peakThreshold;
+    FFTGAMPeakInterpolation peakInterpolation;
+    float64 samplingFrequency;
+    float64 **peakOutSignalMemory;
+    float64 *peakPower;
+    uint32 *peakBins;
+
+    /**
+     * Filter mode. The filter coefficients are either the taps or the (interleaved) complex response.
+     */
+    bool filterMode;
+    float64 *filterCoefficients;
+    uint32 numberOfFilterCoefficients;
+    bool filterIsResponse;
+
+    /**
+     * Filter mode: scaled frequency response, inverse plan and its output block (same layout of in).
+     */
+    fftw_complex *response;
+    fftw_plan inversePlan;
+    double *filtered;
+
+    /**
+     * Threads computing each transform, CPU mask of the helpers and whether the helpers were acquired.
+     */
+    uint32 numberOfThreads;
+    uint32 threadsCpuMask;
+    bool threadPoolAcquired;
+
+    /**
+     * The FFTW planner is not thread safe and is shared by all the FFTGAM instances.
+     */
+    static FastPollingMutexSem plannerMutex;
 };
 }
 
@@ -69,5 +510,340 @@ public:
 /*                        Inline method definitions                          */
 /*---------------------------------------------------------------------------*/
 
+namespace MARTe {
+
+template<typename T, typename R>
+void FFTGAM::StageSamples(const void * const source, R * const dest, const uint32 nSamples, const uint32 sampleOffset) {
+    //Single typed loop, vectorised by the compiler
+    const T *samples = &(reinterpret_cast<const T *>(source)[sampleOffset]);
+    for (uint32 j = 0u; j < nSamples; j++) {
+        dest[j] = static_cast<R>(samples[j]);
+    }
+}
+
+template<typename R>
+bool FFTGAM::GetStageFunction(const TypeDescriptor &type, void (*&stageFunction)(const void * const, R * const, const uint32, const uint32)) {
+    bool ok = true;
+    if (type == Float32Bit) {
+        stageFunction = &StageSamples<float32, R>;
+    }
+    else if (type == Float64Bit) {
+        stageFunction = &StageSamples<float64, R>;
+    }
+    else if (type == UnsignedInteger16Bit) {
+        stageFunction = &StageSamples<uint16, R>;
+    }
+    else if (type == SignedInteger16Bit) {
+        stageFunction = &StageSamples<int16, R>;
+    }
+    else if (type == UnsignedInteger32Bit) {
+        stageFunction = &StageSamples<uint32, R>;
+    }
+    else if (type == SignedInteger32Bit) {
+        stageFunction = &StageSamples<int32, R>;
+    }
+    else {
+        ok = false;
+    }
+    return ok;
+}
+
+template<typename R>
+bool FFTGAM::StageInput(R * const inBlock, R * const ringBlock, const R * const windowTable,
+                        void (* const * const stage)(const void * const, R * const, const uint32, const uint32)) {
+    if (ringBlock == NULL_PTR(R *)) { //The window is the cycle
+        for (uint32 c = 0u; c < numberOfChannels; c++) {
+            stage[c](inSignalMemory[c], &inBlock[c * inputStride], numberOfElements, 0u);
+        }
+    }
+    else { //Append to the ring, overwriting the oldest samples
+        uint32 firstPart = fftSize - ringPos;
+        if (firstPart > numberOfElements) {
+            firstPart = numberOfElements;
+        }
+        for (uint32 c = 0u; c < numberOfChannels; c++) {
+            stage[c](inSignalMemory[c], &ringBlock[(c * fftSize) + ringPos], firstPart, 0u);
+            stage[c](inSignalMemory[c], &ringBlock[c * fftSize], numberOfElements - firstPart, firstPart);
+        }
+        ringPos = (ringPos + numberOfElements) % fftSize;
+    }
+    samplesSinceTransform += numberOfElements;
+    bool transform = (samplesSinceTransform >= hopSize);
+    if (transform) {
+        samplesSinceTransform = 0u;
+        for (uint32 c = 0u; c < numberOfChannels; c++) {
+            R *channelIn = &inBlock[c * inputStride];
+            if (ringBlock != NULL_PTR(R *)) { //Oldest sample first
+                const R *channelRing = &ringBlock[c * fftSize];
+                uint32 firstPart = fftSize - ringPos;
+                if (windowTable != NULL_PTR(const R *)) {
+                    for (uint32 i = 0u; i < firstPart; i++) {
+                        channelIn[i] = channelRing[ringPos + i] * windowTable[i];
+                    }
+                    for (uint32 i = firstPart; i < fftSize; i++) {
+                        channelIn[i] = channelRing[i - firstPart] * windowTable[i];
+                    }
+                }
+                else {
+                    memcpy(channelIn, &channelRing[ringPos], firstPart * sizeof(R));
+                    memcpy(&channelIn[firstPart], channelRing, ringPos * sizeof(R));
+                }
+            }
+            else if (windowTable != NULL_PTR(const R *)) {
+                for (uint32 i = 0u; i < fftSize; i++) {
+                    channelIn[i] *= windowTable[i];
+                }
+            }
+            else {
+
+            }
+        }
+    }
+    return transform;
+}
+
+template<typename C>
+void FFTGAM::WriteProducts(const C * const outBlock) {
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    for (uint32 k = 0u; k < numberOfProducts; k++) {
+        for (uint32 c = 0u; c < numberOfChannels; c++) {
+            uint32 outMemoryIdx = (k * numberOfChannels) + c;
+            ComputeProduct(products[k], &outBlock[c * outputStride], numberOfBins, outSignalMemory[outMemoryIdx]);
+            if (outFullSpectrum[outMemoryIdx]) {
+                MirrorProduct(products[k], outSignalMemory[outMemoryIdx], fftSize);
+            }
+        }
+    }
+}
+
+template<typename C>
+void FFTGAM::WriteCrossProducts(const C * const outBlock) {
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    for (uint32 pairIdx = 0u; pairIdx < numberOfPairs; pairIdx++) {
+        const C *binsA = &outBlock[pairs[2u * pairIdx] * outputStride];
+        const C *binsB = &outBlock[pairs[(2u * pairIdx) + 1u] * outputStride];
+        for (uint32 x = 0u; x < numberOfCrossProducts; x++) {
+            float64 *dest = crossOutSignalMemory[x];
+            if (crossProducts[x] == FFTGAMCrossPower) {
+                dest = &dest[2u * numberOfBins * pairIdx];
+                for (uint32 k = 0u; k < numberOfBins; k++) {
+                    dest[2u * k] = (static_cast<float64>(binsA[k][0]) * binsB[k][0]) + (static_cast<float64>(binsA[k][1]) * binsB[k][1]);
+                    dest[(2u * k) + 1u] = (static_cast<float64>(binsA[k][1]) * binsB[k][0]) - (static_cast<float64>(binsA[k][0]) * binsB[k][1]);
+                }
+            }
+            else if (crossProducts[x] == FFTGAMPhaseDifference) {
+                dest = &dest[numberOfBins * pairIdx];
+                for (uint32 k = 0u; k < numberOfBins; k++) {
+                    float64 re = (static_cast<float64>(binsA[k][0]) * binsB[k][0]) + (static_cast<float64>(binsA[k][1]) * binsB[k][1]);
+                    float64 im = (static_cast<float64>(binsA[k][1]) * binsB[k][0]) - (static_cast<float64>(binsA[k][0]) * binsB[k][1]);
+                    dest[k] = atan2(im, re);
+                }
+            }
+            else { //Coherence. The averages start from zero: the ratio is not biased by the missing history
+                dest = &dest[numberOfBins * pairIdx];
+                float64 *average = &crossAverage[4u * numberOfBins * pairIdx];
+                float64 weight = coherenceAveraging;
+                for (uint32 k = 0u; k < numberOfBins; k++) {
+                    float64 reA = binsA[k][0];
+                    float64 imA = binsA[k][1];
+                    float64 reB = binsB[k][0];
+                    float64 imB = binsB[k][1];
+                    float64 *avg = &average[4u * k];
+                    avg[0] += weight * (((reA * reB) + (imA * imB)) - avg[0]);
+                    avg[1] += weight * (((imA * reB) - (reA * imB)) - avg[1]);
+                    avg[2] += weight * (((reA * reA) + (imA * imA)) - avg[2]);
+                    avg[3] += weight * (((reB * reB) + (imB * imB)) - avg[3]);
+                    float64 autoPower = avg[2] * avg[3];
+                    dest[k] = (autoPower > 0.) ? (((avg[0] * avg[0]) + (avg[1] * avg[1])) / autoPower) : 0.;
+                }
+            }
+        }
+    }
+}
+
+template<typename C>
+void FFTGAM::WritePeaks(const C * const outBlock) {
+    uint32 numberOfBins = (fftSize / 2u) + 1u;
+    float64 thresholdPower = peakThreshold * peakThreshold;
+    float64 binWidth = (samplingFrequency > 0.) ? (samplingFrequency / fftSize) : 1.;
+    for (uint32 c = 0u; c < numberOfChannels; c++) {
+        const C *bins = &outBlock[c * outputStride];
+        for (uint32 k = 0u; k < numberOfBins; k++) {
+            float64 re = bins[k][0];
+            float64 im = bins[k][1];
+            peakPower[k] = (re * re) + (im * im);
+        }
+        //Local maxima, kept sorted (largest first) in the numberOfPeaks slots
+        uint32 found = 0u;
+        for (uint32 k = 1u; (k + 1u) < numberOfBins; k++) {
+            float64 power = peakPower[k];
+            if ((power > thresholdPower) && (power > peakPower[k - 1u]) && (power >= peakPower[k + 1u])) {
+                if ((found < numberOfPeaks) || (power > peakPower[peakBins[numberOfPeaks - 1u]])) {
+                    uint32 pos = (found < numberOfPeaks) ? found : (numberOfPeaks - 1u);
+                    while ((pos > 0u) && (peakPower[peakBins[pos - 1u]] < power)) {
+                        peakBins[pos] = peakBins[pos - 1u];
+                        pos--;
+                    }
+                    peakBins[pos] = k;
+                    if (found < numberOfPeaks) {
+                        found++;
+                    }
+                }
+            }
+        }
+        float64 *dest = peakOutSignalMemory[c];
+        for (uint32 i = 0u; i < numberOfPeaks; i++) {
+            float64 frequency = 0.;
+            float64 amplitude = 0.;
+            float64 phase = 0.;
+            if (i < found) {
+                uint32 k = peakBins[i];
+                float64 delta = 0.;
+                amplitude = sqrt(peakPower[k]);
+                if (peakInterpolation == FFTGAMPeakParabolic) {
+                    float64 left = sqrt(peakPower[k - 1u]);
+                    float64 right = sqrt(peakPower[k + 1u]);
+                    float64 curvature = (left - (2. * amplitude)) + right;
+                    if (curvature < 0.) {
+                        delta = (0.5 * (left - right)) / curvature;
+                        amplitude -= 0.25 * (left - right) * delta;
+                    }
+                }
+                else if ((peakInterpolation == FFTGAMPeakGaussian) && (peakPower[k - 1u] > 0.) && (peakPower[k + 1u] > 0.)) {
+                    float64 left = 0.5 * log(peakPower[k - 1u]);
+                    float64 centre = 0.5 * log(peakPower[k]);
+                    float64 right = 0.5 * log(peakPower[k + 1u]);
+                    float64 curvature = (left - (2. * centre)) + right;
+                    if (curvature < 0.) {
+                        delta = (0.5 * (left - right)) / curvature;
+                        amplitude = exp(centre - (0.25 * (left - right) * delta));
+                    }
+                }
+                else {
+
+                }
+                frequency = (k + delta) * binWidth;
+                phase = atan2(static_cast<float64>(bins[k][1]), static_cast<float64>(bins[k][0]));
+            }
+            dest[3u * i] = frequency;
+            dest[(3u * i) + 1u] = amplitude;
+            dest[(3u * i) + 2u] = phase;
+        }
+    }
+}
+
+template<typename C>
+void FFTGAM::ComputeProduct(const FFTGAMProduct product, const C * const bins, const uint32 numberOfBins, float64 * const dest) {
+    //Lowest power reported in dB, to avoid log10(0)
+    static const float64 minPower = 1e-300;
+    switch (product) {
+    case FFTGAMComplex:
+        for (uint32 i = 0u; i < numberOfBins; i++) {
+            dest[2u * i] = bins[i][0];
+            dest[(2u * i) + 1u] = bins[i][1];
+        }
+        break;
+    case FFTGAMPower:
+        for (uint32 i = 0u; i < numberOfBins; i++) {
+            float64 re = bins[i][0];
+            float64 im = bins[i][1];
+            dest[i] = (re * re) + (im * im);
+        }
+        break;
+    case FFTGAMMagnitude:
+        for (uint32 i = 0u; i < numberOfBins; i++) {
+            float64 re = bins[i][0];
+            float64 im = bins[i][1];
+            dest[i] = sqrt((re * re) + (im * im));
+        }
+        break;
+    case FFTGAMPhase:
+        for (uint32 i = 0u; i < numberOfBins; i++) {
+            dest[i] = atan2(static_cast<float64>(bins[i][1]), static_cast<float64>(bins[i][0]));
+        }
+        break;
+    case FFTGAMdB:
+        for (uint32 i = 0u; i < numberOfBins; i++) {
+            float64 re = bins[i][0];
+            float64 im = bins[i][1];
+            float64 power = (re * re) + (im * im);
+            dest[i] = 10. * log10((power > minPower) ? power : minPower);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+template<typename R>
+bool FFTGAM::AllocateBlock(R *&block, const uint32 nElements) {
+    //fftw_malloc and fftwf_malloc give the same (SIMD) alignment
+    block = reinterpret_cast<R *>(fftw_malloc(sizeof(R) * nElements));
+    bool ok = (block != NULL_PTR(R *));
+    if (ok) {
+        memset(block, 0, sizeof(R) * nElements);
+    }
+    return ok;
+}
+
+template<typename R, typename C, typename P>
+bool FFTGAM::PlanTransform(R *&inBlock, C *&outBlock, P &plan, P &initial) {
+    bool ok = AllocateBlock(inBlock, inputStride * numberOfChannels);
+    if (ok) {
+        ok = AllocateBlock(outBlock, outputStride * numberOfChannels);
+    }
+    if (ok) {
+        ImportWisdom();
+        if (backgroundPlanning == 1u) {
+            //Use the wisdom if it already holds the plan, otherwise start with an estimated plan and let the thread do the planning
+            if (!CreatePlan(plannerFlag | FFTW_WISDOM_ONLY, inBlock, outBlock, plan)) {
+                ok = CreatePlan(FFTW_ESTIMATE, inBlock, outBlock, plan);
+                if (ok) {
+                    initial = plan;
+                    waitingForPlan = true;
+                    ok = (executor.Start() == ErrorManagement::NoError);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::FatalError, "Could not start the planning thread");
+                    }
+                }
+            }
+        }
+        else {
+            ok = CreatePlan(plannerFlag, inBlock, outBlock, plan);
+            if (ok && (plannerFlag != FFTW_ESTIMATE)) {
+                ExportWisdom();
+            }
+        }
+    }
+    if (ok) { //The planner may have overwritten the blocks
+        memset(inBlock, 0, sizeof(R) * inputStride * numberOfChannels);
+        memset(outBlock, 0, sizeof(C) * outputStride * numberOfChannels);
+    }
+    return ok;
+}
+
+template<typename R, typename C, typename P>
+bool FFTGAM::PlanOnScratch(P &plan) const {
+    //The planner overwrites the blocks: plan on scratch blocks with the same layout (and alignment)
+    R *planIn = NULL_PTR(R *);
+    C *planOut = NULL_PTR(C *);
+    bool ok = AllocateBlock(planIn, inputStride * numberOfChannels);
+    if (ok) {
+        ok = AllocateBlock(planOut, outputStride * numberOfChannels);
+    }
+    if (ok) {
+        ok = CreatePlan(plannerFlag, planIn, planOut, plan);
+    }
+    if (planIn != NULL_PTR(R *)) {
+        fftw_free(planIn);
+    }
+    if (planOut != NULL_PTR(C *)) {
+        fftw_free(planOut);
+    }
+    return ok;
+}
+
+}
+
 #endif 
 	
@@ -0,0 +1,201 @@
+/**
+ * @file FFTGAMBenchmark.cpp
+ * @brief Standalone benchmark of FFTGAM::Execute against the transform size and NumberOfThreads
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details For every transform size and every NumberOfThreads a one GAM
+ * RealTimeApplication is configured and FFTGAM::Execute is called in a loop
+ * from the main thread, which stands for the real-time thread. The table of
+ * the cycle times (minimum, median and maximum, in microseconds) is written
+ * to the standard output.
+ *
+ * Built by "make -f Makefile.linux benchmark" and run as
+ * FFTGAMBenchmark.ex [NumberOfCycles (default 200)] [ThreadsCPUs (default 0xfe)]
+ * preferably pinned to a CPU outside ThreadsCPUs (e.g. with taskset 0x1).
+ */
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+#include "AdvancedErrorManagement.h"
+#include "ConfigurationDatabase.h"
+#include "FFTGAM.h"
+#include "HighResolutionTimer.h"
+#include "ObjectRegistryDatabase.h"
+#include "RealTimeApplication.h"
+#include "StandardParser.h"
+#include "StreamString.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+using namespace MARTe;
+
+/**
+ * Transform sizes (samples per cycle) and thread counts measured.
+ */
+static const uint32 Sizes[] = { 4096u, 16384u, 65536u, 262144u, 1048576u };
+static const uint32 NumberOfSizes = sizeof(Sizes) / sizeof(Sizes[0]);
+static const uint32 ThreadCounts[] = { 1u, 2u, 4u, 8u };
+static const uint32 NumberOfThreadCounts = sizeof(ThreadCounts) / sizeof(ThreadCounts[0]);
+
+/**
+ * Warm-up cycles, not measured.
+ */
+static const uint32 WarmUpCycles = 10u;
+
+/**
+ * Configuration of the application, filled with the number of threads, the CPU mask
+ * of the helpers, the size and the size of the half spectrum.
+ */
+static const char8 * const ConfigTemplate = ""
+        "$Bench = {"
+        "    Class = RealTimeApplication"
+        "    +Functions = {"
+        "        Class = ReferenceContainer"
+        "        +GAMFFT = {"
+        "            Class = FFTGAM"
+        "            Outputs = { Magnitude }"
+        "            Planner = Measure"
+        "            NumberOfThreads = %u"
+        "            ThreadsCPUs = 0x%x"
+        "            InputSignals = {"
+        "                In = { DataSource = DDB1 Type = float64 NumberOfDimensions = 1 NumberOfElements = %u }"
+        "            }"
+        "            OutputSignals = {"
+        "                Mod = { DataSource = DDB1 Type = float64 NumberOfDimensions = 1 NumberOfElements = %u }"
+        "            }"
+        "        }"
+        "    }"
+        "    +Data = {"
+        "        Class = ReferenceContainer"
+        "        DefaultDataSource = DDB1"
+        "        +DDB1 = { Class = GAMDataSource }"
+        "        +Timings = { Class = TimingDataSource }"
+        "    }"
+        "    +States = {"
+        "        Class = ReferenceContainer"
+        "        +State1 = {"
+        "            Class = RealTimeState"
+        "            +Threads = {"
+        "                Class = ReferenceContainer"
+        "                +Thread1 = { Class = RealTimeThread Functions = { GAMFFT } }"
+        "            }"
+        "        }"
+        "    }"
+        "    +Scheduler = { Class = GAMScheduler TimingDataSource = Timings }"
+        "}";
+
+static void ErrorProcessFunction(const ErrorManagement::ErrorInformation &errorInfo,
+                                 const char8 * const errorDescription) {
+    printf("[%s] %s\n", errorInfo.className, errorDescription);
+}
+
+/**
+ * @brief Configures the application for a size and a thread count and times cycles calls of Execute.
+ * @return false if the application cannot be configured.
+ */
+static bool Measure(const uint32 size, const uint32 numberOfThreads, const uint32 threadsCPUs, const uint32 cycles,
+                    std::vector<float64> &times) {
+    char8 config[4096];
+    (void) snprintf(config, sizeof(config), ConfigTemplate, numberOfThreads, threadsCPUs, size, (size / 2u) + 1u);
+    StreamString configStream = config;
+    (void) configStream.Seek(0LLU);
+
+    ConfigurationDatabase cdb;
+    StandardParser parser(configStream, cdb);
+    bool ok = parser.Parse();
+
+    ObjectRegistryDatabase *god = ObjectRegistryDatabase::Instance();
+    if (ok) {
+        god->Purge();
+        ok = god->Initialise(cdb);
+    }
+    ReferenceT<RealTimeApplication> application;
+    if (ok) {
+        application = god->Find("Bench");
+        ok = application.IsValid();
+    }
+    if (ok) {
+        ok = application->ConfigureApplication();
+    }
+    ReferenceT<FFTGAM> gam;
+    if (ok) {
+        gam = god->Find("Bench.Functions.GAMFFT");
+        ok = gam.IsValid();
+    }
+    if (ok) {
+        for (uint32 i = 0u; i < WarmUpCycles; i++) {
+            (void) gam->Execute();
+        }
+        times.resize(cycles);
+        for (uint32 i = 0u; i < cycles; i++) {
+            uint64 start = HighResolutionTimer::Counter();
+            (void) gam->Execute();
+            uint64 ticks = HighResolutionTimer::Counter() - start;
+            times[i] = static_cast<float64>(ticks) * HighResolutionTimer::Period() * 1e6;
+        }
+        std::sort(times.begin(), times.end());
+    }
+    god->Purge();
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+    SetErrorProcessFunction(&ErrorProcessFunction);
+
+    uint32 cycles = 200u;
+    uint32 threadsCPUs = 0xfeu;
+    if (argc > 1) {
+        cycles = static_cast<uint32>(strtoul(argv[1], NULL_PTR(char **), 0));
+    }
+    if (argc > 2) {
+        threadsCPUs = static_cast<uint32>(strtoul(argv[2], NULL_PTR(char **), 0));
+    }
+    if (cycles == 0u) {
+        cycles = 1u;
+    }
+
+    printf("%10s %8s %12s %12s %12s\n", "Size", "Threads", "Min (us)", "Median (us)", "Max (us)");
+    bool ok = true;
+    for (uint32 s = 0u; s < NumberOfSizes; s++) {
+        for (uint32 t = 0u; t < NumberOfThreadCounts; t++) {
+            std::vector<float64> times;
+            if (Measure(Sizes[s], ThreadCounts[t], threadsCPUs, cycles, times)) {
+                printf("%10u %8u %12.1f %12.1f %12.1f\n", Sizes[s], ThreadCounts[t], times[0], times[cycles / 2u], times[cycles - 1u]);
+            }
+            else {
+                printf("%10u %8u %12s\n", Sizes[s], ThreadCounts[t], "failed");
+                ok = false;
+            }
+            (void) fflush(stdout);
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file FFTGAMThreadPool.cpp
+ * @brief Source file for class FFTGAMThreadPool
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing, 
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for
+ * the class FFTGAMThreadPool (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+#include <fftw3.h>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+#include "FFTGAMThreadPool.h"
+#include "AdvancedErrorManagement.h"
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+FFTGAMThreadPool *FFTGAMThreadPool::instance = NULL_PTR(FFTGAMThreadPool *);
+uint32 FFTGAMThreadPool::numberOfUsers = 0u;
+bool FFTGAMThreadPool::threadsInitialised = false;
+
+FFTGAMThreadPool::FFTGAMThreadPool() : HelperThreadPool() {
+    work = NULL_PTR(void *(*)(char *));
+    jobData = NULL_PTR(char *);
+    elementSize = 0u;
+    (void) loopMutex.Create();
+}
+
+FFTGAMThreadPool::~FFTGAMThreadPool() {
+    Stop();
+}
+
+bool FFTGAMThreadPool::Acquire(const uint32 numberOfHelpers, const uint32 cpuMask, const uint32 stackSize) {
+    bool ok = true;
+    if (instance == NULL_PTR(FFTGAMThreadPool *)) {
+        if (!threadsInitialised) {
+            threadsInitialised = (fftw_init_threads() != 0) && (fftwf_init_threads() != 0);
+        }
+        ok = threadsInitialised;
+        if (ok) {
+            instance = new FFTGAMThreadPool();
+            ok = instance->Start(numberOfHelpers, cpuMask, stackSize, "FFTGAMThreadPool", false);
+            if (ok) {
+                fftw_threads_set_callback(&ParallelLoop, instance);
+                fftwf_threads_set_callback(&ParallelLoop, instance);
+            }
+            else {
+                delete instance;
+                instance = NULL_PTR(FFTGAMThreadPool *);
+            }
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::FatalError, "Could not start the FFT helper threads");
+        }
+    }
+    else if (numberOfHelpers != instance->GetNumberOfHelpers()) {
+        REPORT_ERROR(ErrorManagement::Warning, "The FFT helper threads are shared: using the %d threads already created", instance->GetNumberOfHelpers());
+    }
+    else {
+
+    }
+    if (ok) {
+        numberOfUsers++;
+    }
+    return ok;
+}
+
+void FFTGAMThreadPool::Release() {
+    if (numberOfUsers > 0u) {
+        numberOfUsers--;
+        if (numberOfUsers == 0u) {
+            //Back to the FFTW threads
+            fftw_threads_set_callback(NULL_PTR(void (*)(void *(*)(char *), char *, size_t, int, void *)), NULL_PTR(void *));
+            fftwf_threads_set_callback(NULL_PTR(void (*)(void *(*)(char *), char *, size_t, int, void *)), NULL_PTR(void *));
+            delete instance;
+            instance = NULL_PTR(FFTGAMThreadPool *);
+        }
+    }
+}
+
+void FFTGAMThreadPool::SetPlannerThreads(const uint32 numberOfThreads) {
+    if (threadsInitialised) {
+        fftw_plan_with_nthreads(static_cast<int>(numberOfThreads));
+        fftwf_plan_with_nthreads(static_cast<int>(numberOfThreads));
+    }
+}
+
+void FFTGAMThreadPool::ParallelLoop(void *(*work)(char *), char *jobData, size_t elementSize, int njobs, void *data) {
+    FFTGAMThreadPool *pool = reinterpret_cast<FFTGAMThreadPool *>(data);
+    if (pool->loopMutex.FastTryLock()) {
+        //Published to the helpers by Run, which takes the job lock
+        pool->work = work;
+        pool->jobData = jobData;
+        pool->elementSize = elementSize;
+        pool->Run(static_cast<uint32>(njobs));
+        pool->loopMutex.FastUnLock();
+    }
+    else { //The pool is serving another plan: do not wait for it
+        for (int j = 0; j < njobs; j++) {
+            (void) work(&jobData[static_cast<size_t>(j) * elementSize]);
+        }
+    }
+}
+
+/*lint -e{715} threadIdx is not used: the FFTW jobs do not need per-thread storage.*/
+void FFTGAMThreadPool::ProcessJob(const uint32 jobIdx, const uint32 threadIdx) {
+    (void) work(&jobData[static_cast<size_t>(jobIdx) * elementSize]);
+}
+
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
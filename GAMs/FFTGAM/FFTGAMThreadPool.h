@@ -0,0 +1,124 @@
+/**
+ * @file FFTGAMThreadPool.h
+ * @brief Header file for class FFTGAMThreadPool
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing, 
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class FFTGAMThreadPool
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef FFTGAMTHREADPOOL_H_
+#define FFTGAMTHREADPOOL_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+#include <stddef.h>
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+#include "FastPollingMutexSem.h"
+#include "HelperThreadPool.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+/**
+ * @brief Helper threads executing the parallel loops of the multi-threaded FFTW plans.
+ * @details FFTW creates its own helper threads, which inherit the affinity of the real-time thread executing the plan. Instead, the parallel loops
+ * of the plans are handed (fftw_threads_set_callback) to this pool, whose threads run with the configured CPU mask.
+ * The calling thread takes part in the loop (see HelperThreadPool), so that the jobs are also completed when the helpers are late or busy. If the pool
+ * is already serving another plan (two FFTGAMs executing at the same time in different threads) the caller runs all the jobs by itself, instead of waiting.
+ * The pool is shared by all the FFTGAM instances (the FFTW callback is global): it is created by the first Acquire and destroyed by the last Release.
+ * Acquire and Release shall be called with the FFTW planner lock held.
+ */
+class FFTGAMThreadPool : public HelperThreadPool {
+public:
+    /**
+     * @brief Creates the pool (if not yet created) and installs it as the FFTW parallel loop.
+     * @param[in] numberOfHelpers number of helper threads (used only by the first call).
+     * @param[in] cpuMask CPU mask of the helper threads (used only by the first call).
+     * @param[in] stackSize stack size of the helper threads (used only by the first call).
+     * @return true if the pool is running.
+     */
+    static bool Acquire(const uint32 numberOfHelpers, const uint32 cpuMask, const uint32 stackSize);
+
+    /**
+     * @brief Stops and destroys the pool when it is no longer used, restoring the FFTW threads.
+     */
+    static void Release();
+
+    /**
+     * @brief Sets the number of threads of the next plans (if the FFTW threads were initialised).
+     */
+    static void SetPlannerThreads(const uint32 numberOfThreads);
+
+    /**
+     * @brief The FFTW parallel loop: runs work on the njobs elements of jobData.
+     */
+    static void ParallelLoop(void *(*work)(char *), char *jobData, size_t elementSize, int njobs, void *data);
+
+protected:
+    /**
+     * @brief Runs work on the jobIdx-th element of jobData.
+     */
+    virtual void ProcessJob(const uint32 jobIdx, const uint32 threadIdx);
+
+private:
+    /**
+     * @brief Constructor.
+     */
+    FFTGAMThreadPool();
+
+    /**
+     * @brief Stops the helpers.
+     */
+    virtual ~FFTGAMThreadPool();
+
+    /**
+     * Taken by the thread running a loop.
+     */
+    FastPollingMutexSem loopMutex;
+
+    /**
+     * The current loop.
+     */
+    void *(*work)(char *);
+    char *jobData;
+    size_t elementSize;
+
+    /**
+     * The pool and the number of its users.
+     */
+    static FFTGAMThreadPool *instance;
+    static uint32 numberOfUsers;
+
+    /**
+     * True once fftw_init_threads was called.
+     */
+    static bool threadsInitialised;
+};
+}
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+#endif /* FFTGAMTHREADPOOL_H_ */
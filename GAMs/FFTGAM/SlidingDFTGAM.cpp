@@ -0,0 +1,392 @@
+/**
+ * @file SlidingDFTGAM.cpp
+ * @brief Source file for class SlidingDFTGAM
+ * @date 19/10/2026
+ * @author gmanduchi
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing, 
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for
+ * the class SlidingDFTGAM (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+#include "SlidingDFTGAM.h"
+#include "AdvancedErrorManagement.h"
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+SlidingDFTGAM::SlidingDFTGAM() : GAM()
+{
+    inSignalMemory = NULL_PTR(void **);
+    updateFunctions = NULL_PTR(UpdateFunction *);
+    products = NULL_PTR(FFTGAMProduct *);
+    numberOfProducts = 0u;
+    outSignalMemory = NULL_PTR(float64 **);
+    numberOfChannels = 0u;
+    numberOfElements = 0u;
+    windowLength = 0u;
+    frequencies = NULL_PTR(float64 *);
+    numberOfFrequencies = 0u;
+    samplingFrequency = 0.;
+    rotation = NULL_PTR(fftw_complex *);
+    newSampleWeight = NULL_PTR(fftw_complex *);
+    bins = NULL_PTR(fftw_complex *);
+    ring = NULL_PTR(float64 *);
+    ringPos = 0u;
+    recomputePeriod = 0u;
+    recomputeCycles = 0u;
+    recomputeChannel = 0u;
+}
+
+SlidingDFTGAM::~SlidingDFTGAM() {
+    if (inSignalMemory != NULL_PTR(void **)) {
+        delete [] inSignalMemory;
+    }
+    if (updateFunctions != NULL_PTR(UpdateFunction *)) {
+        delete [] updateFunctions;
+    }
+    if (products != NULL_PTR(FFTGAMProduct *)) {
+        delete [] products;
+    }
+    if (outSignalMemory != NULL_PTR(float64 **)) {
+        delete [] outSignalMemory;
+    }
+    if (frequencies != NULL_PTR(float64 *)) {
+        delete [] frequencies;
+    }
+    if (rotation != NULL_PTR(fftw_complex *)) {
+        delete [] rotation;
+    }
+    if (newSampleWeight != NULL_PTR(fftw_complex *)) {
+        delete [] newSampleWeight;
+    }
+    if (bins != NULL_PTR(fftw_complex *)) {
+        delete [] bins;
+    }
+    if (ring != NULL_PTR(float64 *)) {
+        delete [] ring;
+    }
+}
+
+bool SlidingDFTGAM::Initialise(StructuredDataI & data) {
+    bool ok = GAM::Initialise(data);
+    if (ok) {
+        ok = data.Read("SamplingFrequency", samplingFrequency);
+        if (ok) {
+            ok = (samplingFrequency > 0.);
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "SamplingFrequency shall be specified and positive");
+        }
+    }
+    if (ok) {
+        AnyType frequenciesDescription = data.GetType("Frequencies");
+        ok = (frequenciesDescription.GetDataPointer() != NULL_PTR(void *));
+        if (ok) {
+            numberOfFrequencies = frequenciesDescription.GetNumberOfElements(0u);
+            ok = (numberOfFrequencies > 0u);
+        }
+        if (ok) {
+            frequencies = new float64[numberOfFrequencies];
+            Vector<float64> frequenciesVector(frequencies, numberOfFrequencies);
+            ok = data.Read("Frequencies", frequenciesVector);
+        }
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Frequencies shall be specified");
+        }
+    }
+    if (ok) {
+        if (!data.Read("WindowLength", windowLength)) {
+            windowLength = 0u;
+        }
+        if (!data.Read("NumberOfChannels", numberOfChannels)) {
+            numberOfChannels = 0u;
+        }
+        if (!data.Read("RecomputePeriod", recomputePeriod)) {
+            recomputePeriod = 0u;
+        }
+        AnyType outputsDescription = data.GetType("Outputs");
+        if (outputsDescription.GetDataPointer() != NULL_PTR(void *)) {
+            numberOfProducts = outputsDescription.GetNumberOfElements(0u);
+            ok = (numberOfProducts > 0u);
+            Vector<StreamString> productNames(numberOfProducts);
+            if (ok) {
+                ok = data.Read("Outputs", productNames);
+            }
+            if (ok) {
+                products = new FFTGAMProduct[numberOfProducts];
+                for (uint32 k = 0u; (k < numberOfProducts) && ok; k++) {
+                    ok = FFTGAM::GetProduct(productNames[k], products[k]);
+                    if (!ok) {
+                        REPORT_ERROR(ErrorManagement::ParametersError, "Unknown output %s. Possible values are Complex, Power, Magnitude, Phase, dB",
+                                     productNames[k].Buffer());
+                    }
+                }
+            }
+            else {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Cannot read Outputs");
+            }
+        }
+        else { //Magnitude and phase
+            numberOfProducts = 2u;
+            products = new FFTGAMProduct[numberOfProducts];
+            products[0] = FFTGAMMagnitude;
+            products[1] = FFTGAMPhase;
+        }
+    }
+    return ok;
+}
+
+bool SlidingDFTGAM::Setup() {
+    uint32 numberOfInputSignals = GetNumberOfInputSignals();
+    bool ok = (numberOfInputSignals > 0u);
+    if (!ok) {
+        REPORT_ERROR(ErrorManagement::ParametersError, "There shall be at least one input signal");
+    }
+    if (ok) {
+        ok = (GetNumberOfOutputSignals() == (numberOfProducts * numberOfInputSignals));
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "There shall be %d output signals (one for each of the Outputs) for each input signal", numberOfProducts);
+        }
+    }
+    uint32 numberOfDimensions = 0u;
+    if (ok && (numberOfInputSignals == 1u)) {
+        ok = GetSignalNumberOfDimensions(InputSignals, 0u, numberOfDimensions);
+    }
+    if (ok) {
+        if (numberOfDimensions == 2u) { //NumberOfChannels rows of samples
+            ok = (numberOfChannels > 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "NumberOfChannels shall be specified for a 2D input signal");
+            }
+        }
+        else {
+            numberOfChannels = numberOfInputSignals;
+        }
+    }
+    if (ok) {
+        inSignalMemory = new void *[numberOfChannels];
+        updateFunctions = new UpdateFunction[numberOfChannels];
+        outSignalMemory = new float64 *[numberOfProducts * numberOfChannels];
+    }
+    uint32 channelIdx = 0u;
+    for (uint32 inIdx = 0u; (inIdx < numberOfInputSignals) && ok; inIdx++) {
+        TypeDescriptor signalType = GetSignalType(InputSignals, inIdx);
+        UpdateFunction updateFunction = NULL_PTR(UpdateFunction);
+        ok = GetUpdateFunction(signalType, updateFunction);
+        if (!ok) {
+            REPORT_ERROR(ErrorManagement::ParametersError, "Only Float (32/64 bits) and integers (16/32 bits) types supported as input");
+        }
+        if (ok) {
+            ok = GetSignalNumberOfDimensions(InputSignals, inIdx, numberOfDimensions);
+        }
+        if (ok) {
+            ok = (numberOfDimensions == 1u) || (numberOfDimensions == 0u) || ((numberOfDimensions == 2u) && (numberOfInputSignals == 1u));
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Input signal will be either 1D (single samples), scalar (multiple samples) or 2D (single input signal, one row per channel)");
+            }
+        }
+        uint32 signalElements = 0u;
+        if (ok) {
+            if (numberOfDimensions > 0u) {
+                ok = GetSignalNumberOfElements(InputSignals, inIdx, signalElements);
+            }
+            else {
+                ok = GetSignalNumberOfSamples(InputSignals, inIdx, signalElements);
+            }
+        }
+        uint32 signalChannels = (numberOfDimensions == 2u) ? numberOfChannels : 1u;
+        if (ok) {
+            ok = ((signalElements % signalChannels) == 0u) && (signalElements > 0u);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "The number of elements of the 2D input signal shall be a multiple of NumberOfChannels");
+            }
+        }
+        if (ok) {
+            uint32 channelElements = signalElements / signalChannels;
+            if (inIdx == 0u) {
+                numberOfElements = channelElements;
+            }
+            ok = (channelElements == numberOfElements);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "All the channels shall have the same number of samples (%d)", numberOfElements);
+            }
+        }
+        if (ok) {
+            char8 *signalMemory = reinterpret_cast<char8 *>(GetInputSignalMemory(inIdx));
+            uint32 channelSize = numberOfElements * (static_cast<uint32>(signalType.numberOfBits) / 8u);
+            for (uint32 c = 0u; c < signalChannels; c++) {
+                inSignalMemory[channelIdx] = &signalMemory[c * channelSize];
+                updateFunctions[channelIdx] = updateFunction;
+                channelIdx++;
+            }
+        }
+        for (uint32 outIdx = 0u; (outIdx < numberOfProducts) && ok; outIdx++) {
+            uint32 outSignalIdx = (numberOfProducts * inIdx) + outIdx;
+            uint32 outElements = 0u;
+            ok = (GetSignalType(OutputSignals, outSignalIdx) == Float64Bit);
+            if (!ok) {
+                REPORT_ERROR(ErrorManagement::ParametersError, "Output signal type shall be Float64");
+            }
+            uint32 outDimensions = 0u;
+            if (ok) {
+                ok = GetSignalNumberOfDimensions(OutputSignals, outSignalIdx, outDimensions);
+            }
+            if (ok) {
+                ok = (outDimensions == ((signalChannels > 1u) ? 2u : 1u));
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall be 1D (2D for a 2D input signal)");
+                }
+            }
+            if (ok) {
+                ok = GetSignalNumberOfElements(OutputSignals, outSignalIdx, outElements);
+            }
+            uint32 channelOutElements = numberOfFrequencies * ((products[outIdx] == FFTGAMComplex) ? 2u : 1u);
+            if (ok) {
+                ok = (outElements == (channelOutElements * signalChannels));
+                if (!ok) {
+                    REPORT_ERROR(ErrorManagement::ParametersError, "Output signal shall have %d elements", channelOutElements * signalChannels);
+                }
+            }
+            if (ok) {
+                float64 *signalMemory = reinterpret_cast<float64 *>(GetOutputSignalMemory(outSignalIdx));
+                for (uint32 c = 0u; c < signalChannels; c++) {
+                    outSignalMemory[(outIdx * numberOfChannels) + (channelIdx - signalChannels + c)] = &signalMemory[c * channelOutElements];
+                }
+            }
+        }
+    }
+    if (ok) {
+        if (windowLength == 0u) {
+            windowLength = numberOfElements;
+        }
+        rotation = new fftw_complex[numberOfFrequencies];
+        newSampleWeight = new fftw_complex[numberOfFrequencies];
+        for (uint32 k = 0u; k < numberOfFrequencies; k++) {
+            float64 w = (2. * M_PI * frequencies[k]) / samplingFrequency;
+            rotation[k][0] = cos(w);
+            rotation[k][1] = sin(w);
+            newSampleWeight[k][0] = cos(w * (windowLength - 1u));
+            newSampleWeight[k][1] = -sin(w * (windowLength - 1u));
+        }
+        bins = new fftw_complex[numberOfChannels * numberOfFrequencies];
+        memset(bins, 0, sizeof(fftw_complex) * numberOfChannels * numberOfFrequencies);
+        ring = new float64[numberOfChannels * windowLength];
+        memset(ring, 0, sizeof(float64) * numberOfChannels * windowLength);
+        if (recomputePeriod == 0u) { //Each channel about every windowLength x numberOfFrequencies samples
+            recomputePeriod = (windowLength * numberOfFrequencies) / (numberOfElements * numberOfChannels);
+            if (recomputePeriod == 0u) {
+                recomputePeriod = 1u;
+            }
+        }
+    }
+    return ok;
+}
+
+bool SlidingDFTGAM::Execute() {
+    for (uint32 c = 0u; c < numberOfChannels; c++) {
+        (this->*updateFunctions[c])(c);
+    }
+    ringPos = (ringPos + numberOfElements) % windowLength;
+    recomputeCycles++;
+    if (recomputeCycles == recomputePeriod) {
+        recomputeCycles = 0u;
+        RecomputeChannel(recomputeChannel);
+        recomputeChannel++;
+        if (recomputeChannel == numberOfChannels) {
+            recomputeChannel = 0u;
+        }
+    }
+    for (uint32 k = 0u; k < numberOfProducts; k++) {
+        for (uint32 c = 0u; c < numberOfChannels; c++) {
+            FFTGAM::ComputeProduct(products[k], &bins[c * numberOfFrequencies], numberOfFrequencies, outSignalMemory[(k * numberOfChannels) + c]);
+        }
+    }
+    return true;
+}
+
+bool SlidingDFTGAM::GetUpdateFunction(const TypeDescriptor &type, UpdateFunction &updateFunction) {
+    bool ok = true;
+    if (type == Float32Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<float32>;
+    }
+    else if (type == Float64Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<float64>;
+    }
+    else if (type == UnsignedInteger16Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<uint16>;
+    }
+    else if (type == SignedInteger16Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<int16>;
+    }
+    else if (type == UnsignedInteger32Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<uint32>;
+    }
+    else if (type == SignedInteger32Bit) {
+        updateFunction = &SlidingDFTGAM::UpdateChannel<int32>;
+    }
+    else {
+        ok = false;
+    }
+    return ok;
+}
+
+void SlidingDFTGAM::RecomputeChannel(const uint32 channelIdx) {
+    const float64 *channelRing = &ring[channelIdx * windowLength];
+    fftw_complex *channelBins = &bins[channelIdx * numberOfFrequencies];
+    for (uint32 k = 0u; k < numberOfFrequencies; k++) {
+        //X = sum of x[m] e^{-jwm}, oldest sample (at ringPos) first
+        float64 re = 0.;
+        float64 im = 0.;
+        float64 twiddleRe = 1.;
+        float64 twiddleIm = 0.;
+        uint32 pos = ringPos;
+        for (uint32 m = 0u; m < windowLength; m++) {
+            float64 x = channelRing[pos];
+            pos++;
+            if (pos == windowLength) {
+                pos = 0u;
+            }
+            re += x * twiddleRe;
+            im += x * twiddleIm;
+            float64 nextRe = (twiddleRe * rotation[k][0]) + (twiddleIm * rotation[k][1]);
+            twiddleIm = (twiddleIm * rotation[k][0]) - (twiddleRe * rotation[k][1]);
+            twiddleRe = nextRe;
+        }
+        channelBins[k][0] = re;
+        channelBins[k][1] = im;
+    }
+}
+
+CLASS_REGISTER(SlidingDFTGAM, "1.0")
+
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
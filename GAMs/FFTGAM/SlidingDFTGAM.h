@@ -0,0 +1,200 @@
+/**
+ * @file SlidingDFTGAM.h
+ * @brief Header file for class SlidingDFTGAM
+ * @date 19/10/2026
+ * @author gmanduchi
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing, 
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class SlidingDFTGAM
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef SLIDINGDFTGAM_H_
+#define SLIDINGDFTGAM_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+#include "FFTGAM.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+/**
+ * @brief Tracks a few spectral lines with a recursive sliding DFT, instead of computing the full FFT.
+ * @details For each of the configured Frequencies the DFT of the last WindowLength samples of each channel is updated at every incoming sample:
+ * X[n] = e^{jw} (X[n-1] - x[n-N]) + x[n] e^{-jw(N-1)}, w = 2 pi f / SamplingFrequency.
+ * The cost is O(number of frequencies) per sample, regardless of WindowLength. The result is the same DFT bin computed by the FFTGAM
+ * (rectangular window, oldest sample first), and equal to the Goertzel algorithm when WindowLength is the number of samples per cycle,
+ * but the frequencies need not be multiples of SamplingFrequency / WindowLength.
+ *
+ * The recursion accumulates rounding errors without bound, so every RecomputePeriod cycles the bins of one channel (in turn) are recomputed exactly
+ * from its last WindowLength samples, at the cost of WindowLength operations per frequency. By default each channel is recomputed about every
+ * WindowLength x number of frequencies samples, which adds about one operation per sample to the recursion.
+ *
+ * The inputs are defined as for the FFTGAM (N input signals or a single 2D signal with NumberOfChannels rows). For every input signal there shall be a
+ * float64 output signal for every product listed in Outputs (see FFTGAMProduct), with one element for each frequency (two for Complex) for each channel.
+ *
+ * <pre>
+ * +Lines = {
+ *     Class = FFTGAM::SlidingDFTGAM
+ *     SamplingFrequency = 10000 // Compulsory. Hz.
+ *     Frequencies = { 50 150 250 } // Compulsory. Hz.
+ *     WindowLength = 2000 // Optional. Default the number of samples per cycle.
+ *     RecomputePeriod = 10 // Optional. Cycles between two exact recomputations of the bins of a channel. Default see above.
+ *     NumberOfChannels = 32 // Compulsory only if the input signal is 2D.
+ *     Outputs = { Magnitude Phase } // Optional. Any of Complex, Power, Magnitude, Phase, dB. Default { Magnitude Phase }.
+ *     InputSignals = {
+ *         Probes = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 3200 Type = float32 } // 32 x 100
+ *     }
+ *     OutputSignals = {
+ *         LinesMod = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 96 Type = float64 } // 32 x 3
+ *         LinesPhase = { DataSource = DDB NumberOfDimensions = 2 NumberOfElements = 96 Type = float64 }
+ *     }
+ * }
+ * </pre>
+ */
+class SlidingDFTGAM : public GAM {
+public:
+    CLASS_REGISTER_DECLARATION()
+
+    SlidingDFTGAM();
+
+    virtual ~SlidingDFTGAM();
+
+    virtual bool Setup();
+
+    virtual bool Execute();
+
+    virtual bool Initialise(StructuredDataI & data);
+
+private:
+    /**
+     * @brief Updates the bins of a channel with the samples received in this cycle.
+     */
+    template<typename T>
+    void UpdateChannel(const uint32 channelIdx);
+
+    /**
+     * Kernel updating the bins of a channel from its input type.
+     */
+    typedef void (SlidingDFTGAM::*UpdateFunction)(const uint32 channelIdx);
+
+    /**
+     * @brief Selects the UpdateChannel kernel for the input type.
+     * @return false if the type is not supported.
+     */
+    static bool GetUpdateFunction(const TypeDescriptor &type, UpdateFunction &updateFunction);
+
+    /**
+     * @brief Recomputes exactly the bins of a channel from the samples in its ring, discarding the rounding errors of the recursion.
+     */
+    void RecomputeChannel(const uint32 channelIdx);
+
+    /**
+     * Input memory and update kernel of each channel.
+     */
+    void **inSignalMemory;
+    UpdateFunction *updateFunctions;
+
+    /**
+     * The products to be computed.
+     */
+    FFTGAMProduct *products;
+    uint32 numberOfProducts;
+
+    /**
+     * Output memory of each product and channel (index product * numberOfChannels + channel).
+     */
+    float64 **outSignalMemory;
+
+    /**
+     * Number of channels, of samples of each channel received every cycle and DFT length.
+     */
+    uint32 numberOfChannels;
+    uint32 numberOfElements;
+    uint32 windowLength;
+
+    /**
+     * The tracked frequencies and the sampling frequency.
+     */
+    float64 *frequencies;
+    uint32 numberOfFrequencies;
+    float64 samplingFrequency;
+
+    /**
+     * e^{jw} and e^{-jw(N-1)} of each frequency.
+     */
+    fftw_complex *rotation;
+    fftw_complex *newSampleWeight;
+
+    /**
+     * The bins of each channel (index channel * numberOfFrequencies + frequency).
+     */
+    fftw_complex *bins;
+
+    /**
+     * Last windowLength samples of each channel and position of the oldest sample.
+     */
+    float64 *ring;
+    uint32 ringPos;
+
+    /**
+     * Cycles between two exact recomputations, cycles since the last one and next channel to be recomputed.
+     */
+    uint32 recomputePeriod;
+    uint32 recomputeCycles;
+    uint32 recomputeChannel;
+};
+}
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+template<typename T>
+void SlidingDFTGAM::UpdateChannel(const uint32 channelIdx) {
+    const T *samples = reinterpret_cast<const T *>(inSignalMemory[channelIdx]);
+    float64 *channelRing = &ring[channelIdx * windowLength];
+    fftw_complex *channelBins = &bins[channelIdx * numberOfFrequencies];
+    uint32 pos = ringPos;
+    for (uint32 i = 0u; i < numberOfElements; i++) {
+        float64 x = static_cast<float64>(samples[i]);
+        float64 oldest = channelRing[pos];
+        channelRing[pos] = x;
+        pos++;
+        if (pos == windowLength) {
+            pos = 0u;
+        }
+        for (uint32 k = 0u; k < numberOfFrequencies; k++) {
+            float64 re = channelBins[k][0] - oldest;
+            float64 im = channelBins[k][1];
+            channelBins[k][0] = (rotation[k][0] * re) - (rotation[k][1] * im) + (x * newSampleWeight[k][0]);
+            channelBins[k][1] = (rotation[k][0] * im) + (rotation[k][1] * re) + (x * newSampleWeight[k][1]);
+        }
+    }
+}
+
+}
+
+#endif 
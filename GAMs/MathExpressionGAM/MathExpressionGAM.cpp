@@ -33,6 +33,11 @@
 
 #include "MathExpressionGAM.h"
 #include "AdvancedErrorManagement.h"
+#include "Atomic.h"
+#include "CLASSMETHODREGISTER.h"
+#include "GlobalObjectsDatabase.h"
+#include "HighResolutionTimer.h"
+#include "StringHelper.h"
 #include <iostream>
 
 /*---------------------------------------------------------------------------*/
@@ -41,11 +46,302 @@
 
 namespace MARTe {
 
-MathExpressionGAM::MathExpressionGAM() : GAM(){
+/**
+ * Copies a signal of type T to its float64 recast.
+ * Plain indexed loop with no type dispatch, so that the compiler can vectorise it.
+ */
+template<typename T>
+static void ConvertInput(const void * const source, float64 * const destination, const uint32 numberOfElements) {
+	
+	const T* typedSource = static_cast<const T*>(source);
+	
+	for (uint32 elemIdx = 0u; elemIdx < numberOfElements; elemIdx++) {
+		
+		destination[elemIdx] = static_cast<float64>(typedSource[elemIdx]);
+		
+	}
+	
+}
+
+/**
+ * Copies the float64 recast of a signal back to its type T.
+ */
+template<typename T>
+static void ConvertOutput(const float64 * const source, void * const destination, const uint32 numberOfElements) {
+	
+	T* typedDestination = static_cast<T*>(destination);
+	
+	for (uint32 elemIdx = 0u; elemIdx < numberOfElements; elemIdx++) {
+		
+		typedDestination[elemIdx] = static_cast<T>(source[elemIdx]);
+		
+	}
+	
+}
+
+/**
+ * Functions that cost much more than an arithmetic operation.
+ */
+static const char8 * const ExpensiveFunctions[] = { "sin", "cos", "tan", "asin", "acos", "atan", "atan2",
+													"sinh", "cosh", "tanh", "exp", "expm1", "log", "log10",
+													"log2", "log1p", "logn", "pow", "root", "sqrt", "hypot",
+													"erf", "erfc", NULL_PTR(const char8*) };
+													
+/**
+ * Keywords that take parentheses but are not operations.
+ */
+static const char8 * const ControlKeywords[] = { "if", "for", "while", "switch", "case", "until", "return",
+												 NULL_PTR(const char8*) };
+												
+static bool IsInList(const char8 * const name, const char8 * const * const list) {
+	
+	bool found = false;
+	for (uint32 i = 0u; (list[i] != NULL_PTR(const char8*)) && !found; i++) {
+		found = (StringHelper::Compare(name, list[i]) == 0);
+	}
+	return found;
+	
+}
+
+/**
+ * Estimates from the text the number of operations of an expression: the
+ * arithmetic, comparison and logical operators and the function calls.
+ * Loops are not unrolled, so that for an expression iterating over the
+ * elements this is the number of operations per element.
+ * @param[in] text the expression.
+ * @param[out] loopedCalls the expensive functions called in the body of a loop.
+ * @return the number of operations.
+ */
+static uint32 CountOperations(const char8 * const text,
+							  StreamString &loopedCalls) {
+							
+	uint32 operations = 0u;
+	const char8* cursor = text;
+	
+	// For each open brace, whether it opened the body of a loop
+	std::vector<bool> loopBlock;
+	uint32 loopDepth = 0u;
+	bool loopPending = false;
+	
+	while (*cursor != '\0') {
+		
+		const char8 c = *cursor;
+		const char8 next = cursor[1];
+		
+		if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_')) {
+			
+			StreamString identifier;
+			while (((*cursor >= 'a') && (*cursor <= 'z')) ||
+				   ((*cursor >= 'A') && (*cursor <= 'Z')) ||
+				   ((*cursor >= '0') && (*cursor <= '9')) ||
+				   (*cursor == '_')) {
+				identifier += *cursor;
+				cursor++;
+			}
+			const char8* after = cursor;
+			while ((*after == ' ') || (*after == '\t') || (*after == '\n') || (*after == '\r')) {
+				after++;
+			}
+			
+			const char8 * const name = identifier.Buffer();
+			if ((StringHelper::Compare(name, "for") == 0) ||
+				(StringHelper::Compare(name, "while") == 0) ||
+				(StringHelper::Compare(name, "repeat") == 0)) {
+				loopPending = true;
+			} else if ((StringHelper::Compare(name, "and") == 0) || (StringHelper::Compare(name, "or") == 0) ||
+					   (StringHelper::Compare(name, "xor") == 0) || (StringHelper::Compare(name, "not") == 0) ||
+					   (StringHelper::Compare(name, "nand") == 0) || (StringHelper::Compare(name, "nor") == 0)) {
+				operations++;
+			} else if ((*after == '(') && !IsInList(name, ControlKeywords)) {
+				operations++;
+				if ((loopDepth > 0u) && IsInList(name, ExpensiveFunctions) &&
+					(StringHelper::SearchString(loopedCalls.Buffer(), name) == NULL_PTR(const char8*))) {
+					if (loopedCalls.Size() > 0u) {
+						loopedCalls += ", ";
+					}
+					loopedCalls += name;
+				}
+			} else {
+				// A symbol or a constant
+			}
+			
+		} else if (((c >= '0') && (c <= '9')) || ((c == '.') && (next >= '0') && (next <= '9'))) {
+			
+			// Numbers, exponent sign included
+			while (((*cursor >= '0') && (*cursor <= '9')) || (*cursor == '.') ||
+				   (*cursor == 'e') || (*cursor == 'E')) {
+				const bool exponent = ((*cursor == 'e') || (*cursor == 'E'));
+				cursor++;
+				if (exponent && ((*cursor == '+') || (*cursor == '-'))) {
+					cursor++;
+				}
+			}
+			
+		} else if (((c == '/') && (next == '/')) || (c == '#')) {
+			
+			while ((*cursor != '\n') && (*cursor != '\0')) {
+				cursor++;
+			}
+			
+		} else if ((c == '/') && (next == '*')) {
+			
+			cursor += 2;
+			while ((*cursor != '\0') && !((*cursor == '*') && (cursor[1] == '/'))) {
+				cursor++;
+			}
+			if (*cursor != '\0') {
+				cursor += 2;
+			}
+			
+		} else if (c == '{') {
+			
+			loopBlock.push_back(loopPending);
+			if (loopPending) {
+				loopDepth++;
+			}
+			loopPending = false;
+			cursor++;
+			
+		} else if (c == '}') {
+			
+			if (!loopBlock.empty()) {
+				if (loopBlock.back()) {
+					loopDepth--;
+				}
+				loopBlock.pop_back();
+			}
+			cursor++;
+			
+		} else if ((c == ':') && (next == '=')) {
+			
+			// Assignment
+			cursor += 2;
+			
+		} else if ((c == '+') || (c == '-') || (c == '*') || (c == '/') || (c == '%') || (c == '^') ||
+				   (c == '<') || (c == '>') || (c == '=') || (c == '&') || (c == '|') ||
+				   ((c == '!') && (next == '='))) {
+				
+			// One operation, also for the two and three character operators
+			operations++;
+			cursor++;
+			while ((*cursor == '=') || (*cursor == '>') || (*cursor == '&') || (*cursor == '|')) {
+				cursor++;
+			}
+			
+		} else {
+			
+			cursor++;
+			
+		}
+		
+	}
+	
+	return operations;
+	
+}
 
+MathExpressionGAM::MathExpressionGAM() : GAM(), StatefulI(), MessageI() {
+	
+	numInputSignals = 0u;
+	numOutputSignals = 0u;
+	inputSignalType = NULL_PTR(TypeDescriptor*);
+	outputSignalType = NULL_PTR(TypeDescriptor*);
+	inputNumOfElements = NULL_PTR(uint32*);
+	outputNumOfElements = NULL_PTR(uint32*);
+	inputConverter = NULL_PTR(InputConverter*);
+	outputConverter = NULL_PTR(OutputConverter*);
+	numInputStages = 0u;
+	numOutputStages = 0u;
+	inputStage = NULL_PTR(InputStage*);
+	outputStage = NULL_PTR(OutputStage*);
+	expressionString = NULL_PTR(StreamString*);
+	numOfSignalVariables = 0u;
+	numVariables = 0u;
+	variableName = NULL_PTR(StreamString*);
+	variableExpressionString = NULL_PTR(StreamString*);
+	variableNumOfElements = NULL_PTR(uint32*);
+	variableOrder = NULL_PTR(uint32*);
+	numExpressions = 0u;
+	for (uint32 i = 0u; i < 2u; i++) {
+		schedule[i].expression = NULL_PTR(exprtk::expression<float64>*);
+		schedule[i].vectorProgram = NULL_PTR(MathExpressionVectorProgram*);
+		schedule[i].numExecutionSteps = 0u;
+		schedule[i].executionStep = NULL_PTR(ExecutionStep*);
+	}
+	activeSchedule = NULL_PTR(Schedule*);
+	pendingSchedule = -1;
+	newestSchedule = 0u;
+	(void) swapMutex.Create();
+	numberOfThreads = 1u;
+	threadsCpuMask = 0xffu;
+	stackSize = THREADS_DEFAULT_STACKSIZE;
+	pool = NULL_PTR(MathExpressionThreadPool*);
+	
+	ReferenceT<RegisteredMethodsMessageFilter> filter = ReferenceT<RegisteredMethodsMessageFilter>(GlobalObjectsDatabase::Instance()->GetStandardHeap());
+	filter->SetDestination(this);
+	ErrorManagement::ErrorType ret = MessageI::InstallMessageFilter(filter);
+	if (!ret.ErrorsCleared()) {
+		REPORT_ERROR(ErrorManagement::FatalError, "Failed to install message filters");
+	}
+	
 }
 
 MathExpressionGAM::~MathExpressionGAM() {
+	
+	if (pool != NULL_PTR(MathExpressionThreadPool*)) {
+		delete pool;
+	}
+	for (uint32 i = 0u; i < 2u; i++) {
+		if (schedule[i].executionStep != NULL_PTR(ExecutionStep*)) {
+			delete [] schedule[i].executionStep;
+		}
+		if (schedule[i].vectorProgram != NULL_PTR(MathExpressionVectorProgram*)) {
+			delete [] schedule[i].vectorProgram;
+		}
+		if (schedule[i].expression != NULL_PTR(exprtk::expression<float64>*)) {
+			delete [] schedule[i].expression;
+		}
+	}
+	if (variableName != NULL_PTR(StreamString*)) {
+		delete [] variableName;
+	}
+	if (variableExpressionString != NULL_PTR(StreamString*)) {
+		delete [] variableExpressionString;
+	}
+	if (variableNumOfElements != NULL_PTR(uint32*)) {
+		delete [] variableNumOfElements;
+	}
+	if (variableOrder != NULL_PTR(uint32*)) {
+		delete [] variableOrder;
+	}
+	if (expressionString != NULL_PTR(StreamString*)) {
+		delete [] expressionString;
+	}
+	if (inputConverter != NULL_PTR(InputConverter*)) {
+		delete [] inputConverter;
+	}
+	if (outputConverter != NULL_PTR(OutputConverter*)) {
+		delete [] outputConverter;
+	}
+	if (inputStage != NULL_PTR(InputStage*)) {
+		delete [] inputStage;
+	}
+	if (outputStage != NULL_PTR(OutputStage*)) {
+		delete [] outputStage;
+	}
+	if (inputSignalType != NULL_PTR(TypeDescriptor*)) {
+		delete [] inputSignalType;
+	}
+	if (outputSignalType != NULL_PTR(TypeDescriptor*)) {
+		delete [] outputSignalType;
+	}
+	if (inputNumOfElements != NULL_PTR(uint32*)) {
+		delete [] inputNumOfElements;
+	}
+	if (outputNumOfElements != NULL_PTR(uint32*)) {
+		delete [] outputNumOfElements;
+	}
+	
 }
 
 bool MathExpressionGAM::Initialise(StructuredDataI & data) {
@@ -127,6 +423,95 @@ bool MathExpressionGAM::Initialise(StructuredDataI & data) {
 		return ok;
 	}
 	
+	/**
+	 * Finally, the optional intermediate variables are read.
+	 */
+	
+	if (data.MoveRelative("Variables")) {
+		
+		numVariables = data.GetNumberOfChildren();
+		
+		variableName = new StreamString[numVariables];
+		variableExpressionString = new StreamString[numVariables];
+		variableNumOfElements = new uint32[numVariables];
+		
+		for (uint32 varIdx = 0; varIdx < numVariables; varIdx++) {
+			
+			variableName[varIdx] = data.GetChildName(varIdx);
+			
+			ok = data.MoveToChild(varIdx);
+			if(!ok) {
+				REPORT_ERROR(ErrorManagement::ParametersError,
+								"Variables node has no child.");
+				return ok;
+			}
+			
+			ok = data.Read("Expression", variableExpressionString[varIdx]);
+			if(!ok) {
+				REPORT_ERROR(ErrorManagement::ParametersError,
+								"Expression leaf is missing (or is not a string) for variable %s.",
+								variableName[varIdx].Buffer());
+				return ok;
+			}
+			
+			if (!data.Read("NumberOfElements", variableNumOfElements[varIdx])) {
+				variableNumOfElements[varIdx] = 1u;
+			}
+			ok = (variableNumOfElements[varIdx] > 0u);
+			if(!ok) {
+				REPORT_ERROR(ErrorManagement::ParametersError,
+								"NumberOfElements of variable %s must be positive.",
+								variableName[varIdx].Buffer());
+				return ok;
+			}
+			
+			ok = data.MoveToAncestor(1);
+			if(!ok){
+				REPORT_ERROR(ErrorManagement::InitialisationError,
+							"Failed MoveToAncestor() from %s", data.GetName());
+				return ok;
+			}
+			
+		}
+		
+		// Back to the GAM node
+		ok = data.MoveToAncestor(1);
+		if(!ok){
+			REPORT_ERROR(ErrorManagement::InitialisationError,
+						 "Failed MoveToAncestor() from %s", data.GetName());
+			return ok;
+		}
+		
+	}
+	
+	/**
+	 * The optional history length of delay() and movavg().
+	 */
+	
+	uint32 maxHistoryLength = 0u;
+	if (data.Read("MaxHistoryLength", maxHistoryLength)) {
+		statefulFunctions.SetMaximumLength(maxHistoryLength);
+	}
+	
+	/**
+	 * The optional parallel evaluation parameters.
+	 */
+	
+	if (!data.Read("NumberOfThreads", numberOfThreads)) {
+		numberOfThreads = 1u;
+	}
+	if (numberOfThreads == 0u) {
+		numberOfThreads = 1u;
+	}
+	if (numberOfThreads > 1u) {
+		if (!data.Read("ThreadsCPUs", threadsCpuMask)) {
+			REPORT_ERROR(ErrorManagement::Information, "No ThreadsCPUs defined. Using default = %d", threadsCpuMask);
+		}
+		if (!data.Read("StackSize", stackSize)) {
+			REPORT_ERROR(ErrorManagement::Information, "No StackSize defined. Using default = %d", stackSize);
+		}
+	}
+	
 	return ok;
 }
 
@@ -144,7 +529,13 @@ bool MathExpressionGAM::Setup() {
 	
 	outputNumOfElements = new uint32[numOutputSignals];
 	outputSignalType = new TypeDescriptor[numOutputSignals];
-	outputExpression = new exprtk::expression<float64>[numOutputSignals];
+	
+	numExpressions = numVariables + numOutputSignals;
+	schedule[0].expression = new exprtk::expression<float64>[numExpressions];
+	schedule[1].expression = new exprtk::expression<float64>[numExpressions];
+	
+	inputConverter = new InputConverter[numInputSignals];
+	outputConverter = new OutputConverter[numOutputSignals];
 	
 	// Inputs
 	for (uint32 sigIdx = 0; sigIdx < numInputSignals; sigIdx++) {
@@ -160,6 +551,16 @@ bool MathExpressionGAM::Setup() {
 			
 		}
 		
+		OutputConverter unused;
+		ok = GetConverters(inputSignalType[sigIdx], inputConverter[sigIdx], unused);
+		if (!ok) {
+			
+			REPORT_ERROR(ErrorManagement::InitialisationError,
+						 "Input signal no. %i: unsupported type.", sigIdx);
+			return ok;
+			
+		}
+		
 	}
 	
 	// Outputs
@@ -176,18 +577,30 @@ bool MathExpressionGAM::Setup() {
 			
 		}
 		
+		InputConverter unused;
+		ok = GetConverters(outputSignalType[sigIdx], unused, outputConverter[sigIdx]);
+		if (!ok) {
+			
+			REPORT_ERROR(ErrorManagement::InitialisationError,
+						 "Output signal no. %i: unsupported type.", sigIdx);
+			return ok;
+			
+		}
+		
 	}
 	
 	/**
 	 * Then a local memory is allocated that will contain float64 versions of
-	 * input and output signals.
+	 * input and output signals. float64 signals need no local copy.
 	 */
 	
 	localInputArray.resize(numInputSignals);
 	
 	for (uint32 sigIdx = 0; sigIdx < numInputSignals; sigIdx++) {
 		
-		localInputArray[sigIdx].resize(inputNumOfElements[sigIdx]);
+		if (inputConverter[sigIdx] != NULL_PTR(InputConverter)) {
+			localInputArray[sigIdx].resize(inputNumOfElements[sigIdx]);
+		}
 		
 	}
 	
@@ -195,7 +608,9 @@ bool MathExpressionGAM::Setup() {
 	
 	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
 		
-		localOutputArray[sigIdx].resize(outputNumOfElements[sigIdx]);
+		if (outputConverter[sigIdx] != NULL_PTR(OutputConverter)) {
+			localOutputArray[sigIdx].resize(outputNumOfElements[sigIdx]);
+		}
 		
 	}
 	
@@ -226,23 +641,24 @@ bool MathExpressionGAM::Setup() {
 		return ok;
 	}
 	
-	///2. Variables are added to the symbol table. However, since exprtk can
+	///2. Variables are added to the symbol tables. However, since exprtk can
 	///   manage up to vectors, all variables are treated as vectors for the
-	///   sake of simplicity.
+	///   sake of simplicity. float64 signals are bound to the GAM memory,
+	///   the others to their local float64 copy.
+	const uint32 numSymbols = numInputSignals + numOutputSignals + numVariables;
+	symbolName.resize(numSymbols);
+	symbolMemory.resize(numSymbols);
+	symbolSize.resize(numSymbols);
 	
 	// Inputs
 	for (uint32 sigIdx = 0; sigIdx < numInputSignals; sigIdx++) {
 		
-		// To add a variable both the name of the signal and its memory address
-		// are passed to the function
-		ok = symbolTable.add_vector(xNames[sigIdx].Buffer(), localInputArray[sigIdx]);
-		if (!ok) {
-			
-			REPORT_ERROR(ErrorManagement::Exception,
-						 "add_vector() returned false while registering input %i",
-						 sigIdx);
-			
-			return ok;
+		symbolName[sigIdx] = xNames[sigIdx].Buffer();
+		symbolSize[sigIdx] = inputNumOfElements[sigIdx];
+		if (inputConverter[sigIdx] == NULL_PTR(InputConverter)) {
+			symbolMemory[sigIdx] = static_cast<float64*>(GetInputSignalMemory(sigIdx));
+		} else {
+			symbolMemory[sigIdx] = &localInputArray[sigIdx][0];
 		}
 		
 	}
@@ -250,190 +666,382 @@ bool MathExpressionGAM::Setup() {
 	// Outputs
 	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
 		
-		// To add a variable both the name of the signal and its memory address
-		// are passed to the function
-		ok = symbolTable.add_vector(yNames[sigIdx].Buffer(), localOutputArray[sigIdx]);
-		if (!ok) {
-			
-			REPORT_ERROR(ErrorManagement::Exception,
-						 "add_vector() returned false while registering output %i",
-						 sigIdx);
-			
-			return ok;
+		const uint32 symbolIdx = numInputSignals + sigIdx;
+		symbolName[symbolIdx] = yNames[sigIdx].Buffer();
+		symbolSize[symbolIdx] = outputNumOfElements[sigIdx];
+		if (outputConverter[sigIdx] == NULL_PTR(OutputConverter)) {
+			symbolMemory[symbolIdx] = static_cast<float64*>(GetOutputSignalMemory(sigIdx));
+		} else {
+			symbolMemory[symbolIdx] = &localOutputArray[sigIdx][0];
 		}
 		
 	}
 	
-	///3. The symbol table is passed to each expression and compiled.
-	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
-		
-		outputExpression[sigIdx].register_symbol_table(symbolTable);
+	// Intermediate variables
+	localVariableArray.resize(numVariables);
+	
+	for (uint32 varIdx = 0; varIdx < numVariables; varIdx++) {
 		
-		ok = expressionParser.compile(expressionString[sigIdx].Buffer(), outputExpression[sigIdx]);
-		if (!ok) {
-			
-			REPORT_ERROR(ErrorManagement::ParametersError,
-						 "Compilation of expression for output n. %i failed. Check the expression syntax.",
-						 sigIdx);
-			
-			for (uint32 i = 0; i < expressionParser.error_count(); ++i) {
-				
-				exprtk::parser_error::type error = expressionParser.get_error(i);
-				
-				exprtk::parser_error::update_error(error,expressionString[sigIdx].Buffer());
-				
-				REPORT_ERROR(ErrorManagement::Information,
-							 "Error[%i]. Position: row %i, col %i. Type: %s. Msg: %s.",
-							 i,
-							 static_cast<uint32>(error.line_no),
-							 static_cast<uint32>(error.column_no),
-							 exprtk::parser_error::to_str(error.mode).c_str(),
-							 error.diagnostic.c_str()
-							);
-				
-			}
-			
-			return ok;
-		}
+		const uint32 symbolIdx = numInputSignals + numOutputSignals + varIdx;
+		localVariableArray[varIdx].resize(variableNumOfElements[varIdx]);
+		symbolName[symbolIdx] = variableName[varIdx].Buffer();
+		symbolSize[symbolIdx] = variableNumOfElements[varIdx];
+		symbolMemory[symbolIdx] = &localVariableArray[varIdx][0];
 		
 	}
 	
-	return ok;
-}
-
-bool MathExpressionGAM::Execute() {
+	// Scratch copy of the symbols, on which SetExpression() counts the
+	// stateful calls of a new expression without touching the GAM memory.
+	uint32 scratchSize = 0u;
+	for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+		scratchSize += symbolSize[symbolIdx];
+	}
+	scratchMemory.assign(scratchSize, 0.0);
+	scratchSymbolMemory.resize(numSymbols);
+	scratchSize = 0u;
+	for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+		scratchSymbolMemory[symbolIdx] = &scratchMemory[scratchSize];
+		scratchSize += symbolSize[symbolIdx];
+	}
 	
-	//REPORT_ERROR(ErrorManagement::Debug, "EXECUTE");
+	ok = RegisterSymbols(symbolTable, symbolMemory, statefulFunctions);
+	if (ok) {
+		ok = RegisterSymbols(shadowSymbolTable, symbolMemory, statefulFunctions);
+	}
+	if (ok) {
+		ok = RegisterSymbols(scratchSymbolTable, scratchSymbolMemory, scratchFunctions);
+	}
+	if (!ok) {
+		
+		return ok;
+	}
+	
+	///3. The staging tables of the signals that are not float64 are built,
+	///   so that Execute() does not need to look up types and addresses.
 	
-	/// GAM memory is copied in local memory as a vector of float64.
 	for (uint32 sigIdx = 0; sigIdx < numInputSignals; sigIdx++) {
 		
-		for (uint32 elemIdx = 0; elemIdx < inputNumOfElements[sigIdx]; elemIdx++) {
-			
-			if (inputSignalType[sigIdx]==UnsignedInteger8Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((uint8*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==UnsignedInteger16Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((uint16*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==UnsignedInteger32Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((uint32*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==UnsignedInteger64Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((uint64*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==SignedInteger8Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((int8*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==SignedInteger16Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((int16*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==SignedInteger32Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((int32*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==SignedInteger64Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((int64*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==Float32Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((float32*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else if (inputSignalType[sigIdx]==Float64Bit) {
-				
-				localInputArray[sigIdx][elemIdx] = static_cast<float64>( *( ((float64*)GetInputSignalMemory(sigIdx)) + elemIdx ) );
-				
-			} else {
-				
-				REPORT_ERROR(ErrorManagement::Exception,
-							 "Error while loading from GAM memory. Signal no. %i: unsupported type.",
-				 sigIdx);
-				
-			}
-			
+		if (inputConverter[sigIdx] != NULL_PTR(InputConverter)) {
+			numInputStages++;
 		}
 		
 	}
 	
-	/// The expression is then evaluated and its value is printed.
 	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
 		
-		outputExpression[sigIdx].value();
+		if (outputConverter[sigIdx] != NULL_PTR(OutputConverter)) {
+			numOutputStages++;
+		}
 		
 	}
 	
-	/// Finally, result of the evaluation is copied to GAM memory
-	/// after being recasted to its original type.
-	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
+	inputStage = new InputStage[numInputStages];
+	outputStage = new OutputStage[numOutputStages];
+	
+	uint32 stageIdx = 0u;
+	for (uint32 sigIdx = 0; sigIdx < numInputSignals; sigIdx++) {
 		
-		for (uint32 elemIdx = 0; elemIdx < outputNumOfElements[sigIdx]; elemIdx++) {
-				
-			if (outputSignalType[sigIdx]==UnsignedInteger8Bit) {
-				
-				*( ((uint8*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<uint8>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==UnsignedInteger16Bit) {
-				
-				*( ((uint16*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<uint16>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==UnsignedInteger32Bit) {
-				
-				*( ((uint32*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<uint32>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==UnsignedInteger64Bit) {
-				
-				*( ((uint64*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<uint64>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==SignedInteger8Bit) {
-				
-				*( ((int8*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<int8>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==SignedInteger16Bit) {
-				
-				*( ((int16*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<int16>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==SignedInteger32Bit) {
-				
-				*( ((int32*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<int32>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==SignedInteger64Bit) {
-				
-				*( ((int64*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<int64>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==Float32Bit) {
-				
-				*( ((float32*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<float32>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else if (outputSignalType[sigIdx]==Float64Bit) {
-				
-				*( ((float64*)GetOutputSignalMemory(sigIdx)) + elemIdx ) = static_cast<float64>( localOutputArray[sigIdx][elemIdx] );
-				
-			} else {
-				
-				REPORT_ERROR(ErrorManagement::Exception,
-							 "Error while writing on GAM memory. Signal no. %i: unsupported type.",
-							 sigIdx);
-				
-			}
+		if (inputConverter[sigIdx] != NULL_PTR(InputConverter)) {
+			
+			inputStage[stageIdx].convert = inputConverter[sigIdx];
+			inputStage[stageIdx].signalMemory = GetInputSignalMemory(sigIdx);
+			inputStage[stageIdx].localMemory = &localInputArray[sigIdx][0];
+			inputStage[stageIdx].numberOfElements = inputNumOfElements[sigIdx];
+			stageIdx++;
 			
 		}
 		
 	}
 	
-	// Sleep for debugging
-	//MARTe::Sleep::Sec(1);
-	
-	return true;
-}
+	stageIdx = 0u;
+	for (uint32 sigIdx = 0; sigIdx < numOutputSignals; sigIdx++) {
+		
+		if (outputConverter[sigIdx] != NULL_PTR(OutputConverter)) {
+			
+			outputStage[stageIdx].convert = outputConverter[sigIdx];
+			outputStage[stageIdx].localMemory = &localOutputArray[sigIdx][0];
+			outputStage[stageIdx].signalMemory = GetOutputSignalMemory(sigIdx);
+			outputStage[stageIdx].numberOfElements = outputNumOfElements[sigIdx];
+			stageIdx++;
+			
+		}
+		
+	}
+	
+	///4. The variables are sorted in dependency order, then the symbol table
+	///   is passed to each expression and compiled.
+	ok = SortVariables();
+	if (!ok) {
+		
+		return ok;
+	}
+	
+	for (uint32 exprIdx = 0u; exprIdx < numExpressions; exprIdx++) {
+		
+		ok = CompileExpression(GetExpressionText(exprIdx),
+							   symbolName[GetExpressionSymbol(exprIdx)].Buffer(),
+							   symbolTable,
+							   expressionParser,
+							   schedule[0].expression[exprIdx]);
+		if (!ok) {
+			
+			return ok;
+		}
+		
+	}
+	
+	///5. The helpers are started and the execution steps are built.
+	if (numberOfThreads > 1u) {
+		
+		pool = new MathExpressionThreadPool();
+		ok = pool->Start(numberOfThreads - 1u, threadsCpuMask, stackSize);
+		if (!ok) {
+			
+			return ok;
+		}
+		
+	}
+	
+	BuildSchedule(schedule[0]);
+	activeSchedule = &schedule[0];
+	newestSchedule = 0u;
+	
+	///6. The expressions are evaluated once to count and preallocate the
+	///   state of the stateful functions, which is then reset.
+	statefulFunctions.BeginSizing(numExpressions);
+	
+	for (uint32 stepIdx = 0u; stepIdx < activeSchedule->numExecutionSteps; stepIdx++) {
+		
+		const ExecutionStep &step = activeSchedule->executionStep[stepIdx];
+		if (step.program != NULL_PTR(MathExpressionVectorProgram*)) {
+			step.program->Execute();
+		} else {
+			statefulFunctions.BeginExpressionSizing(step.expressionIdx);
+			step.expression->value();
+			statefulFunctions.EndExpressionSizing(step.expressionIdx);
+		}
+		
+	}
+	
+	statefulFunctions.EndSizing();
+	
+	if (statefulFunctions.GetNumberOfSlots() > 0u) {
+		
+		REPORT_ERROR(ErrorManagement::Information,
+					 "%i stateful function calls per cycle.",
+					 statefulFunctions.GetNumberOfSlots());
+					
+	}
+	
+	///7. The expressions are checked and their cost is reported.
+	ReportExpressions();
+
+	return ok;
+}
+
+bool MathExpressionGAM::Execute() {
+	
+	//REPORT_ERROR(ErrorManagement::Debug, "EXECUTE");
+	
+	/// GAM memory of the signals that are not float64 is copied in local
+	/// memory as a vector of float64.
+	for (uint32 stageIdx = 0u; stageIdx < numInputStages; stageIdx++) {
+		
+		const InputStage &stage = inputStage[stageIdx];
+		stage.convert(stage.signalMemory, stage.localMemory, stage.numberOfElements);
+		
+	}
+	
+	/// The variables and then the outputs are evaluated, switching first
+	/// to the schedule built by SetExpression(), if any.
+	if (pendingSchedule >= 0) {
+		
+		const int32 next = Atomic::Exchange(&pendingSchedule, -1);
+		if (next >= 0) {
+			activeSchedule = &schedule[next];
+		}
+		
+	}
+	
+	if (pool == NULL_PTR(MathExpressionThreadPool*)) {
+		
+		for (uint32 stepIdx = 0u; stepIdx < activeSchedule->numExecutionSteps; stepIdx++) {
+			
+			const ExecutionStep &step = activeSchedule->executionStep[stepIdx];
+			if (step.program != NULL_PTR(MathExpressionVectorProgram*)) {
+				step.program->Execute();
+			} else {
+				statefulFunctions.Select(step.expressionIdx);
+				step.expression->value();
+			}
+			
+		}
+		
+	} else {
+		
+		/// With the helpers, each phase is handed to the pool, which returns
+		/// when all its jobs are done. Phases of one job (among which all the
+		/// ones using the stateful functions) are run in this thread.
+		const uint32 numPhases = static_cast<uint32>(activeSchedule->phase.size());
+		for (uint32 phaseIdx = 0u; phaseIdx < numPhases; phaseIdx++) {
+			
+			const Phase &phase = activeSchedule->phase[phaseIdx];
+			const MathExpressionJob &job = activeSchedule->job[phase.firstJob];
+			if (phase.numberOfJobs > 1u) {
+				pool->Run(&job, phase.numberOfJobs);
+			} else {
+				if (job.program == NULL_PTR(MathExpressionVectorProgram*)) {
+					statefulFunctions.Select(job.expressionIdx);
+				}
+				MathExpressionThreadPool::RunJob(job, 0u);
+			}
+			
+		}
+		
+	}
+	
+	/// Finally, result of the evaluation is copied to GAM memory
+	/// after being recasted to its original type (float64 outputs
+	/// were written in place).
+	for (uint32 stageIdx = 0u; stageIdx < numOutputStages; stageIdx++) {
+		
+		const OutputStage &stage = outputStage[stageIdx];
+		stage.convert(stage.localMemory, stage.signalMemory, stage.numberOfElements);
+		
+	}
+	
+	// Sleep for debugging
+	//MARTe::Sleep::Sec(1);
+	
+	return true;
+}
+
+bool MathExpressionGAM::PrepareNextState(const char8 * const currentStateName,
+										 const char8 * const nextStateName) {
+	
+	statefulFunctions.Reset();
+	
+	return true;
+}
+
+ErrorManagement::ErrorType MathExpressionGAM::SetExpression(StreamString name,
+															 StreamString expression) {
+	
+	ErrorManagement::ErrorType ret = ErrorManagement::NoError;
+	
+	(void) swapMutex.FastLock();
+	
+	///1. The output or variable is looked up.
+	bool ok = (activeSchedule != NULL_PTR(Schedule*));
+	if (!ok) {
+		REPORT_ERROR(ErrorManagement::IllegalOperation,
+					 "SetExpression() called before Setup().");
+	}
+	
+	uint32 exprIdx = 0u;
+	if (ok) {
+		
+		ok = false;
+		for (uint32 i = 0u; (i < numExpressions) && !ok; i++) {
+			if (StringHelper::Compare(name.Buffer(), symbolName[GetExpressionSymbol(i)].Buffer()) == 0) {
+				exprIdx = i;
+				ok = true;
+			}
+		}
+		if (!ok) {
+			REPORT_ERROR(ErrorManagement::ParametersError,
+						 "%s is neither an output signal nor a variable.",
+						 name.Buffer());
+		}
+		
+	}
+	
+	///2. The expression is compiled against the shadow symbol table, which
+	///   is not used by Execute().
+	exprtk::expression<float64> compiled;
+	if (ok) {
+		ok = CompileExpression(expression, name.Buffer(), shadowSymbolTable, shadowParser, compiled);
+	}
+	
+	///3. The stateful calls of the expression are counted by evaluating it
+	///   on the scratch symbols and functions: they must fit the slots that
+	///   Setup() preallocated for the old expression.
+	if (ok) {
+		
+		exprtk::expression<float64> counted;
+		ok = CompileExpression(expression, name.Buffer(), scratchSymbolTable, shadowParser, counted);
+		if (ok) {
+			
+			scratchFunctions.BeginSizing(1u);
+			scratchFunctions.BeginExpressionSizing(0u);
+			(void) counted.value();
+			scratchFunctions.EndExpressionSizing(0u);
+			
+			ok = statefulFunctions.HasSlotsFor(exprIdx, scratchFunctions, 0u);
+			if (!ok) {
+				REPORT_ERROR(ErrorManagement::ParametersError,
+							 "The expression of %s calls a stateful function more times than the one configured at Setup(). Their state cannot be added at runtime.",
+							 name.Buffer());
+			}
+			
+		}
+		
+	}
+	
+	///4. A variable must not introduce circular dependencies.
+	StreamString previousText;
+	if (ok) {
+		
+		previousText = GetExpressionText(exprIdx).Buffer();
+		GetExpressionText(exprIdx) = expression.Buffer();
+		
+		if (exprIdx < numVariables) {
+			ok = SortVariables();
+			if (!ok) {
+				GetExpressionText(exprIdx) = previousText.Buffer();
+				(void) SortVariables();
+			}
+		}
+		
+	}
+	
+	///5. A new schedule is built in the schedule not used by Execute() and
+	///   handed over. If the previous one was not picked up yet, it is taken
+	///   back and rebuilt instead.
+	if (ok) {
+		
+		const int32 reclaimed = Atomic::Exchange(&pendingSchedule, -1);
+		const uint32 target = (reclaimed >= 0) ? newestSchedule : (1u - newestSchedule);
+		
+		if (target != newestSchedule) {
+			for (uint32 i = 0u; i < numExpressions; i++) {
+				schedule[target].expression[i] = schedule[newestSchedule].expression[i];
+			}
+		}
+		schedule[target].expression[exprIdx] = compiled;
+		
+		BuildSchedule(schedule[target]);
+		
+		newestSchedule = target;
+		(void) Atomic::Exchange(&pendingSchedule, static_cast<int32>(target));
+		
+		REPORT_ERROR(ErrorManagement::Information,
+					 "Expression of %s replaced, applied from the next cycle.",
+					 name.Buffer());
+		
+	}
+	
+	swapMutex.FastUnLock();
+	
+	if (!ok) {
+		ret = ErrorManagement::ParametersError;
+	}
+	
+	return ret;
+}
 
 CLASS_REGISTER(MathExpressionGAM, "1.0")
+CLASS_METHOD_REGISTER(MathExpressionGAM, SetExpression)
 
 /*---------------------------------------------------------------------------*/
 /*                           Method definitions                              */
@@ -466,4 +1074,766 @@ bool MathExpressionGAM::GetSignalNames(const SignalDirection direction,
 	
 }
 
+bool MathExpressionGAM::GetConverters(const TypeDescriptor &type,
+									  InputConverter &input,
+									  OutputConverter &output) {
+	
+	bool ok = true;
+	
+	if (type==UnsignedInteger8Bit) {
+		
+		input = &ConvertInput<uint8>;
+		output = &ConvertOutput<uint8>;
+		
+	} else if (type==UnsignedInteger16Bit) {
+		
+		input = &ConvertInput<uint16>;
+		output = &ConvertOutput<uint16>;
+		
+	} else if (type==UnsignedInteger32Bit) {
+		
+		input = &ConvertInput<uint32>;
+		output = &ConvertOutput<uint32>;
+		
+	} else if (type==UnsignedInteger64Bit) {
+		
+		input = &ConvertInput<uint64>;
+		output = &ConvertOutput<uint64>;
+		
+	} else if (type==SignedInteger8Bit) {
+		
+		input = &ConvertInput<int8>;
+		output = &ConvertOutput<int8>;
+		
+	} else if (type==SignedInteger16Bit) {
+		
+		input = &ConvertInput<int16>;
+		output = &ConvertOutput<int16>;
+		
+	} else if (type==SignedInteger32Bit) {
+		
+		input = &ConvertInput<int32>;
+		output = &ConvertOutput<int32>;
+		
+	} else if (type==SignedInteger64Bit) {
+		
+		input = &ConvertInput<int64>;
+		output = &ConvertOutput<int64>;
+		
+	} else if (type==Float32Bit) {
+		
+		input = &ConvertInput<float32>;
+		output = &ConvertOutput<float32>;
+		
+	} else if (type==Float64Bit) {
+		
+		// Bound directly to the GAM memory
+		input = NULL_PTR(InputConverter);
+		output = NULL_PTR(OutputConverter);
+		
+	} else {
+		
+		ok = false;
+		
+	}
+	
+	return ok;
+	
+}
+
+bool MathExpressionGAM::RegisterSymbols(exprtk::symbol_table<float64> &table,
+										const std::vector<float64*> &memory,
+										MathExpressionStatefulFunctions &functions) {
+	
+	bool ok = true;
+	
+	for (uint32 symbolIdx = 0u; (symbolIdx < symbolName.size()) && ok; symbolIdx++) {
+		
+		// To add a variable both its name and its memory address are passed
+		ok = table.add_vector(symbolName[symbolIdx].Buffer(),
+							  memory[symbolIdx],
+							  symbolSize[symbolIdx]);
+		if (!ok) {
+			
+			REPORT_ERROR(ErrorManagement::ParametersError,
+						 "add_vector() returned false while registering %s. Names of signals and variables must be valid and unique identifiers.",
+						 symbolName[symbolIdx].Buffer());
+			
+		}
+		
+	}
+	
+	// Stateful functions
+	if (ok) {
+		
+		ok = functions.Register(table);
+		if (!ok) {
+			
+			REPORT_ERROR(ErrorManagement::ParametersError,
+						 "add_function() returned false while registering the stateful functions. Their names cannot be used for signals or variables.");
+			
+		}
+		
+	}
+	
+	return ok;
+	
+}
+
+bool MathExpressionGAM::CompileExpression(StreamString &text,
+										  const char8 * const name,
+										  exprtk::symbol_table<float64> &table,
+										  exprtk::parser<float64> &parser,
+										  exprtk::expression<float64> &expression) {
+	
+	expression.register_symbol_table(table);
+	
+	bool ok = parser.compile(text.Buffer(), expression);
+	if (!ok) {
+		
+		REPORT_ERROR(ErrorManagement::ParametersError,
+					 "Compilation of expression for %s failed. Check the expression syntax.",
+					 name);
+		
+		for (uint32 i = 0; i < parser.error_count(); ++i) {
+			
+			exprtk::parser_error::type error = parser.get_error(i);
+			
+			exprtk::parser_error::update_error(error, text.Buffer());
+			
+			REPORT_ERROR(ErrorManagement::Information,
+						 "Error[%i]. Position: row %i, col %i. Type: %s. Msg: %s.",
+						 i,
+						 static_cast<uint32>(error.line_no),
+						 static_cast<uint32>(error.column_no),
+						 exprtk::parser_error::to_str(error.mode).c_str(),
+						 error.diagnostic.c_str()
+						);
+			
+		}
+		
+	}
+	
+	return ok;
+	
+}
+
+bool MathExpressionGAM::SortVariables() {
+	
+	bool ok = true;
+	
+	if (variableOrder == NULL_PTR(uint32*)) {
+		variableOrder = new uint32[numVariables];
+	}
+	
+	// uses[i * numVariables + j] is true if the expression of variable i
+	// contains the identifier of variable j
+	std::vector<bool> uses(numVariables * numVariables, false);
+	
+	const uint32 firstVariableSymbol = numInputSignals + numOutputSignals;
+	
+	for (uint32 varIdx = 0; varIdx < numVariables; varIdx++) {
+		
+		std::vector<bool> referenced(symbolName.size(), false);
+		std::vector<bool> assigned(symbolName.size(), false);
+		(void) GetReferencedSymbols(variableExpressionString[varIdx].Buffer(), referenced, assigned);
+		
+		// A variable assigning itself does not depend on itself
+		for (uint32 usedIdx = 0; usedIdx < numVariables; usedIdx++) {
+			uses[varIdx * numVariables + usedIdx] = (usedIdx != varIdx) && referenced[firstVariableSymbol + usedIdx];
+		}
+		
+	}
+	
+	// At each step the first variable (in declaration order) whose
+	// dependencies have all been sorted is appended.
+	std::vector<bool> sorted(numVariables, false);
+	
+	for (uint32 orderIdx = 0; (orderIdx < numVariables) && ok; orderIdx++) {
+		
+		ok = false;
+		
+		for (uint32 varIdx = 0; (varIdx < numVariables) && !ok; varIdx++) {
+			
+			if (!sorted[varIdx]) {
+				
+				bool ready = true;
+				for (uint32 usedIdx = 0; (usedIdx < numVariables) && ready; usedIdx++) {
+					ready = !uses[varIdx * numVariables + usedIdx] || sorted[usedIdx];
+				}
+				
+				if (ready) {
+					variableOrder[orderIdx] = varIdx;
+					sorted[varIdx] = true;
+					ok = true;
+				}
+				
+			}
+			
+		}
+		
+	}
+	
+	if (!ok) {
+		
+		for (uint32 varIdx = 0; varIdx < numVariables; varIdx++) {
+			
+			if (!sorted[varIdx]) {
+				REPORT_ERROR(ErrorManagement::ParametersError,
+							 "Variable %s is part of a circular dependency.",
+							 variableName[varIdx].Buffer());
+			}
+			
+		}
+		
+	}
+	
+	return ok;
+	
+}
+
+void MathExpressionGAM::BuildSchedule(Schedule &target) {
+	
+	if (target.executionStep != NULL_PTR(ExecutionStep*)) {
+		delete [] target.executionStep;
+	}
+	if (target.vectorProgram != NULL_PTR(MathExpressionVectorProgram*)) {
+		delete [] target.vectorProgram;
+	}
+	
+	target.vectorProgram = new MathExpressionVectorProgram[numExpressions];
+	target.executionStep = new ExecutionStep[numExpressions];
+	target.numExecutionSteps = 0u;
+	
+	target.stepOfExpression.assign(numExpressions, 0u);
+	
+	uint32 numOfPrograms = 0u;
+	MathExpressionVectorProgram* currentProgram = NULL_PTR(MathExpressionVectorProgram*);
+	
+	// Variables in dependency order, then outputs
+	for (uint32 orderIdx = 0u; orderIdx < numExpressions; orderIdx++) {
+		
+		const uint32 exprIdx = (orderIdx < numVariables) ? variableOrder[orderIdx] : orderIdx;
+		const char8 * const text = GetExpressionText(exprIdx).Buffer();
+		const uint32 symbolIdx = GetExpressionSymbol(exprIdx);
+		
+		bool added = false;
+		if (currentProgram != NULL_PTR(MathExpressionVectorProgram*)) {
+			added = currentProgram->AddStatement(text, symbolIdx);
+		}
+		
+		if (!added) {
+			
+			MathExpressionVectorProgram &freshProgram = target.vectorProgram[numOfPrograms];
+			freshProgram.SetVariables(&symbolName[0], &symbolMemory[0], &symbolSize[0], static_cast<uint32>(symbolName.size()));
+			added = freshProgram.AddStatement(text, symbolIdx);
+			
+			if (added) {
+				currentProgram = &freshProgram;
+				numOfPrograms++;
+				ExecutionStep &step = target.executionStep[target.numExecutionSteps];
+				step.program = currentProgram;
+				step.expression = NULL_PTR(exprtk::expression<float64>*);
+				step.expressionIdx = exprIdx;
+				target.numExecutionSteps++;
+			}
+			
+		}
+		
+		if (added) {
+			target.stepOfExpression[exprIdx] = target.numExecutionSteps - 1u;
+		}
+		
+		if (!added) {
+			
+			currentProgram = NULL_PTR(MathExpressionVectorProgram*);
+			ExecutionStep &step = target.executionStep[target.numExecutionSteps];
+			step.program = NULL_PTR(MathExpressionVectorProgram*);
+			step.expression = &target.expression[exprIdx];
+			step.expressionIdx = exprIdx;
+			target.stepOfExpression[exprIdx] = target.numExecutionSteps;
+			target.numExecutionSteps++;
+			
+		}
+		
+	}
+	
+	for (uint32 progIdx = 0u; progIdx < numOfPrograms; progIdx++) {
+		
+		target.vectorProgram[progIdx].Compile();
+		
+		REPORT_ERROR(ErrorManagement::Information,
+					 "Vector program %i evaluates %i expressions with %i shared subexpressions.",
+					 progIdx,
+					 target.vectorProgram[progIdx].GetNumberOfStatements(),
+					 target.vectorProgram[progIdx].GetNumberOfSharedSubexpressions());
+		
+	}
+	
+	if (pool != NULL_PTR(MathExpressionThreadPool*)) {
+		BuildPhases(target);
+	}
+	
+}
+
+void MathExpressionGAM::BuildPhases(Schedule &target) {
+	
+	const uint32 numSteps = target.numExecutionSteps;
+	const uint32 numSymbols = static_cast<uint32>(symbolName.size());
+	
+	///1. The symbols read and written by each step.
+	std::vector<bool> reads(numSteps * numSymbols, false);
+	std::vector<bool> writes(numSteps * numSymbols, false);
+	std::vector<bool> stateful(numSteps, false);
+	
+	for (uint32 exprIdx = 0u; exprIdx < numExpressions; exprIdx++) {
+		
+		const uint32 stepIdx = target.stepOfExpression[exprIdx];
+		const bool isProgram = (target.executionStep[stepIdx].program != NULL_PTR(MathExpressionVectorProgram*));
+		
+		std::vector<bool> referenced(numSymbols, false);
+		std::vector<bool> assigned(numSymbols, false);
+		if (GetReferencedSymbols(GetExpressionText(exprIdx).Buffer(), referenced, assigned)) {
+			stateful[stepIdx] = true;
+		}
+		
+		for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+			if (referenced[symbolIdx]) {
+				reads[stepIdx * numSymbols + symbolIdx] = true;
+			}
+			if (assigned[symbolIdx] && !isProgram) {
+				writes[stepIdx * numSymbols + symbolIdx] = true;
+			}
+		}
+		writes[stepIdx * numSymbols + GetExpressionSymbol(exprIdx)] = true;
+		
+	}
+	
+	///2. The register banks of the vector programs, one for each thread.
+	std::vector<uint32> bankOffset(numSteps, 0u);
+	uint32 bankTotal = 0u;
+	
+	for (uint32 stepIdx = 0u; stepIdx < numSteps; stepIdx++) {
+		
+		const MathExpressionVectorProgram * const program = target.executionStep[stepIdx].program;
+		if (program != NULL_PTR(MathExpressionVectorProgram*)) {
+			bankOffset[stepIdx] = bankTotal;
+			bankTotal += numberOfThreads * program->GetRegisterBankSize();
+		}
+		
+	}
+	
+	target.registerBanks.assign(bankTotal, 0.0);
+	target.job.clear();
+	target.phase.clear();
+	
+	///3. The steps are grouped in phases and split in jobs.
+	std::vector<bool> phaseReads(numSymbols, false);
+	std::vector<bool> phaseWrites(numSymbols, false);
+	bool phaseStateful = false;
+	
+	for (uint32 stepIdx = 0u; stepIdx < numSteps; stepIdx++) {
+		
+		bool independent = !target.phase.empty() && !phaseStateful && !stateful[stepIdx];
+		for (uint32 symbolIdx = 0u; (symbolIdx < numSymbols) && independent; symbolIdx++) {
+			
+			const bool stepReads = reads[stepIdx * numSymbols + symbolIdx];
+			const bool stepWrites = writes[stepIdx * numSymbols + symbolIdx];
+			independent = !(stepWrites && (phaseReads[symbolIdx] || phaseWrites[symbolIdx])) &&
+						  !(stepReads && phaseWrites[symbolIdx]);
+			
+		}
+		
+		if (!independent) {
+			
+			Phase phase;
+			phase.firstJob = static_cast<uint32>(target.job.size());
+			phase.numberOfJobs = 0u;
+			target.phase.push_back(phase);
+			phaseReads.assign(numSymbols, false);
+			phaseWrites.assign(numSymbols, false);
+			phaseStateful = stateful[stepIdx];
+			
+		}
+		
+		for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+			
+			if (reads[stepIdx * numSymbols + symbolIdx]) {
+				phaseReads[symbolIdx] = true;
+			}
+			if (writes[stepIdx * numSymbols + symbolIdx]) {
+				phaseWrites[symbolIdx] = true;
+			}
+			
+		}
+		
+		const ExecutionStep &step = target.executionStep[stepIdx];
+		MathExpressionJob job;
+		job.program = step.program;
+		job.expression = step.expression;
+		job.expressionIdx = step.expressionIdx;
+		job.registerBanks = NULL_PTR(float64*);
+		job.bankSize = 0u;
+		job.begin = 0u;
+		job.end = 0u;
+		
+		if (step.program != NULL_PTR(MathExpressionVectorProgram*)) {
+			
+			// Ranges of whole chunks, as even as possible
+			const uint32 numElements = step.program->GetNumberOfElements();
+			const uint32 numChunks = (numElements + MathExpressionVectorProgram::ChunkSize - 1u) / MathExpressionVectorProgram::ChunkSize;
+			const uint32 numRanges = (numChunks < numberOfThreads) ? numChunks : numberOfThreads;
+			
+			job.bankSize = step.program->GetRegisterBankSize();
+			if (job.bankSize > 0u) {
+				job.registerBanks = &target.registerBanks[bankOffset[stepIdx]];
+			}
+			
+			for (uint32 rangeIdx = 0u; rangeIdx < numRanges; rangeIdx++) {
+				
+				job.begin = job.end;
+				job.end = (((rangeIdx + 1u) * numChunks) / numRanges) * MathExpressionVectorProgram::ChunkSize;
+				if (job.end > numElements) {
+					job.end = numElements;
+				}
+				target.job.push_back(job);
+				target.phase.back().numberOfJobs++;
+				
+			}
+			
+		} else {
+			
+			target.job.push_back(job);
+			target.phase.back().numberOfJobs++;
+			
+		}
+		
+	}
+	
+	REPORT_ERROR(ErrorManagement::Information,
+				 "%i execution steps in %i phases of %i jobs on %i threads.",
+				 numSteps,
+				 static_cast<uint32>(target.phase.size()),
+				 static_cast<uint32>(target.job.size()),
+				 numberOfThreads);
+	
+}
+
+bool MathExpressionGAM::GetReferencedSymbols(const char8 * const text,
+											 std::vector<bool> &referenced,
+											 std::vector<bool> &assigned) const {
+	
+	bool stateful = false;
+	const char8* cursor = text;
+	
+	// The swap operator assigns both its sides
+	const bool swaps = (StringHelper::SearchString(text, "<=>") != NULL_PTR(const char8*));
+	
+	while (*cursor != '\0') {
+		
+		const bool identifierStart = ((*cursor >= 'a') && (*cursor <= 'z')) ||
+									 ((*cursor >= 'A') && (*cursor <= 'Z')) ||
+									 (*cursor == '_');
+		
+		if (identifierStart) {
+			
+			StreamString identifier;
+			while (((*cursor >= 'a') && (*cursor <= 'z')) ||
+				   ((*cursor >= 'A') && (*cursor <= 'Z')) ||
+				   ((*cursor >= '0') && (*cursor <= '9')) ||
+				   (*cursor == '_')) {
+				identifier += *cursor;
+				cursor++;
+			}
+			
+			// An assignment follows the identifier or its index
+			const char8* next = cursor;
+			while ((*next == ' ') || (*next == '\t') || (*next == '\n') || (*next == '\r')) {
+				next++;
+			}
+			if (*next == '[') {
+				uint32 depth = 0u;
+				do {
+					if (*next == '[') {
+						depth++;
+					} else if (*next == ']') {
+						depth--;
+					}
+					next++;
+				} while ((depth > 0u) && (*next != '\0'));
+				while ((*next == ' ') || (*next == '\t') || (*next == '\n') || (*next == '\r')) {
+					next++;
+				}
+			}
+			const bool assignment = swaps ||
+									(((*next == ':') || (*next == '+') || (*next == '-') || (*next == '*') || (*next == '/') || (*next == '%')) &&
+									 (next[1] == '='));
+			
+			for (uint32 symbolIdx = 0u; symbolIdx < symbolName.size(); symbolIdx++) {
+				if (StringHelper::Compare(identifier.Buffer(), symbolName[symbolIdx].Buffer()) == 0) {
+					referenced[symbolIdx] = true;
+					if (assignment) {
+						assigned[symbolIdx] = true;
+					}
+				}
+			}
+			if (MathExpressionStatefulFunctions::IsFunctionName(identifier.Buffer())) {
+				stateful = true;
+			}
+			
+		} else if ((*cursor >= '0') && (*cursor <= '9')) {
+			
+			// Skip numbers, so that e.g. 1e3 is not taken for an identifier
+			while (((*cursor >= '0') && (*cursor <= '9')) ||
+				   ((*cursor >= 'a') && (*cursor <= 'z')) ||
+				   ((*cursor >= 'A') && (*cursor <= 'Z')) ||
+				   (*cursor == '.')) {
+				cursor++;
+			}
+			
+		} else {
+			
+			cursor++;
+			
+		}
+		
+	}
+	
+	return stateful;
+	
+}
+
+void MathExpressionGAM::ReportExpressions() {
+	
+	const uint32 numSymbols = static_cast<uint32>(symbolName.size());
+	const uint32 firstVariableSymbol = numInputSignals + numOutputSignals;
+	const uint32 numSteps = activeSchedule->numExecutionSteps;
+	
+	///1. Inputs and variables that no other expression uses, outputs that
+	///   are not assigned and vectors of different lengths.
+	std::vector<bool> used(numSymbols, false);
+	
+	for (uint32 exprIdx = 0u; exprIdx < numExpressions; exprIdx++) {
+		
+		const char8 * const text = GetExpressionText(exprIdx).Buffer();
+		const uint32 ownSymbol = GetExpressionSymbol(exprIdx);
+		std::vector<bool> referenced(numSymbols, false);
+		std::vector<bool> assigned(numSymbols, false);
+		(void) GetReferencedSymbols(text, referenced, assigned);
+		
+		uint32 shortest = 0u;
+		uint32 longest = 0u;
+		for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+			
+			if (referenced[symbolIdx]) {
+				if (symbolIdx != ownSymbol) {
+					used[symbolIdx] = true;
+				}
+				if ((shortest == 0u) || (symbolSize[symbolIdx] < shortest)) {
+					shortest = symbolSize[symbolIdx];
+				}
+				if (symbolSize[symbolIdx] > longest) {
+					longest = symbolSize[symbolIdx];
+				}
+			}
+			
+		}
+		
+		if (!assigned[ownSymbol]) {
+			REPORT_ERROR(ErrorManagement::Warning,
+						 "The expression of %s does not assign it.",
+						 symbolName[ownSymbol].Buffer());
+		}
+		
+		// Without indexing, whole vectors are combined
+		if ((StringHelper::SearchString(text, "[") == NULL_PTR(const char8*)) && (shortest != longest)) {
+			REPORT_ERROR(ErrorManagement::Warning,
+						 "The expression of %s combines vectors of %i and %i elements: only %i elements are computed.",
+						 symbolName[ownSymbol].Buffer(),
+						 shortest,
+						 longest,
+						 shortest);
+		}
+		
+		StreamString loopedCalls;
+		(void) CountOperations(text, loopedCalls);
+		if (loopedCalls.Size() > 0u) {
+			REPORT_ERROR(ErrorManagement::Warning,
+						 "The expression of %s calls %s in a loop.",
+						 symbolName[ownSymbol].Buffer(),
+						 loopedCalls.Buffer());
+		}
+		
+	}
+	
+	for (uint32 sigIdx = 0u; sigIdx < numInputSignals; sigIdx++) {
+		
+		if (!used[sigIdx]) {
+			REPORT_ERROR(ErrorManagement::Warning,
+						 "Input signal %s is not used by any expression.",
+						 symbolName[sigIdx].Buffer());
+		}
+		
+	}
+	
+	for (uint32 varIdx = 0u; varIdx < numVariables; varIdx++) {
+		
+		if (!used[firstVariableSymbol + varIdx]) {
+			REPORT_ERROR(ErrorManagement::Warning,
+						 "Variable %s is not used by any other expression.",
+						 variableName[varIdx].Buffer());
+		}
+		
+	}
+	
+	///2. Each execution step and the signal conversions are measured, the
+	///   overhead of reading the counter being subtracted.
+	uint64 overhead = 0u;
+	for (uint32 r = 0u; r < NumberOfRepetitions; r++) {
+		
+		const uint64 start = HighResolutionTimer::Counter();
+		const uint64 elapsed = HighResolutionTimer::Counter() - start;
+		if ((r == 0u) || (elapsed < overhead)) {
+			overhead = elapsed;
+		}
+		
+	}
+	
+	std::vector<uint64> stepCost(numSteps, 0u);
+	for (uint32 stepIdx = 0u; stepIdx < numSteps; stepIdx++) {
+		
+		const ExecutionStep &step = activeSchedule->executionStep[stepIdx];
+		for (uint32 r = 0u; r < NumberOfRepetitions; r++) {
+			
+			if (step.program == NULL_PTR(MathExpressionVectorProgram*)) {
+				statefulFunctions.Select(step.expressionIdx);
+			}
+			const uint64 start = HighResolutionTimer::Counter();
+			if (step.program != NULL_PTR(MathExpressionVectorProgram*)) {
+				step.program->Execute();
+			} else {
+				step.expression->value();
+			}
+			uint64 elapsed = HighResolutionTimer::Counter() - start;
+			elapsed = (elapsed > overhead) ? (elapsed - overhead) : 0u;
+			if ((r == 0u) || (elapsed < stepCost[stepIdx])) {
+				stepCost[stepIdx] = elapsed;
+			}
+			
+		}
+		
+	}
+	
+	statefulFunctions.Reset();
+	
+	uint64 conversionCost = 0u;
+	for (uint32 r = 0u; r < NumberOfRepetitions; r++) {
+		
+		const uint64 start = HighResolutionTimer::Counter();
+		for (uint32 stageIdx = 0u; stageIdx < numInputStages; stageIdx++) {
+			const InputStage &stage = inputStage[stageIdx];
+			stage.convert(stage.signalMemory, stage.localMemory, stage.numberOfElements);
+		}
+		for (uint32 stageIdx = 0u; stageIdx < numOutputStages; stageIdx++) {
+			const OutputStage &stage = outputStage[stageIdx];
+			stage.convert(stage.localMemory, stage.signalMemory, stage.numberOfElements);
+		}
+		uint64 elapsed = HighResolutionTimer::Counter() - start;
+		elapsed = (elapsed > overhead) ? (elapsed - overhead) : 0u;
+		if ((r == 0u) || (elapsed < conversionCost)) {
+			conversionCost = elapsed;
+		}
+		
+	}
+	
+	///3. The report, in evaluation order.
+	const float64 microseconds = HighResolutionTimer::Period() * 1e6;
+	uint64 totalCost = 0u;
+	
+	for (uint32 orderIdx = 0u; orderIdx < numExpressions; orderIdx++) {
+		
+		const uint32 exprIdx = (orderIdx < numVariables) ? variableOrder[orderIdx] : orderIdx;
+		const uint32 stepIdx = activeSchedule->stepOfExpression[exprIdx];
+		const ExecutionStep &step = activeSchedule->executionStep[stepIdx];
+		const uint32 ownSymbol = GetExpressionSymbol(exprIdx);
+		
+		// Length and binding of each symbol
+		std::vector<bool> referenced(numSymbols, false);
+		std::vector<bool> assigned(numSymbols, false);
+		(void) GetReferencedSymbols(GetExpressionText(exprIdx).Buffer(), referenced, assigned);
+		
+		StreamString symbols;
+		for (uint32 symbolIdx = 0u; symbolIdx < numSymbols; symbolIdx++) {
+			
+			if (referenced[symbolIdx]) {
+				const char8* binding = "local";
+				if (symbolIdx < numInputSignals) {
+					binding = (inputConverter[symbolIdx] == NULL_PTR(InputConverter)) ? "direct" : "converted";
+				} else if (symbolIdx < firstVariableSymbol) {
+					binding = (outputConverter[symbolIdx - numInputSignals] == NULL_PTR(OutputConverter)) ? "direct" : "converted";
+				} else {
+					// Variables live in the GAM
+				}
+				(void) symbols.Printf(" %s[%i] %s", symbolName[symbolIdx].Buffer(), symbolSize[symbolIdx], binding);
+			}
+			
+		}
+		
+		const float64 cost = static_cast<float64>(stepCost[stepIdx]) * microseconds;
+		
+		if (step.program != NULL_PTR(MathExpressionVectorProgram*)) {
+			
+			// The cost of the program is reported with its first expression
+			const bool first = (step.expressionIdx == exprIdx);
+			if (first) {
+				totalCost += stepCost[stepIdx];
+			}
+			REPORT_ERROR(ErrorManagement::Information,
+						 "%s: vector program %i, %i operations per element on %i elements, %i cycles (%f us)%s. Symbols:%s",
+						 symbolName[ownSymbol].Buffer(),
+						 static_cast<uint32>(step.program - activeSchedule->vectorProgram),
+						 step.program->GetNumberOfInstructions(),
+						 step.program->GetNumberOfElements(),
+						 first ? stepCost[stepIdx] : 0u,
+						 first ? cost : 0.0,
+						 first ? "" : " (counted in the first expression of the program)",
+						 symbols.Buffer());
+						
+		} else {
+			
+			totalCost += stepCost[stepIdx];
+			StreamString loopedCalls;
+			REPORT_ERROR(ErrorManagement::Information,
+						 "%s: exprtk, about %i operations per element, %i cycles (%f us). Symbols:%s",
+						 symbolName[ownSymbol].Buffer(),
+						 CountOperations(GetExpressionText(exprIdx).Buffer(), loopedCalls),
+						 stepCost[stepIdx],
+						 cost,
+						 symbols.Buffer());
+						
+		}
+		
+	}
+	
+	REPORT_ERROR(ErrorManagement::Information,
+				 "Estimated cost of a cycle on one thread: %i cycles (%f us) for the expressions and %i cycles (%f us) for the signal conversions.",
+				 totalCost,
+				 static_cast<float64>(totalCost) * microseconds,
+				 conversionCost,
+				 static_cast<float64>(conversionCost) * microseconds);
+				
+}
+
+StreamString &MathExpressionGAM::GetExpressionText(const uint32 exprIdx) {
+	
+	return (exprIdx < numVariables) ? variableExpressionString[exprIdx] : expressionString[exprIdx - numVariables];
+	
+}
+
+uint32 MathExpressionGAM::GetExpressionSymbol(const uint32 exprIdx) const {
+	
+	return (exprIdx < numVariables) ? (numInputSignals + numOutputSignals + exprIdx) : (numInputSignals + exprIdx - numVariables);
+	
+}
+
 } /* namespace MARTe */
@@ -35,8 +35,14 @@
 #include "GAM.h"
 #include "StructuredDataI.h"
 #include "MessageI.h"
+#include "RegisteredMethodsMessageFilter.h"
+#include "StatefulI.h"
+#include "FastPollingMutexSem.h"
 
 #include "exprtk.hpp"
+#include "MathExpressionVectorProgram.h"
+#include "MathExpressionStatefulFunctions.h"
+#include "MathExpressionThreadPool.h"
 
 /*---------------------------------------------------------------------------*/
 /*                           Class declaration                               */
@@ -66,9 +72,11 @@ namespace MARTe {
  * the smallest vector. To perform operations between vector of different sizes
  * consider using a for-loopm (see example below).
  * 
- * For the sake of simplicity, each signal is typecasted to float64 before
- * being passed to the library, and typecasted back to its native type
- * when copied in the GAM output memory.
+ * The library works in float64. float64 signals are bound directly to the
+ * GAM signal memory, so that no copy is performed. Signals of any other type
+ * are typecasted to a local float64 copy before being passed to the library,
+ * and typecasted back to their native type when copied in the GAM output
+ * memory. The conversion function of each signal is chosen in Setup().
  * 
  * The configuration syntax is (names and expression are only given as an example):
  * 
@@ -103,10 +111,119 @@ namespace MARTe {
  * }
  * </pre>
  * 
+ * Intermediate results that are used by more than one output can be declared
+ * in the optional Variables node. Each variable is a float64 vector (of
+ * NumberOfElements elements, default 1) that is assigned by its Expression,
+ * evaluated once per cycle before the outputs, and that can be used in the
+ * expressions of the outputs and of the other variables:
+ * 
+ * <pre>
+ *     Variables = {
+ *         Mag = {
+ *             Expression = "Mag := sqrt(In3 * In3 + In4 * In4);"
+ *             NumberOfElements = 8
+ *         }
+ *     }
+ * </pre>
+ * 
+ * The variables are evaluated in dependency order (a variable is evaluated
+ * after the variables its expression uses); circular dependencies are
+ * rejected in Setup().
+ * 
+ * Expressions that are a single element-wise assignment, e.g.
+ * "Out := In1[0] * In3 + sqrt(In4);", are evaluated by flat vector programs
+ * (see MathExpressionVectorProgram), which are faster than exprtk on wide
+ * signals. Consecutive element-wise expressions with the same number of
+ * elements share one program, where identical subexpressions (e.g. the same
+ * sqrt(In3 * In3 + In4 * In4) in two outputs) are computed once per cycle.
+ * All the other expressions are evaluated by exprtk.
+ * 
+ * The expressions can also use functions that keep a state from one cycle
+ * to the next:
+ * - delay(x, n): value of x n cycles before (0 before the first n cycles),
+ * - integrate(x, dt): running sum of x * dt,
+ * - derivative(x, dt): (x - previous x) / dt (0 in the first cycle),
+ * - movavg(x, n): average of the last n values of x,
+ * - biquad(x, coeffs): second order IIR section, coeffs = [b0, b1, b2, a1, a2].
+ * 
+ * e.g. "Out1 := 2.5 * (Err + integrate(Err, 0.001));". Their state is
+ * preallocated in Setup(), by evaluating the expressions once, and is reset
+ * at each state transition. Each call during a cycle has its own state, so
+ * the functions must be called the same number of times and in the same
+ * order in every cycle (see MathExpressionStatefulFunction).
+ * 
+ * The history kept by delay and movavg is sized on the n they are called
+ * with in Setup(). When n is not a constant (e.g. a signal, which is 0 in
+ * Setup()), the largest n expected at runtime must be configured; a larger
+ * n returns NaN and is reported:
+ * 
+ * <pre>
+ *     MaxHistoryLength = 1000   // Optional. Largest n of delay and movavg when it is not constant. Default 0 (the n seen in Setup()).
+ * </pre>
+* 
+ * The expression of an output or of a variable can be replaced while the
+ * application runs by sending the GAM a SetExpression message with the name
+ * of the output or variable and the new expression:
+ * 
+ * <pre>
+ * +SetGainMsg = {
+ *     Class = Message
+ *     Destination = "App.Functions.GAM1"
+ *     Function = SetExpression
+ *     Mode = ExpectsReply
+ *     +Parameters = {
+ *         Class = ConfigurationDatabase
+ *         param1 = Out1
+ *         param2 = "Out1 := 3.0 * (Err + integrate(Err, 0.001));"
+ *     }
+ * }
+ * </pre>
+ * 
+ * The new expression is compiled in the thread that handles the message,
+ * and the GAM switches to it at the beginning of its next cycle. If it does
+ * not compile, the running expressions are left untouched. A replaced
+ * expression keeps the state of the stateful functions of the old one (its
+ * k-th call continues from the k-th call of the old expression). Since that
+ * state is preallocated by Setup(), an expression calling a stateful function
+ * more times than the old one is rejected as well.
+ * 
+ * Configurations with very wide signals can spread the evaluation over a
+ * pool of helper threads:
+ * 
+ * <pre>
+ *     NumberOfThreads = 4   // Optional. Threads evaluating the expressions (the real-time thread and NumberOfThreads - 1 helpers). Default 1.
+ *     ThreadsCPUs = 0xf0    // Optional. CPU mask of the helpers, the i-th helper is pinned to the i-th CPU of the mask. Default 0xff.
+ *     StackSize = 1048576   // Optional. Stack size of the helpers. Default THREADS_DEFAULT_STACKSIZE.
+ * </pre>
+ * 
+ * Consecutive execution steps that do not write what the others read or
+ * write are evaluated concurrently, and the elements of each vector program
+ * are split in ranges (multiples of MathExpressionVectorProgram::ChunkSize)
+ * among the threads. Expressions that use the stateful functions are always
+ * evaluated alone by the real-time thread. All the threads are done before
+ * the outputs are copied to the GAM memory.
+ * 
+ * At the end of Setup() each expression is checked and its cost is
+ * reported, so that the real-time budget can be verified before running:
+ * - a warning for input signals and variables that no expression uses, for
+ *   expressions that do not assign their output or variable, for expressions
+ *   without indexing that mix vectors of different lengths (only the
+ *   elements of the shortest one are computed) and for expensive functions
+ *   (sin, exp, pow, ...) called in loops;
+ * - the evaluator (vector program or exprtk), the number of operations per
+ *   element (exact for vector programs, estimated from the text for exprtk),
+ *   the length of each symbol and whether it is bound directly to the GAM
+ *   memory or converted;
+ * - the cost of each execution step, measured by evaluating it a few times
+ *   (best of MathExpressionGAM::NumberOfRepetitions, less the overhead of
+ *   reading the counter) in high resolution timer ticks, which are the
+ *   cycles of the time stamp counter on x86, and in microseconds. The costs
+ *   are the ones of a single thread.
+ * 
  * @todo Add support for constants specified in configuration file.
  */
 
-class MathExpressionGAM : public GAM {
+class MathExpressionGAM : public GAM, public StatefulI, public MessageI {
 public:
 	CLASS_REGISTER_DECLARATION()
 	
@@ -120,7 +237,7 @@ public:
 	 * read from the configuration file and expression are stored.
 	 * @param[in] data the GAM configuration specified in the configuration file.
 	 * @return true on succeed.
-	 * @pre Each output signal must have an "Expression" parameter.
+	 * @pre Each output signal and each variable must have an "Expression" parameter.
 	 */
 	virtual bool Initialise(StructuredDataI & data);
 	
@@ -128,8 +245,12 @@ public:
 	 * @brief Checks parameters and compile exprtk expressions. 
 	 * @details This method:
 	 * 1. checks if types and dimensions retrieved from the configuration file are correct,
-	 * 2. allocates a local float64 recast of GAM memory,
-	 * 3. uses exprtk library to parse and compile expressions.
+	 * 2. allocates a local float64 recast of the GAM memory of the signals
+	 *    that are not float64 and selects their conversion functions,
+	 * 3. uses exprtk library to parse and compile expressions,
+	 * 4. evaluates the expressions once to preallocate the state of the
+	 *    stateful functions,
+	 * 5. reports the checks and the cost of the expressions (see ReportExpressions()).
 	 * 
 	 * Expressions are compiled here since one of strenghts of exprtk is that
 	 * expressions do not need to be recompiled each time they are evaluated,
@@ -151,6 +272,28 @@ public:
 	 */
 	virtual bool Execute();
 	
+	/**
+	 * @brief Resets the state of the stateful functions.
+	 * @return true.
+	 */
+	virtual bool PrepareNextState(const char8 * const currentStateName,
+								  const char8 * const nextStateName);
+	
+	/**
+	 * @brief Replaces the expression of an output signal or of a variable.
+	 * @details The expression is compiled in the calling thread against a
+	 * shadow symbol table, and a new schedule is built and handed to
+	 * Execute(), which switches to it at the beginning of the next cycle.
+	 * Can be called again before the switch; the last call wins.
+	 * @param[in] name the name of the output signal or variable.
+	 * @param[in] expression the new expression.
+	 * @return ErrorManagement::NoError if the expression was compiled and
+	 * scheduled, an error otherwise (the running expressions are not changed).
+	 * @pre Setup().
+	 */
+	ErrorManagement::ErrorType SetExpression(StreamString name,
+											 StreamString expression);
+	
 private:
 	/**
 	 * @name Signal data
@@ -173,6 +316,45 @@ private:
 	std::vector< std::vector<float64> > localOutputArray;	//!< Vector of vectors where a float64 recast of outputs is stored locally.
 	//@}
 	
+	/**
+	 * @name Signal conversion
+	 * Conversion functions between the GAM memory and the local float64 copy.
+	 * NULL for float64 signals, which are bound directly to the GAM memory.
+	 */
+	//@{
+	typedef void (*InputConverter)(const void * const source, float64 * const destination, const uint32 numberOfElements);
+	typedef void (*OutputConverter)(const float64 * const source, void * const destination, const uint32 numberOfElements);
+	
+	InputConverter*  inputConverter;	//!< Conversion from the input signal type to float64.
+	OutputConverter* outputConverter;	//!< Conversion from float64 to the output signal type.
+	//@}
+	
+	/**
+	 * @name Signal staging
+	 * One entry for each signal that is converted during Execute(), with the
+	 * GAM and local memory addresses resolved in Setup().
+	 */
+	//@{
+	struct InputStage {
+		InputConverter convert;				//!< Conversion function of the signal.
+		const void*    signalMemory;		//!< GAM memory of the signal.
+		float64*       localMemory;			//!< Local float64 copy of the signal.
+		uint32         numberOfElements;	//!< Number of elements of the signal.
+	};
+	
+	struct OutputStage {
+		OutputConverter convert;			//!< Conversion function of the signal.
+		const float64*  localMemory;		//!< Local float64 copy of the signal.
+		void*           signalMemory;		//!< GAM memory of the signal.
+		uint32          numberOfElements;	//!< Number of elements of the signal.
+	};
+	
+	uint32       numInputStages;	//!< Number of input signals that are not float64.
+	uint32       numOutputStages;	//!< Number of output signals that are not float64.
+	InputStage*  inputStage;		//!< Staging table of the inputs.
+	OutputStage* outputStage;		//!< Staging table of the outputs.
+	//@}
+	
 	/**
 	 * @name Expressions of output signals
 	 * Expressions to be evaluated during run-time are stored here.
@@ -182,13 +364,103 @@ private:
 	uint64        numOfSignalVariables;	//!< Number of variables used in the expression.
 	//@}
 	
+	/**
+	 * @name Intermediate variables
+	 * Declared in the Variables node and evaluated before the outputs.
+	 */
+	//@{
+	uint32        numVariables;				//!< Number of intermediate variables.
+	StreamString* variableName;				//!< Name of each variable.
+	StreamString* variableExpressionString;	//!< String expression for each variable.
+	uint32*       variableNumOfElements;	//!< Number of elements of each variable.
+	uint32*       variableOrder;			//!< Evaluation order of the variables.
+	std::vector< std::vector<float64> > localVariableArray;	//!< Memory of the variables.
+	//@}
+	
 	/**
 	 * @name exprtk library objects
 	 */
 	//@{
 	exprtk::symbol_table<float64> symbolTable;		//<! Stores variables.
 	exprtk::parser<float64>       expressionParser;	//<! Parses the expressions.
-	exprtk::expression<float64>*  outputExpression;	//<! Stores one expression for each output signal declared in the configuration file.
+	exprtk::symbol_table<float64> shadowSymbolTable;	//<! Same symbols as symbolTable, used by SetExpression().
+	exprtk::parser<float64>       shadowParser;		//<! Parses the expressions of SetExpression().
+	MathExpressionStatefulFunctions statefulFunctions;	//<! delay, integrate, derivative, movavg and biquad.
+	exprtk::symbol_table<float64> scratchSymbolTable;	//<! Same symbols as symbolTable, bound to scratchMemory.
+	MathExpressionStatefulFunctions scratchFunctions;	//<! Count the stateful calls of the expressions of SetExpression().
+//@}
+	
+	/**
+	 * @name Symbols
+	 * The inputs, the outputs and the variables, in this order, with the
+	 * float64 memory they are bound to.
+	 */
+	//@{
+	std::vector<StreamString> symbolName;
+	std::vector<float64*>     symbolMemory;
+	std::vector<uint32>       symbolSize;
+	std::vector<float64*>     scratchSymbolMemory;	//!< Memory of the symbols in scratchSymbolTable.
+	std::vector<float64>      scratchMemory;		//!< Copy of the symbols, written when SetExpression() counts the stateful calls.
+	//@}
+	
+	/**
+	 * @name Execution steps
+	 * The variables (in dependency order) and then the outputs are evaluated,
+	 * each one either by exprtk or, for consecutive element-wise expressions,
+	 * by a MathExpressionVectorProgram (see MathExpressionVectorProgram for the
+	 * supported syntax).
+	 */
+	//@{
+	struct ExecutionStep {
+		MathExpressionVectorProgram* program;		//!< Program evaluating one or more expressions (NULL for exprtk).
+		exprtk::expression<float64>* expression;	//!< Expression evaluated by exprtk.
+		uint32                       expressionIdx;	//!< Index of the expression evaluated by exprtk.
+	};
+	
+	/**
+	 * Jobs of the pool that can run concurrently (see MathExpressionThreadPool).
+	 */
+	struct Phase {
+		uint32 firstJob;		//!< Index of the first job of the phase.
+		uint32 numberOfJobs;	//!< Number of jobs of the phase.
+	};
+	
+	/**
+	 * Everything that is evaluated in a cycle. Expression i < numVariables is
+	 * the one of variable i, the others are the ones of the outputs.
+	 */
+	struct Schedule {
+		exprtk::expression<float64>*   expression;				//!< Compiled expressions.
+		MathExpressionVectorProgram*   vectorProgram;			//!< Vector programs (at most one for each expression).
+		uint32                         numExecutionSteps;		//!< Number of execution steps.
+		ExecutionStep*                 executionStep;			//!< Steps executed in each cycle.
+		std::vector<uint32>            stepOfExpression;		//!< Execution step of each expression.
+		std::vector<Phase>             phase;					//!< Execution steps grouped for the pool (empty without pool).
+		std::vector<MathExpressionJob> job;						//!< Jobs of the phases.
+		std::vector<float64>           registerBanks;			//!< Registers of the vector programs for each thread.
+	};
+	
+	uint32 numExpressions;	//!< Number of variables plus number of outputs.
+	
+	/**
+	 * Two schedules, so that SetExpression() can build one while Execute()
+	 * runs the other.
+	 */
+	Schedule        schedule[2];
+	Schedule*       activeSchedule;		//!< Schedule run by Execute().
+	volatile int32  pendingSchedule;	//!< Schedule to be run from the next cycle (-1 if none).
+	uint32          newestSchedule;		//!< Last schedule built.
+	FastPollingMutexSem swapMutex;		//!< Serialises the calls to SetExpression().
+	//@}
+	
+	/**
+	 * @name Parallel evaluation
+	 */
+	//@{
+	uint32 numberOfThreads;				//!< Threads evaluating the expressions, the real-time one included.
+	uint32 threadsCpuMask;				//!< CPU mask of the helpers.
+	uint32 stackSize;					//!< Stack size of the helpers.
+	MathExpressionThreadPool* pool;		//!< Helpers (NULL if numberOfThreads is 1).
 	//@}
 	
 	/**
@@ -199,6 +471,105 @@ private:
 	bool GetSignalNames(const SignalDirection direction,
 						StreamString* names);
 	
+	/**
+	 * @brief Adds the symbols and the stateful functions to a symbol table.
+	 * @param[in] memory the memory each symbol is bound to.
+	 * @param[in] functions the stateful functions.
+	 * @return true if all the names could be registered.
+	 */
+	bool RegisterSymbols(exprtk::symbol_table<float64> &table,
+						 const std::vector<float64*> &memory,
+						 MathExpressionStatefulFunctions &functions);
+	
+	/**
+	 * @brief Compiles an expression with exprtk, reporting the parser errors.
+	 * @param[in] text the expression.
+	 * @param[in] name the name of the output signal or variable, for the error messages.
+	 * @param[in] table the symbol table.
+	 * @param[in] parser the parser.
+	 * @param[out] expression the compiled expression.
+	 * @return true if the expression was compiled.
+	 */
+	bool CompileExpression(StreamString &text,
+						   const char8 * const name,
+						   exprtk::symbol_table<float64> &table,
+						   exprtk::parser<float64> &parser,
+						   exprtk::expression<float64> &expression);
+	
+	/**
+	 * @brief Builds the execution steps of a schedule from its expressions.
+	 * @details Consecutive element-wise expressions are appended to the same
+	 * vector program; the program is closed by the first expression that it
+	 * cannot take, which is evaluated by exprtk.
+	 */
+	void BuildSchedule(Schedule &target);
+	
+	/**
+	 * @brief Groups the execution steps of a schedule in phases for the pool.
+	 * @details Consecutive steps join the current phase as long as they do not
+	 * write a symbol that the phase reads or writes, nor read a symbol that the
+	 * phase writes (see GetReferencedSymbols()). Steps that use the stateful
+	 * functions get a phase of their own. Each vector program is split in up
+	 * to numberOfThreads jobs.
+	 */
+	void BuildPhases(Schedule &target);
+	
+	/**
+	 * @brief Lists the symbols referenced by an expression.
+	 * @details The symbols are found by scanning the identifiers of the text,
+	 * so that it is conservative: e.g. a symbol mentioned in a branch that is
+	 * never taken is still referenced.
+	 * @param[in] text the expression.
+	 * @param[out] referenced set to true for each symbol that appears in \a text.
+	 * @param[out] assigned set to true for each symbol (or element of it) that
+	 * is followed by an assignment operator, or for every symbol if \a text
+	 * swaps values.
+	 * @return true if \a text calls one of the stateful functions.
+	 */
+	bool GetReferencedSymbols(const char8 * const text,
+							  std::vector<bool> &referenced,
+							  std::vector<bool> &assigned) const;
+							
+	/**
+	 * @brief Checks the expressions of the active schedule and reports their cost.
+	 * @details The execution steps are evaluated NumberOfRepetitions times
+	 * each and the state of the stateful functions is reset afterwards.
+	 */
+	void ReportExpressions();
+	
+	/**
+	 * Number of evaluations of each execution step in ReportExpressions().
+	 */
+	static const uint32 NumberOfRepetitions = 8u;
+
+	/**
+	 * @return the text of expression \a exprIdx (see Schedule).
+	 */
+	StreamString &GetExpressionText(const uint32 exprIdx);
+	
+	/**
+	 * @return the index in the symbols of the variable or output assigned by
+	 * expression \a exprIdx.
+	 */
+	uint32 GetExpressionSymbol(const uint32 exprIdx) const;
+	
+	/**
+	 * @brief Sorts the variables so that each one is evaluated after the ones it uses.
+	 * @return false if the variables have circular dependencies.
+	 */
+	bool SortVariables();
+	
+	/**
+	 * @brief Selects the conversion functions for a signal type.
+	 * @param[in] type the signal type.
+	 * @param[out] input the conversion from \a type to float64 (NULL for float64).
+	 * @param[out] output the conversion from float64 to \a type (NULL for float64).
+	 * @return false if the type is not supported.
+	 */
+	static bool GetConverters(const TypeDescriptor &type,
+							  InputConverter &input,
+							  OutputConverter &output);
+	
 };
 
 } /* Namespace MARTe */
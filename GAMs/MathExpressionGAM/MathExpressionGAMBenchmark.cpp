@@ -0,0 +1,227 @@
+/**
+ * @file MathExpressionGAMBenchmark.cpp
+ * @brief Standalone benchmark of the signal staging of MathExpressionGAM::Execute
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details For every signal type and every number of elements a one GAM
+ * RealTimeApplication is configured, whose MathExpressionGAM sums
+ * NumberOfInputs input signals into one output signal of the same type.
+ * MathExpressionGAM::Execute is called in a loop from the main thread and
+ * the table of the cycle times (minimum, median and maximum, in microseconds)
+ * is written to the standard output. float64 signals are bound directly to
+ * the GAM memory, so that the difference between the float64 rows and the
+ * other rows is the cost of the staging of the signals.
+ *
+ * Built by "make -f Makefile.linux benchmark" and run as
+ * MathExpressionGAMBenchmark.ex [NumberOfCycles (default 1000)]
+ */
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include "AdvancedErrorManagement.h"
+#include "ConfigurationDatabase.h"
+#include "HighResolutionTimer.h"
+#include "MathExpressionGAM.h"
+#include "ObjectRegistryDatabase.h"
+#include "RealTimeApplication.h"
+#include "StandardParser.h"
+#include "StreamString.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+using namespace MARTe;
+
+/**
+ * Signal types and numbers of elements measured.
+ */
+static const char8 * const Types[] = { "float64", "float32", "int32", "uint16" };
+static const uint32 NumberOfTypes = sizeof(Types) / sizeof(Types[0]);
+static const uint32 Sizes[] = { 1u, 16u, 4096u };
+static const uint32 NumberOfSizes = sizeof(Sizes) / sizeof(Sizes[0]);
+
+/**
+ * Number of input signals summed into the output signal.
+ */
+static const uint32 NumberOfInputs = 8u;
+
+/**
+ * Warm-up cycles, not measured.
+ */
+static const uint32 WarmUpCycles = 10u;
+
+/**
+ * Configuration of the application before and after the signals of the GAM.
+ */
+static const char8 * const ConfigHead = ""
+		"$Bench = {"
+		"    Class = RealTimeApplication"
+		"    +Functions = {"
+		"        Class = ReferenceContainer"
+		"        +GAMExpr = {"
+		"            Class = MathExpressionGAM";
+
+static const char8 * const ConfigTail = ""
+		"        }"
+		"    }"
+		"    +Data = {"
+		"        Class = ReferenceContainer"
+		"        DefaultDataSource = DDB1"
+		"        +DDB1 = { Class = GAMDataSource }"
+		"        +Timings = { Class = TimingDataSource }"
+		"    }"
+		"    +States = {"
+		"        Class = ReferenceContainer"
+		"        +State1 = {"
+		"            Class = RealTimeState"
+		"            +Threads = {"
+		"                Class = ReferenceContainer"
+		"                +Thread1 = { Class = RealTimeThread Functions = { GAMExpr } }"
+		"            }"
+		"        }"
+		"    }"
+		"    +Scheduler = { Class = GAMScheduler TimingDataSource = Timings }"
+		"}";
+
+static void ErrorProcessFunction(const ErrorManagement::ErrorInformation &errorInfo,
+								 const char8 * const errorDescription) {
+	printf("[%s] %s\n", errorInfo.className, errorDescription);
+}
+
+/**
+ * @brief Writes the configuration of the application for a signal type and a number of elements.
+ */
+static void BuildConfig(const char8 * const type, const uint32 size, StreamString &config) {
+
+	char8 line[256];
+	StreamString expression = "Out := In0";
+
+	config = ConfigHead;
+	config += "            InputSignals = {";
+	for (uint32 i = 0u; i < NumberOfInputs; i++) {
+		(void) snprintf(line, sizeof(line), " In%u = { DataSource = DDB1 Type = %s NumberOfDimensions = 1 NumberOfElements = %u }", i, type, size);
+		config += line;
+		if (i > 0u) {
+			(void) snprintf(line, sizeof(line), " + In%u", i);
+			expression += line;
+		}
+	}
+	expression += ";";
+	config += " }";
+	(void) snprintf(line, sizeof(line), " OutputSignals = { Out = { DataSource = DDB1 Type = %s NumberOfDimensions = 1 NumberOfElements = %u Expression = \"%s\" } }", type, size, expression.Buffer());
+	config += line;
+	config += ConfigTail;
+
+}
+
+/**
+ * @brief Configures the application for a signal type and a number of elements and times cycles calls of Execute.
+ * @return false if the application cannot be configured.
+ */
+static bool Measure(const char8 * const type, const uint32 size, const uint32 cycles, std::vector<float64> &times) {
+
+	StreamString configStream;
+	BuildConfig(type, size, configStream);
+	(void) configStream.Seek(0LLU);
+
+	ConfigurationDatabase cdb;
+	StandardParser parser(configStream, cdb);
+	bool ok = parser.Parse();
+
+	ObjectRegistryDatabase *god = ObjectRegistryDatabase::Instance();
+	if (ok) {
+		god->Purge();
+		ok = god->Initialise(cdb);
+	}
+	ReferenceT<RealTimeApplication> application;
+	if (ok) {
+		application = god->Find("Bench");
+		ok = application.IsValid();
+	}
+	if (ok) {
+		ok = application->ConfigureApplication();
+	}
+	ReferenceT<MathExpressionGAM> gam;
+	if (ok) {
+		gam = god->Find("Bench.Functions.GAMExpr");
+		ok = gam.IsValid();
+	}
+	if (ok) {
+		for (uint32 i = 0u; i < WarmUpCycles; i++) {
+			(void) gam->Execute();
+		}
+		times.resize(cycles);
+		for (uint32 i = 0u; i < cycles; i++) {
+			uint64 start = HighResolutionTimer::Counter();
+			(void) gam->Execute();
+			uint64 ticks = HighResolutionTimer::Counter() - start;
+			times[i] = static_cast<float64>(ticks) * HighResolutionTimer::Period() * 1e6;
+		}
+		std::sort(times.begin(), times.end());
+	}
+	god->Purge();
+
+	return ok;
+
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+
+	SetErrorProcessFunction(&ErrorProcessFunction);
+
+	uint32 cycles = 1000u;
+	if (argc > 1) {
+		cycles = static_cast<uint32>(strtoul(argv[1], NULL_PTR(char **), 0));
+	}
+	if (cycles == 0u) {
+		cycles = 1u;
+	}
+
+	printf("%8s %10s %12s %12s %12s\n", "Type", "Elements", "Min (us)", "Median (us)", "Max (us)");
+	bool ok = true;
+	for (uint32 t = 0u; t < NumberOfTypes; t++) {
+		for (uint32 s = 0u; s < NumberOfSizes; s++) {
+			std::vector<float64> times;
+			if (Measure(Types[t], Sizes[s], cycles, times)) {
+				printf("%8s %10u %12.2f %12.2f %12.2f\n", Types[t], Sizes[s], times[0], times[cycles / 2u], times[cycles - 1u]);
+			}
+			else {
+				printf("%8s %10u %12s\n", Types[t], Sizes[s], "failed");
+				ok = false;
+			}
+			(void) fflush(stdout);
+		}
+	}
+
+	return ok ? 0 : 1;
+
+}
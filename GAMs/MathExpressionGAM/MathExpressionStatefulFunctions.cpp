@@ -0,0 +1,597 @@
+/**
+ * @file MathExpressionStatefulFunctions.cpp
+ * @brief Source file for the stateful functions of MathExpressionGAM
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for the
+ * class MathExpressionStatefulFunctions (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+
+#include <limits>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include "MathExpressionStatefulFunctions.h"
+#include "AdvancedErrorManagement.h"
+#include "StringHelper.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * Converts a length argument (number of cycles) to an integer, at least \a minimum.
+ */
+static uint32 ToLength(const float64 n, const uint32 minimum) {
+
+	uint32 length = minimum;
+	if (n > static_cast<float64>(minimum)) {
+		length = static_cast<uint32>(n + 0.5);
+	}
+	return length;
+
+}
+
+static float64 NotANumber() {
+	return std::numeric_limits<float64>::quiet_NaN();
+}
+
+/**
+ * Names of the functions, in the order of MathExpressionStatefulFunctions::function.
+ */
+static const char8 * const FunctionName[] = { "delay", "integrate", "derivative", "movavg", "biquad" };
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+MathExpressionStatefulFunction::MathExpressionStatefulFunction() {
+
+	sizing = false;
+	numberOfSlots = 0u;
+	nextSlot = 0u;
+	slotLimit = 0u;
+	lengthOverflowReported = false;
+
+}
+
+MathExpressionStatefulFunction::~MathExpressionStatefulFunction() {
+
+}
+
+void MathExpressionStatefulFunction::BeginSizing() {
+
+	sizing = true;
+	numberOfSlots = 0u;
+	nextSlot = 0u;
+	slotLimit = 0u;
+
+}
+
+void MathExpressionStatefulFunction::EndSizing() {
+
+	sizing = false;
+	Allocate();
+	Reset();
+
+}
+
+uint32 MathExpressionStatefulFunction::GetNumberOfSlots() const {
+	return numberOfSlots;
+}
+
+void MathExpressionStatefulFunction::ReportLengthOverflow(const char8 * const name,
+														  const uint32 n,
+														  const uint32 length) {
+
+	if (!lengthOverflowReported) {
+		lengthOverflowReported = true;
+		REPORT_ERROR_STATIC(ErrorManagement::Exception,
+							"%s() called with n = %i, larger than its buffer of %i values. Set MaxHistoryLength to at least %i.",
+							name, n, length, n);
+	}
+
+}
+
+/// delay(x, n)
+
+MathExpressionDelay::MathExpressionDelay() : exprtk::ifunction<float64>(2u) {
+
+	maximumLength = 0u;
+
+}
+
+MathExpressionDelay::~MathExpressionDelay() {
+
+}
+
+float64 MathExpressionDelay::operator()(const float64 &x, const float64 &n) {
+
+	const uint32 delay = ToLength(n, 0u);
+	float64 y = (delay == 0u) ? x : 0.0;
+	uint32 slot;
+
+	if (sizing) {
+
+		length.resize(numberOfSlots + 1u);
+		length[numberOfSlots] = (delay > maximumLength) ? delay : ((maximumLength > 0u) ? maximumLength : 1u);
+		numberOfSlots++;
+
+	} else if (ClaimSlot(slot)) {
+
+		const uint32 size = length[slot];
+		float64* const ring = &buffer[offset[slot]];
+		uint32 &write = position[slot];
+
+		// Ring buffer holds the last size values, the oldest at write
+		if (delay > size) {
+			ReportLengthOverflow("delay", delay, size);
+			y = NotANumber();
+		} else if (delay > 0u) {
+			const uint32 read = (write >= delay) ? (write - delay) : (write + size - delay);
+			y = ring[read];
+		}
+		ring[write] = x;
+		write++;
+		if (write == size) {
+			write = 0u;
+		}
+
+	} else {
+
+		y = NotANumber();
+
+	}
+
+	return y;
+
+}
+
+void MathExpressionDelay::Reset() {
+
+	buffer.assign(buffer.size(), 0.0);
+	position.assign(position.size(), 0u);
+	lengthOverflowReported = false;
+
+}
+
+void MathExpressionDelay::SetMaximumLength(const uint32 maximumLengthIn) {
+
+	maximumLength = maximumLengthIn;
+
+}
+
+void MathExpressionDelay::Allocate() {
+
+	offset.resize(numberOfSlots);
+	position.resize(numberOfSlots);
+
+	uint32 total = 0u;
+	for (uint32 slot = 0u; slot < numberOfSlots; slot++) {
+		offset[slot] = total;
+		total += length[slot];
+	}
+	buffer.resize(total);
+
+}
+
+/// integrate(x, dt)
+
+MathExpressionIntegrate::MathExpressionIntegrate() : exprtk::ifunction<float64>(2u) {
+
+}
+
+MathExpressionIntegrate::~MathExpressionIntegrate() {
+
+}
+
+float64 MathExpressionIntegrate::operator()(const float64 &x, const float64 &dt) {
+
+	float64 y = x * dt;
+	uint32 slot;
+
+	if (sizing) {
+
+		numberOfSlots++;
+
+	} else if (ClaimSlot(slot)) {
+
+		integral[slot] += y;
+		y = integral[slot];
+
+	} else {
+
+		y = NotANumber();
+
+	}
+
+	return y;
+
+}
+
+void MathExpressionIntegrate::Reset() {
+
+	integral.assign(integral.size(), 0.0);
+
+}
+
+void MathExpressionIntegrate::Allocate() {
+
+	integral.resize(numberOfSlots);
+
+}
+
+/// derivative(x, dt)
+
+MathExpressionDerivative::MathExpressionDerivative() : exprtk::ifunction<float64>(2u) {
+
+}
+
+MathExpressionDerivative::~MathExpressionDerivative() {
+
+}
+
+float64 MathExpressionDerivative::operator()(const float64 &x, const float64 &dt) {
+
+	float64 y = 0.0;
+	uint32 slot;
+
+	if (sizing) {
+
+		numberOfSlots++;
+
+	} else if (ClaimSlot(slot)) {
+
+		if (primed[slot]) {
+			y = (x - previous[slot]) / dt;
+		}
+		previous[slot] = x;
+		primed[slot] = true;
+
+	} else {
+
+		y = NotANumber();
+
+	}
+
+	return y;
+
+}
+
+void MathExpressionDerivative::Reset() {
+
+	previous.assign(previous.size(), 0.0);
+	primed.assign(primed.size(), false);
+
+}
+
+void MathExpressionDerivative::Allocate() {
+
+	previous.resize(numberOfSlots);
+	primed.resize(numberOfSlots);
+
+}
+
+/// movavg(x, n)
+
+MathExpressionMovingAverage::MathExpressionMovingAverage() : exprtk::ifunction<float64>(2u) {
+
+	maximumLength = 0u;
+
+}
+
+MathExpressionMovingAverage::~MathExpressionMovingAverage() {
+
+}
+
+float64 MathExpressionMovingAverage::operator()(const float64 &x, const float64 &n) {
+
+	const uint32 requested = ToLength(n, 1u);
+	float64 y = x;
+	uint32 slot;
+
+	if (sizing) {
+
+		length.resize(numberOfSlots + 1u);
+		length[numberOfSlots] = (requested > maximumLength) ? requested : maximumLength;
+		numberOfSlots++;
+
+	} else if (ClaimSlot(slot)) {
+
+		const uint32 size = length[slot];
+		float64* const values = &buffer[offset[slot]];
+		uint32 &write = position[slot];
+
+		const bool overflow = (requested > size);
+		const uint32 w = overflow ? size : requested;
+
+		// A new n: the sum of the last w values is recomputed from the buffer
+		if (w != window[slot]) {
+			window[slot] = w;
+			const uint32 summed = (count[slot] < w) ? count[slot] : w;
+			float64 total = 0.0;
+			for (uint32 i = 1u; i <= summed; i++) {
+				total += values[(write >= i) ? (write - i) : (write + size - i)];
+			}
+			sum[slot] = total;
+			compensation[slot] = 0.0;
+		}
+
+		// The value leaving the window (none while it is not full) is replaced by x
+		float64 leaving = 0.0;
+		if (count[slot] >= w) {
+			leaving = values[(write >= w) ? (write - w) : (write + size - w)];
+		}
+		const float64 delta = x - leaving;
+		values[write] = x;
+		write++;
+		if (write == size) {
+			write = 0u;
+		}
+		if (count[slot] < size) {
+			count[slot]++;
+		}
+
+		// Kahan summation of delta
+		const float64 corrected = delta - compensation[slot];
+		const float64 updated = sum[slot] + corrected;
+		compensation[slot] = (updated - sum[slot]) - corrected;
+		sum[slot] = updated;
+
+		if (overflow) {
+			ReportLengthOverflow("movavg", requested, size);
+			y = NotANumber();
+		} else {
+			y = sum[slot] / static_cast<float64>((count[slot] < w) ? count[slot] : w);
+		}
+
+	} else {
+
+		y = NotANumber();
+
+	}
+
+	return y;
+
+}
+
+void MathExpressionMovingAverage::Reset() {
+
+	buffer.assign(buffer.size(), 0.0);
+	position.assign(position.size(), 0u);
+	count.assign(count.size(), 0u);
+	sum.assign(sum.size(), 0.0);
+	compensation.assign(compensation.size(), 0.0);
+	window.assign(window.size(), 0u);
+	lengthOverflowReported = false;
+
+}
+
+void MathExpressionMovingAverage::SetMaximumLength(const uint32 maximumLengthIn) {
+
+	maximumLength = maximumLengthIn;
+
+}
+
+void MathExpressionMovingAverage::Allocate() {
+
+	offset.resize(numberOfSlots);
+	window.resize(numberOfSlots);
+	position.resize(numberOfSlots);
+	count.resize(numberOfSlots);
+	sum.resize(numberOfSlots);
+	compensation.resize(numberOfSlots);
+
+	uint32 total = 0u;
+	for (uint32 slot = 0u; slot < numberOfSlots; slot++) {
+		offset[slot] = total;
+		total += length[slot];
+	}
+	buffer.resize(total);
+
+}
+
+/// biquad(x, coeffs)
+
+MathExpressionBiquad::MathExpressionBiquad() : exprtk::igeneric_function<float64>("TV") {
+
+}
+
+MathExpressionBiquad::~MathExpressionBiquad() {
+
+}
+
+float64 MathExpressionBiquad::operator()(parameter_list_t parameters) {
+
+	const float64 x = *static_cast<const float64*>(parameters[0].data);
+	const float64* const coeffs = parameters[1].vec_data;
+	const bool valid = (parameters[1].size >= 5u);
+
+	float64 y = valid ? (coeffs[0] * x) : NotANumber();
+	uint32 slot;
+
+	if (sizing) {
+
+		numberOfSlots++;
+
+	} else if (ClaimSlot(slot)) {
+
+		if (valid) {
+			float64* const z = &state[2u * slot];
+			y += z[0];
+			z[0] = coeffs[1] * x - coeffs[3] * y + z[1];
+			z[1] = coeffs[2] * x - coeffs[4] * y;
+		}
+
+	} else {
+
+		y = NotANumber();
+
+	}
+
+	return y;
+
+}
+
+void MathExpressionBiquad::Reset() {
+
+	state.assign(state.size(), 0.0);
+
+}
+
+void MathExpressionBiquad::Allocate() {
+
+	state.resize(2u * numberOfSlots);
+
+}
+
+/// The functions of one GAM
+
+const uint32 MathExpressionStatefulFunctions::NumberOfFunctions;
+
+MathExpressionStatefulFunctions::MathExpressionStatefulFunctions() {
+
+	function[0] = &delayFunction;
+	function[1] = &integrateFunction;
+	function[2] = &derivativeFunction;
+	function[3] = &movingAverageFunction;
+	function[4] = &biquadFunction;
+
+}
+
+MathExpressionStatefulFunctions::~MathExpressionStatefulFunctions() {
+
+}
+
+bool MathExpressionStatefulFunctions::Register(exprtk::symbol_table<float64> &symbolTable) {
+
+	bool ok = symbolTable.add_function(FunctionName[0], delayFunction);
+	if (ok) {
+		ok = symbolTable.add_function(FunctionName[1], integrateFunction);
+	}
+	if (ok) {
+		ok = symbolTable.add_function(FunctionName[2], derivativeFunction);
+	}
+	if (ok) {
+		ok = symbolTable.add_function(FunctionName[3], movingAverageFunction);
+	}
+	if (ok) {
+		ok = symbolTable.add_function(FunctionName[4], biquadFunction);
+	}
+
+	return ok;
+
+}
+
+void MathExpressionStatefulFunctions::BeginSizing(const uint32 numberOfExpressions) {
+
+	firstSlot.assign(numberOfExpressions * NumberOfFunctions, 0u);
+	slotLimit.assign(numberOfExpressions * NumberOfFunctions, 0u);
+
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		function[i]->BeginSizing();
+	}
+
+}
+
+void MathExpressionStatefulFunctions::BeginExpressionSizing(const uint32 expressionIdx) {
+
+	const uint32 base = expressionIdx * NumberOfFunctions;
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		firstSlot[base + i] = function[i]->GetNumberOfSlots();
+	}
+
+}
+
+void MathExpressionStatefulFunctions::EndExpressionSizing(const uint32 expressionIdx) {
+
+	const uint32 base = expressionIdx * NumberOfFunctions;
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		slotLimit[base + i] = function[i]->GetNumberOfSlots();
+	}
+
+}
+
+void MathExpressionStatefulFunctions::EndSizing() {
+
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		function[i]->EndSizing();
+	}
+
+}
+
+void MathExpressionStatefulFunctions::Reset() {
+
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		function[i]->Reset();
+	}
+
+}
+
+void MathExpressionStatefulFunctions::SetMaximumLength(const uint32 maximumLength) {
+
+	delayFunction.SetMaximumLength(maximumLength);
+	movingAverageFunction.SetMaximumLength(maximumLength);
+
+}
+
+uint32 MathExpressionStatefulFunctions::GetNumberOfSlots() const {
+
+	uint32 total = 0u;
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		total += function[i]->GetNumberOfSlots();
+	}
+	return total;
+
+}
+
+bool MathExpressionStatefulFunctions::HasSlotsFor(const uint32 expressionIdx,
+												  const MathExpressionStatefulFunctions &counted,
+												  const uint32 countedIdx) const {
+
+	bool ok = true;
+	const uint32 base = expressionIdx * NumberOfFunctions;
+	const uint32 countedBase = countedIdx * NumberOfFunctions;
+	for (uint32 i = 0u; (i < NumberOfFunctions) && ok; i++) {
+		const uint32 calls = counted.slotLimit[countedBase + i] - counted.firstSlot[countedBase + i];
+		ok = (calls <= (slotLimit[base + i] - firstSlot[base + i]));
+	}
+	return ok;
+
+}
+
+bool MathExpressionStatefulFunctions::IsFunctionName(const char8 * const name) {
+
+	bool found = false;
+	for (uint32 i = 0u; (i < NumberOfFunctions) && !found; i++) {
+		found = (StringHelper::Compare(name, FunctionName[i]) == 0);
+	}
+	return found;
+
+}
+
+}
@@ -0,0 +1,386 @@
+/**
+ * @file MathExpressionStatefulFunctions.h
+ * @brief Header file for the stateful functions of MathExpressionGAM
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class MathExpressionStatefulFunctions
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef MATHEXPRESSIONSTATEFULFUNCTIONS_H_
+#define MATHEXPRESSIONSTATEFULFUNCTIONS_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include <vector>
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+
+#include "CompilerTypes.h"
+#include "exprtk.hpp"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * @brief Base of the functions whose result depends on the previous cycles.
+ * @details Each call of a stateful function during a cycle owns one state
+ * slot: each expression has a range of slots, and its k-th call in a cycle
+ * always uses the k-th slot of the range. The functions must therefore be
+ * called the same number of times and in the same order in every cycle
+ * (e.g. not in a branch of a data dependent if, but loops with a constant
+ * number of iterations are fine, each iteration gets its own state).
+ *
+ * The slots are counted and preallocated by evaluating the expressions once
+ * in Setup() (sizing). During sizing the functions return the value of the
+ * first cycle after a reset. Calls beyond the range of the expression return
+ * NaN.
+ */
+class MathExpressionStatefulFunction {
+public:
+
+	/**
+	 * @brief Constructor. NOOP.
+	 */
+	MathExpressionStatefulFunction();
+
+	/**
+	 * @brief Destructor. NOOP.
+	 */
+	virtual ~MathExpressionStatefulFunction();
+
+	/**
+	 * @brief Discards the slots and starts counting them.
+	 */
+	void BeginSizing();
+
+	/**
+	 * @brief Stops counting, allocates the state of the counted slots and resets it.
+	 */
+	void EndSizing();
+
+	/**
+	 * @brief Resets the state of all the slots.
+	 */
+	virtual void Reset() = 0;
+
+	/**
+	 * @brief Selects the range of slots of the expression about to be evaluated.
+	 * @param[in] first the first slot of the range.
+	 * @param[in] limit one past the last slot of the range.
+	 */
+	inline void SelectSlots(const uint32 first,
+							const uint32 limit);
+
+	/**
+	 * @return the number of preallocated slots.
+	 */
+	uint32 GetNumberOfSlots() const;
+
+protected:
+
+	/**
+	 * @brief Allocates the state of the counted slots.
+	 */
+	virtual void Allocate() = 0;
+
+	/**
+	 * @brief Claims the slot of the current call.
+	 * @param[out] slot the claimed slot.
+	 * @return false if all the slots of the range were claimed.
+	 */
+	inline bool ClaimSlot(uint32 &slot);
+
+	/**
+	 * True while the slots are counted.
+	 */
+	bool sizing;
+
+	/**
+	 * Number of slots.
+	 */
+	uint32 numberOfSlots;
+
+	/**
+	 * Next slot to be claimed in the selected range.
+	 */
+	uint32 nextSlot;
+
+	/**
+	 * One past the last slot of the selected range.
+	 */
+	uint32 slotLimit;
+
+	/**
+	 * @brief Reports, once until the next reset, a length argument larger than the buffer of its slot.
+	 */
+	void ReportLengthOverflow(const char8 * const name,
+							  const uint32 n,
+							  const uint32 length);
+
+	/**
+	 * True once a length overflow was reported.
+	 */
+	bool lengthOverflowReported;
+};
+
+/**
+ * @brief delay(x, n): value of x n calls (i.e. cycles) before, 0 before that.
+ * @details Each slot has a ring buffer as long as the n seen in sizing, or
+ * as the maximum length if larger. A larger n returns NaN and is reported.
+ */
+class MathExpressionDelay : public exprtk::ifunction<float64>, public MathExpressionStatefulFunction {
+public:
+	MathExpressionDelay();
+	virtual ~MathExpressionDelay();
+	virtual float64 operator()(const float64 &x, const float64 &n);
+	virtual void Reset();
+	void SetMaximumLength(const uint32 maximumLengthIn);
+protected:
+	virtual void Allocate();
+private:
+	uint32               maximumLength;	//!< Minimum ring buffer length, for n that are not constant.
+	std::vector<uint32>  length;	//!< Ring buffer length of each slot.
+	std::vector<uint32>  offset;	//!< Start of the ring buffer of each slot.
+	std::vector<uint32>  position;	//!< Next position to be written in each ring buffer.
+	std::vector<float64> buffer;	//!< Ring buffers of all the slots.
+};
+
+/**
+ * @brief integrate(x, dt): running sum of x * dt (rectangle rule, current sample included).
+ */
+class MathExpressionIntegrate : public exprtk::ifunction<float64>, public MathExpressionStatefulFunction {
+public:
+	MathExpressionIntegrate();
+	virtual ~MathExpressionIntegrate();
+	virtual float64 operator()(const float64 &x, const float64 &dt);
+	virtual void Reset();
+protected:
+	virtual void Allocate();
+private:
+	std::vector<float64> integral;	//!< Integral of each slot.
+};
+
+/**
+ * @brief derivative(x, dt): (x - previous x) / dt, 0 in the first cycle after a reset.
+ */
+class MathExpressionDerivative : public exprtk::ifunction<float64>, public MathExpressionStatefulFunction {
+public:
+	MathExpressionDerivative();
+	virtual ~MathExpressionDerivative();
+	virtual float64 operator()(const float64 &x, const float64 &dt);
+	virtual void Reset();
+protected:
+	virtual void Allocate();
+private:
+	std::vector<float64> previous;	//!< Previous x of each slot.
+	std::vector<bool>    primed;	//!< True once the slot has a previous x.
+};
+
+/**
+ * @brief movavg(x, n): average of the last n values of x (of the values seen
+ * so far after a reset).
+ * @details Each slot keeps the last values of x in a buffer as long as the n
+ * seen in sizing, or as the maximum length if larger. A larger n returns NaN
+ * and is reported. The sum of the window is updated in O(1) with compensated
+ * (Kahan) summation, so that rounding errors do not accumulate over long
+ * runs, and recomputed from the buffer when n changes.
+ */
+class MathExpressionMovingAverage : public exprtk::ifunction<float64>, public MathExpressionStatefulFunction {
+public:
+	MathExpressionMovingAverage();
+	virtual ~MathExpressionMovingAverage();
+	virtual float64 operator()(const float64 &x, const float64 &n);
+	virtual void Reset();
+	void SetMaximumLength(const uint32 maximumLengthIn);
+protected:
+	virtual void Allocate();
+private:
+	uint32               maximumLength;	//!< Minimum buffer length, for n that are not constant.
+	std::vector<uint32>  length;		//!< Buffer length of each slot.
+	std::vector<uint32>  window;		//!< Window length (n) of the last call of each slot.
+	std::vector<uint32>  offset;		//!< Start of the buffer of each slot.
+	std::vector<uint32>  position;		//!< Next position to be written in each buffer.
+	std::vector<uint32>  count;			//!< Number of values in each buffer.
+	std::vector<float64> sum;			//!< Sum of each window.
+	std::vector<float64> compensation;	//!< Rounding error of each sum.
+	std::vector<float64> buffer;		//!< Buffers of all the slots.
+};
+
+/**
+ * @brief biquad(x, coeffs): second order IIR section, coeffs = [b0, b1, b2, a1, a2]
+ * (a0 = 1), in direct form II transposed.
+ * @details Returns NaN if coeffs has less than 5 elements.
+ */
+class MathExpressionBiquad : public exprtk::igeneric_function<float64>, public MathExpressionStatefulFunction {
+public:
+	MathExpressionBiquad();
+	virtual ~MathExpressionBiquad();
+	virtual float64 operator()(parameter_list_t parameters);
+	virtual void Reset();
+protected:
+	virtual void Allocate();
+private:
+	std::vector<float64> state;	//!< The two delay elements of each slot.
+};
+
+/**
+ * @brief The stateful functions of one MathExpressionGAM.
+ * @details Registers delay, integrate, derivative, movavg and biquad in
+ * a symbol table and keeps the range of slots of each expression.
+ */
+class MathExpressionStatefulFunctions {
+public:
+
+	/**
+	 * @brief Constructor. NOOP.
+	 */
+	MathExpressionStatefulFunctions();
+
+	/**
+	 * @brief Destructor. NOOP.
+	 */
+	~MathExpressionStatefulFunctions();
+
+	/**
+	 * @brief Adds the functions to \a symbolTable.
+	 * @return false if a name is already used in the symbol table.
+	 */
+	bool Register(exprtk::symbol_table<float64> &symbolTable);
+
+	/**
+	 * @brief See MathExpressionStatefulFunction::BeginSizing().
+	 * @param[in] numberOfExpressions the number of expressions that own slots.
+	 */
+	void BeginSizing(const uint32 numberOfExpressions);
+
+	/**
+	 * @brief Starts counting the slots of an expression, before it is evaluated.
+	 */
+	void BeginExpressionSizing(const uint32 expressionIdx);
+
+	/**
+	 * @brief Stops counting the slots of an expression, after it is evaluated.
+	 */
+	void EndExpressionSizing(const uint32 expressionIdx);
+
+	/**
+	 * @brief See MathExpressionStatefulFunction::EndSizing().
+	 */
+	void EndSizing();
+
+	/**
+	 * @brief Resets the state of all the functions.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Sets the largest n accepted by delay() and movavg() when it is
+	 * larger than the n they see in sizing. Called before BeginSizing().
+	 */
+	void SetMaximumLength(const uint32 maximumLength);
+
+	/**
+	 * @brief Selects the slots of an expression. Called before each evaluation.
+	 */
+	inline void Select(const uint32 expressionIdx);
+
+	/**
+	 * @return the total number of preallocated slots.
+	 */
+	uint32 GetNumberOfSlots() const;
+
+	/**
+	 * @brief Checks that the calls of an expression, counted by another
+	 * instance, fit the slots of an expression of this one.
+	 * @param[in] expressionIdx the expression whose slots are used.
+	 * @param[in] counted the instance that counted the calls.
+	 * @param[in] countedIdx the expression whose calls were counted by \a counted.
+	 * @return true if each function is called at most as many times as it has slots.
+	 */
+	bool HasSlotsFor(const uint32 expressionIdx,
+					 const MathExpressionStatefulFunctions &counted,
+					 const uint32 countedIdx) const;
+
+	/**
+	 * @return true if \a name is the name of one of the functions.
+	 */
+	static bool IsFunctionName(const char8 * const name);
+
+private:
+
+	/**
+	 * Number of functions.
+	 */
+	static const uint32 NumberOfFunctions = 5u;
+
+	MathExpressionDelay         delayFunction;
+	MathExpressionIntegrate     integrateFunction;
+	MathExpressionDerivative    derivativeFunction;
+	MathExpressionMovingAverage movingAverageFunction;
+	MathExpressionBiquad        biquadFunction;
+
+	/**
+	 * The functions above, to drive their slots.
+	 */
+	MathExpressionStatefulFunction* function[NumberOfFunctions];
+
+	/**
+	 * Range of slots of each expression in each function
+	 * (index expressionIdx * NumberOfFunctions + function).
+	 */
+	std::vector<uint32> firstSlot;
+	std::vector<uint32> slotLimit;
+};
+
+} /* Namespace MARTe */
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+void MathExpressionStatefulFunction::SelectSlots(const uint32 first,
+												 const uint32 limit) {
+	nextSlot = first;
+	slotLimit = limit;
+}
+
+bool MathExpressionStatefulFunction::ClaimSlot(uint32 &slot) {
+	slot = nextSlot;
+	nextSlot++;
+	return (slot < slotLimit);
+}
+
+void MathExpressionStatefulFunctions::Select(const uint32 expressionIdx) {
+	const uint32 base = expressionIdx * NumberOfFunctions;
+	for (uint32 i = 0u; i < NumberOfFunctions; i++) {
+		function[i]->SelectSlots(firstSlot[base + i], slotLimit[base + i]);
+	}
+}
+
+} /* Namespace MARTe */
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file MathExpressionThreadPool.cpp
+ * @brief Source file for class MathExpressionThreadPool
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for the
+ * class MathExpressionThreadPool (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include "MathExpressionThreadPool.h"
+#include "AdvancedErrorManagement.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+MathExpressionThreadPool::MathExpressionThreadPool() : HelperThreadPool() {
+
+	jobs = NULL_PTR(const MathExpressionJob*);
+
+}
+
+MathExpressionThreadPool::~MathExpressionThreadPool() {
+
+	Stop();
+
+}
+
+bool MathExpressionThreadPool::Start(const uint32 numberOfHelpersIn,
+									 const uint32 cpuMask,
+									 const uint32 stackSize) {
+
+	// Helper i is pinned to the i-th CPU of the mask (wrapping around)
+	return HelperThreadPool::Start(numberOfHelpersIn, cpuMask, stackSize, "MathExpressionThreadPool", true);
+
+}
+
+void MathExpressionThreadPool::Run(const MathExpressionJob * const jobsIn,
+								   const uint32 numberOfJobsIn) {
+
+	// Published to the helpers by HelperThreadPool::Run(), which takes the job lock
+	jobs = jobsIn;
+	HelperThreadPool::Run(numberOfJobsIn);
+
+}
+
+void MathExpressionThreadPool::ProcessJob(const uint32 jobIdx,
+										  const uint32 threadIdx) {
+
+	RunJob(jobs[jobIdx], threadIdx);
+
+}
+
+}
@@ -0,0 +1,140 @@
+/**
+ * @file MathExpressionThreadPool.h
+ * @brief Header file for class MathExpressionThreadPool
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class MathExpressionThreadPool
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef MATHEXPRESSIONTHREADPOOL_H_
+#define MATHEXPRESSIONTHREADPOOL_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+
+#include "HelperThreadPool.h"
+
+#include "exprtk.hpp"
+#include "MathExpressionVectorProgram.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * @brief A unit of work of MathExpressionThreadPool: a range of elements of a
+ * vector program, or a whole exprtk expression.
+ */
+struct MathExpressionJob {
+	MathExpressionVectorProgram* program;		//!< Program to evaluate (NULL for an exprtk expression).
+	uint32                       begin;			//!< First element of the range.
+	uint32                       end;			//!< One past the last element of the range.
+	float64*                     registerBanks;	//!< One bank of registers for each thread.
+	uint32                       bankSize;		//!< Number of elements of each bank.
+	exprtk::expression<float64>* expression;	//!< Expression evaluated by exprtk.
+	uint32                       expressionIdx;	//!< Index of the expression evaluated by exprtk.
+};
+
+/**
+ * @brief Helper threads evaluating independent jobs of a MathExpressionGAM.
+ * @details The helpers are pinned each to one CPU of the configured mask.
+ * Run() hands them a list of independent jobs, takes part in the work
+ * itself (as thread 0) and returns when all the jobs are done, so that it
+ * acts as a barrier (see HelperThreadPool).
+ */
+class MathExpressionThreadPool : public HelperThreadPool {
+public:
+
+	/**
+	 * @brief Constructor. NOOP.
+	 */
+	MathExpressionThreadPool();
+
+	/**
+	 * @brief Stops the helpers.
+	 */
+	virtual ~MathExpressionThreadPool();
+
+	/**
+	 * @brief Starts the helpers.
+	 * @param[in] numberOfHelpersIn number of helper threads.
+	 * @param[in] cpuMask the CPUs of the helpers, the i-th helper being pinned to the i-th CPU of the mask.
+	 * @param[in] stackSize stack size of the helper threads.
+	 * @return true if the helpers are running.
+	 */
+	bool Start(const uint32 numberOfHelpersIn,
+			   const uint32 cpuMask,
+			   const uint32 stackSize);
+
+	/**
+	 * @brief Evaluates the jobs with the helpers and returns when all of them are done.
+	 */
+	void Run(const MathExpressionJob * const jobsIn,
+			 const uint32 numberOfJobsIn);
+
+	/**
+	 * @brief Evaluates a job.
+	 * @param[in] job the job.
+	 * @param[in] threadIdx the thread evaluating it (0 for the caller of Run()), which selects the register bank.
+	 */
+	static inline void RunJob(const MathExpressionJob &job,
+							  const uint32 threadIdx);
+
+protected:
+
+	/**
+	 * @brief Evaluates the jobIdx-th job of the current run.
+	 */
+	virtual void ProcessJob(const uint32 jobIdx,
+							const uint32 threadIdx);
+
+private:
+
+	/**
+	 * The current jobs.
+	 */
+	const MathExpressionJob* jobs;
+};
+
+} /* Namespace MARTe */
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+void MathExpressionThreadPool::RunJob(const MathExpressionJob &job,
+									  const uint32 threadIdx) {
+	if (job.program != NULL_PTR(MathExpressionVectorProgram*)) {
+		job.program->ExecuteRange(job.begin, job.end, job.registerBanks + (threadIdx * job.bankSize));
+	} else {
+		(void) job.expression->value();
+	}
+}
+
+} /* Namespace MARTe */
+
+#endif
@@ -0,0 +1,1073 @@
+/**
+ * @file MathExpressionVectorProgram.cpp
+ * @brief Source file for class MathExpressionVectorProgram
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This source file contains the definition of all the methods for the
+ * class MathExpressionVectorProgram (public, protected, and private). Be aware that some
+ * methods, such as those inline could be defined on the header file, instead.
+ */
+
+#define DLL_API
+
+/*---------------------------------------------------------------------------*/
+/*                         Standard header includes                          */
+/*---------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+/*                         Project header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include "MathExpressionVectorProgram.h"
+#include "StringHelper.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Static definitions                              */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * Functions that can be used in the expressions.
+ * abs is implemented as in exprtk, so that both backends give the same results.
+ */
+static float64 VectorSqrt(float64 x) {
+	return sqrt(x);
+}
+
+static float64 VectorAbs(float64 x) {
+	return (x < 0.0) ? -x : x;
+}
+
+static float64 VectorExp(float64 x) {
+	return exp(x);
+}
+
+static float64 VectorLog(float64 x) {
+	return log(x);
+}
+
+static float64 VectorSin(float64 x) {
+	return sin(x);
+}
+
+static float64 VectorCos(float64 x) {
+	return cos(x);
+}
+
+static float64 VectorTan(float64 x) {
+	return tan(x);
+}
+
+static float64 VectorTanh(float64 x) {
+	return tanh(x);
+}
+
+struct VectorFunctionName {
+	const char8* name;
+	float64 (*function)(float64);
+};
+
+static const VectorFunctionName vectorFunctions[] = {
+	{ "sqrt", &VectorSqrt },
+	{ "abs",  &VectorAbs },
+	{ "exp",  &VectorExp },
+	{ "log",  &VectorLog },
+	{ "sin",  &VectorSin },
+	{ "cos",  &VectorCos },
+	{ "tan",  &VectorTan },
+	{ "tanh", &VectorTanh },
+	{ NULL_PTR(const char8*), NULL_PTR(float64 (*)(float64)) }
+};
+
+/**
+ * Element-wise operations of the instructions.
+ */
+struct VectorCopy {
+	static inline float64 Apply(const float64 a, const float64, const float64) {
+		return a;
+	}
+};
+
+struct VectorNegate {
+	static inline float64 Apply(const float64 a, const float64, const float64) {
+		return -a;
+	}
+};
+
+struct VectorAdd {
+	static inline float64 Apply(const float64 a, const float64 b, const float64) {
+		return a + b;
+	}
+};
+
+struct VectorSubtract {
+	static inline float64 Apply(const float64 a, const float64 b, const float64) {
+		return a - b;
+	}
+};
+
+struct VectorMultiply {
+	static inline float64 Apply(const float64 a, const float64 b, const float64) {
+		return a * b;
+	}
+};
+
+struct VectorDivide {
+	static inline float64 Apply(const float64 a, const float64 b, const float64) {
+		return a / b;
+	}
+};
+
+struct VectorMultiplyAdd {
+	static inline float64 Apply(const float64 a, const float64 b, const float64 c) {
+		return (a * b) + c;
+	}
+};
+
+struct VectorMultiplySubtract {
+	static inline float64 Apply(const float64 a, const float64 b, const float64 c) {
+		return (a * b) - c;
+	}
+};
+
+/**
+ * Applies an operation to n elements. SA, SB and SC are the strides of the
+ * operands: 1 for vectors, 0 for scalars.
+ * The elements are processed in blocks of 4, all the operands of a block being loaded
+ * before the results are stored: the block is vectorised by the compiler without alias
+ * checks, and the destination can be one of the sources.
+ */
+template<class Operation, uint32 SA, uint32 SB, uint32 SC>
+static void VectorKernel(float64 * const d,
+						 const float64 * const a,
+						 const float64 * const b,
+						 const float64 * const c,
+						 const uint32 n,
+						 float64 (* const)(float64)) {
+
+	uint32 j = 0u;
+	for (; (j + 4u) <= n; j += 4u) {
+
+		const float64 a0 = a[j * SA];
+		const float64 a1 = a[(j + 1u) * SA];
+		const float64 a2 = a[(j + 2u) * SA];
+		const float64 a3 = a[(j + 3u) * SA];
+		const float64 b0 = b[j * SB];
+		const float64 b1 = b[(j + 1u) * SB];
+		const float64 b2 = b[(j + 2u) * SB];
+		const float64 b3 = b[(j + 3u) * SB];
+		const float64 c0 = c[j * SC];
+		const float64 c1 = c[(j + 1u) * SC];
+		const float64 c2 = c[(j + 2u) * SC];
+		const float64 c3 = c[(j + 3u) * SC];
+		d[j] = Operation::Apply(a0, b0, c0);
+		d[j + 1u] = Operation::Apply(a1, b1, c1);
+		d[j + 2u] = Operation::Apply(a2, b2, c2);
+		d[j + 3u] = Operation::Apply(a3, b3, c3);
+
+	}
+	for (; j < n; j++) {
+
+		d[j] = Operation::Apply(a[j * SA], b[j * SB], c[j * SC]);
+
+	}
+
+}
+
+/**
+ * Applies a function to n elements (not vectorised, as the function is called through a pointer).
+ */
+template<uint32 SA>
+static void VectorFunctionKernel(float64 * const d,
+								 const float64 * const a,
+								 const float64 * const,
+								 const float64 * const,
+								 const uint32 n,
+								 float64 (* const function)(float64)) {
+
+	for (uint32 j = 0u; j < n; j++) {
+
+		d[j] = function(a[j * SA]);
+
+	}
+
+}
+
+typedef void (*VectorKernelFunction)(float64 * const d,
+									 const float64 * const a,
+									 const float64 * const b,
+									 const float64 * const c,
+									 const uint32 n,
+									 float64 (* const function)(float64));
+
+/**
+ * Selects the kernel of an operation for the given operand kinds.
+ */
+template<class Operation>
+static VectorKernelFunction SelectVectorKernel(const bool scalarA, const bool scalarB, const bool scalarC) {
+
+	static const VectorKernelFunction kernels[8] = {
+		&VectorKernel<Operation, 1u, 1u, 1u>,
+		&VectorKernel<Operation, 1u, 1u, 0u>,
+		&VectorKernel<Operation, 1u, 0u, 1u>,
+		&VectorKernel<Operation, 1u, 0u, 0u>,
+		&VectorKernel<Operation, 0u, 1u, 1u>,
+		&VectorKernel<Operation, 0u, 1u, 0u>,
+		&VectorKernel<Operation, 0u, 0u, 1u>,
+		&VectorKernel<Operation, 0u, 0u, 0u>
+	};
+
+	return kernels[(scalarA ? 4u : 0u) + (scalarB ? 2u : 0u) + (scalarC ? 1u : 0u)];
+
+}
+
+static bool IsIdentifierStart(const char8 c) {
+	return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_');
+}
+
+static bool IsDigit(const char8 c) {
+	return (c >= '0') && (c <= '9');
+}
+
+/*---------------------------------------------------------------------------*/
+/*                           Method definitions                              */
+/*---------------------------------------------------------------------------*/
+
+const uint32 MathExpressionVectorProgram::ChunkSize;
+
+MathExpressionVectorProgram::MathExpressionVectorProgram() {
+
+	variableNames = NULL_PTR(const StreamString*);
+	variableMemory = NULL_PTR(float64* const*);
+	variableSizes = NULL_PTR(const uint32*);
+	numVariables = 0u;
+	cursor = NULL_PTR(const char8*);
+	outputVariable = 0u;
+	statementElements = 0u;
+	numberOfElements = 0u;
+	numberOfSharedSubexpressions = 0u;
+	numberOfRegisters = 0u;
+
+}
+
+MathExpressionVectorProgram::~MathExpressionVectorProgram() {
+
+}
+
+void MathExpressionVectorProgram::SetVariables(const StreamString * const names,
+											   float64 * const * const memory,
+											   const uint32 * const sizes,
+											   const uint32 numberOfVariables) {
+
+	variableNames = names;
+	variableMemory = memory;
+	variableSizes = sizes;
+	numVariables = numberOfVariables;
+	variableVersion.assign(numberOfVariables, 0u);
+	variableReadAsScalar.assign(numberOfVariables, false);
+
+}
+
+bool MathExpressionVectorProgram::AddStatement(const char8 * const expression,
+											   const uint32 outputIdx) {
+
+	const uint32 firstNewNode = static_cast<uint32>(nodes.size());
+
+	cursor = expression;
+	outputVariable = outputIdx;
+	statementElements = variableSizes[outputIdx];
+	statementScalarReads.clear();
+
+	/// 1. The expression must be "<output> := <element-wise expression>;"
+	StreamString target;
+	SkipSpaces();
+	bool ok = ParseIdentifier(target);
+	if (ok) {
+		ok = (StringHelper::Compare(target.Buffer(), variableNames[outputIdx].Buffer()) == 0);
+	}
+	if (ok) {
+		SkipSpaces();
+		ok = ((cursor[0] == ':') && (cursor[1] == '='));
+	}
+	int32 root = -1;
+	if (ok) {
+		cursor += 2;
+		ok = ParseSum(root);
+	}
+	if (ok) {
+		SkipSpaces();
+		if (*cursor == ';') {
+			cursor++;
+			SkipSpaces();
+		}
+		ok = (*cursor == '\0');
+	}
+
+	/// 2. All the statements of the program run over the same elements, chunk by chunk:
+	///    element reads must not see values written by the program in later chunks.
+	if (ok && (statementRoot.size() > 0u)) {
+		ok = (statementElements == numberOfElements);
+	}
+	for (uint32 i = 0u; ok && (i < statementScalarReads.size()); i++) {
+		ok = (variableVersion[statementScalarReads[i]] == 0u);
+	}
+	if (ok) {
+		ok = (!variableReadAsScalar[outputIdx]) && (variableVersion[outputIdx] == 0u);
+	}
+
+	if (ok) {
+
+		numberOfElements = statementElements;
+		statementRoot.push_back(root);
+		statementOutput.push_back(outputIdx);
+		variableVersion[outputIdx]++;
+		for (uint32 i = 0u; i < statementScalarReads.size(); i++) {
+			variableReadAsScalar[statementScalarReads[i]] = true;
+		}
+
+	} else {
+
+		nodes.resize(firstNewNode);
+
+	}
+
+	cursor = NULL_PTR(const char8*);
+
+	return ok;
+
+}
+
+void MathExpressionVectorProgram::Compile() {
+
+	program.clear();
+	constants.clear();
+	registers.clear();
+	freeRegisters.clear();
+	numberOfRegisters = 0u;
+	numberOfSharedSubexpressions = 0u;
+
+	/// 1. Uses of each node, to keep its register until the last one.
+	nodeUses.assign(nodes.size(), 0u);
+	nodeEmitted.assign(nodes.size(), false);
+	nodeOperand.assign(nodes.size(), NoOperand());
+
+	for (uint32 i = 0u; i < nodes.size(); i++) {
+
+		for (uint32 j = 0u; (j < 3u) && (nodes[i].child[j] >= 0); j++) {
+			nodeUses[static_cast<uint32>(nodes[i].child[j])]++;
+		}
+
+	}
+	for (uint32 i = 0u; i < statementRoot.size(); i++) {
+
+		nodeUses[static_cast<uint32>(statementRoot[i])]++;
+
+	}
+	for (uint32 i = 0u; i < nodes.size(); i++) {
+
+		if ((!nodes[i].leaf) && (nodeUses[i] > 1u)) {
+			numberOfSharedSubexpressions++;
+		}
+
+	}
+
+	/// 2. Each statement is lowered to register instructions, the last one writing
+	///    to the output memory.
+	for (uint32 i = 0u; i < statementRoot.size(); i++) {
+
+		Operand output = NoOperand();
+		output.base = variableMemory[statementOutput[i]];
+		output.advance = 1u;
+		(void) Emit(statementRoot[i], output);
+		Consume(statementRoot[i]);
+
+	}
+
+	/// 3. Registers and constants are allocated and their addresses resolved.
+	registers.resize(numberOfRegisters * ChunkSize);
+
+	for (uint32 i = 0u; i < program.size(); i++) {
+
+		Resolve(program[i].destination);
+		for (uint32 j = 0u; j < 3u; j++) {
+			Resolve(program[i].source[j]);
+		}
+
+	}
+
+	nodeUses.clear();
+	nodeEmitted.clear();
+	nodeOperand.clear();
+
+}
+
+uint32 MathExpressionVectorProgram::GetNumberOfStatements() const {
+
+	return static_cast<uint32>(statementRoot.size());
+
+}
+
+uint32 MathExpressionVectorProgram::GetNumberOfSharedSubexpressions() const {
+
+	return numberOfSharedSubexpressions;
+	
+}
+
+uint32 MathExpressionVectorProgram::GetNumberOfInstructions() const {
+	
+	return static_cast<uint32>(program.size());
+	
+}
+
+void MathExpressionVectorProgram::Execute() {
+
+	const uint32 numberOfInstructions = static_cast<uint32>(program.size());
+
+	for (uint32 offset = 0u; offset < numberOfElements; offset += ChunkSize) {
+
+		const uint32 n = ((numberOfElements - offset) < ChunkSize) ? (numberOfElements - offset) : ChunkSize;
+
+		for (uint32 i = 0u; i < numberOfInstructions; i++) {
+
+			const Instruction &instruction = program[i];
+			instruction.kernel(instruction.destination.base + (offset * instruction.destination.advance),
+							   instruction.source[0].base + (offset * instruction.source[0].advance),
+							   instruction.source[1].base + (offset * instruction.source[1].advance),
+							   instruction.source[2].base + (offset * instruction.source[2].advance),
+							   n,
+							   instruction.function);
+
+		}
+
+	}
+
+}
+
+void MathExpressionVectorProgram::ExecuteRange(const uint32 begin,
+											   const uint32 end,
+											   float64 * const bank) const {
+
+	const uint32 numberOfInstructions = static_cast<uint32>(program.size());
+
+	for (uint32 offset = begin; offset < end; offset += ChunkSize) {
+
+		const uint32 n = ((end - offset) < ChunkSize) ? (end - offset) : ChunkSize;
+
+		for (uint32 i = 0u; i < numberOfInstructions; i++) {
+
+			const Instruction &instruction = program[i];
+			instruction.kernel(Address(instruction.destination, offset, bank),
+							   Address(instruction.source[0], offset, bank),
+							   Address(instruction.source[1], offset, bank),
+							   Address(instruction.source[2], offset, bank),
+							   n,
+							   instruction.function);
+
+		}
+
+	}
+
+}
+
+uint32 MathExpressionVectorProgram::GetNumberOfElements() const {
+	return numberOfElements;
+}
+
+uint32 MathExpressionVectorProgram::GetRegisterBankSize() const {
+	return numberOfRegisters * ChunkSize;
+}
+
+bool MathExpressionVectorProgram::ParseSum(int32 &node) {
+
+	bool ok = ParseProduct(node);
+	bool done = false;
+
+	while (ok && !done) {
+
+		SkipSpaces();
+		if ((*cursor == '+') || (*cursor == '-')) {
+
+			const OpCode op = (*cursor == '+') ? OpAdd : OpSubtract;
+			cursor++;
+			int32 right;
+			ok = ParseProduct(right);
+			if (ok) {
+				node = AddNode(op, node, right, -1);
+			}
+
+		} else {
+			done = true;
+		}
+
+	}
+
+	return ok;
+
+}
+
+bool MathExpressionVectorProgram::ParseProduct(int32 &node) {
+
+	bool ok = ParseUnary(node);
+	bool done = false;
+
+	while (ok && !done) {
+
+		SkipSpaces();
+		if ((*cursor == '*') || (*cursor == '/')) {
+
+			const OpCode op = (*cursor == '*') ? OpMultiply : OpDivide;
+			cursor++;
+			int32 right;
+			ok = ParseUnary(right);
+			if (ok) {
+				node = AddNode(op, node, right, -1);
+			}
+
+		} else {
+			done = true;
+		}
+
+	}
+
+	return ok;
+
+}
+
+bool MathExpressionVectorProgram::ParseUnary(int32 &node) {
+
+	bool ok;
+
+	SkipSpaces();
+	if (*cursor == '-') {
+
+		cursor++;
+		int32 operand;
+		ok = ParseUnary(operand);
+		if (ok) {
+			const Node negated = nodes[static_cast<uint32>(operand)];
+			if (negated.leaf && (negated.variable < 0)) {
+				// Negative constant (nodes are shared, so a new one is added)
+				Node constant = negated;
+				constant.value = -negated.value;
+				node = AddLeaf(constant);
+			} else {
+				node = AddNode(OpNegate, operand, -1, -1);
+			}
+		}
+
+	} else if (*cursor == '+') {
+
+		cursor++;
+		ok = ParseUnary(node);
+
+	} else {
+
+		ok = ParsePrimary(node);
+
+	}
+
+	return ok;
+
+}
+
+bool MathExpressionVectorProgram::ParsePrimary(int32 &node) {
+
+	bool ok = true;
+
+	SkipSpaces();
+	if (*cursor == '(') {
+
+		cursor++;
+		ok = ParseSum(node);
+		if (ok) {
+			SkipSpaces();
+			ok = (*cursor == ')');
+		}
+		if (ok) {
+			cursor++;
+		}
+
+	} else if (IsDigit(*cursor) || (*cursor == '.')) {
+
+		char8 *end = NULL_PTR(char8*);
+		const float64 value = strtod(cursor, &end);
+		ok = (end != cursor);
+		if (ok) {
+			cursor = end;
+			// Implicit multiplications (e.g. 2x) are left to exprtk
+			ok = (!IsIdentifierStart(*cursor) && !IsDigit(*cursor) && (*cursor != '.'));
+		}
+		if (ok) {
+			Node constant;
+			constant.scalar = true;
+			constant.variable = -1;
+			constant.element = 0u;
+			constant.version = 0u;
+			constant.value = value;
+			node = AddLeaf(constant);
+		}
+
+	} else if (IsIdentifierStart(*cursor)) {
+
+		StreamString identifier;
+		ok = ParseIdentifier(identifier);
+		SkipSpaces();
+
+		if (ok && (*cursor == '(')) {
+
+			// Function call
+			float64 (*function)(float64) = NULL_PTR(float64 (*)(float64));
+			for (uint32 i = 0u; (vectorFunctions[i].name != NULL_PTR(const char8*)) && (function == NULL_PTR(float64 (*)(float64))); i++) {
+				if (StringHelper::Compare(identifier.Buffer(), vectorFunctions[i].name) == 0) {
+					function = vectorFunctions[i].function;
+				}
+			}
+			ok = (function != NULL_PTR(float64 (*)(float64)));
+			int32 argument = -1;
+			if (ok) {
+				cursor++;
+				ok = ParseSum(argument);
+			}
+			if (ok) {
+				SkipSpaces();
+				ok = (*cursor == ')');
+			}
+			if (ok) {
+				cursor++;
+				Node call;
+				call.op = OpFunction;
+				call.leaf = false;
+				call.scalar = false;
+				call.variable = -1;
+				call.element = 0u;
+				call.version = 0u;
+				call.value = 0.0;
+				call.function = function;
+				call.child[0] = argument;
+				call.child[1] = -1;
+				call.child[2] = -1;
+				node = FindOrAddNode(call);
+			}
+
+		} else if (ok) {
+
+			// Signal, or signal element with a constant index
+			uint32 variableIdx = numVariables;
+			for (uint32 i = 0u; (i < numVariables) && (variableIdx == numVariables); i++) {
+				if (StringHelper::Compare(identifier.Buffer(), variableNames[i].Buffer()) == 0) {
+					variableIdx = i;
+				}
+			}
+			ok = (variableIdx < numVariables);
+			if (ok) {
+				Node leaf;
+				leaf.scalar = false;
+				leaf.variable = static_cast<int32>(variableIdx);
+				leaf.element = 0u;
+				leaf.version = variableVersion[variableIdx];
+				leaf.value = 0.0;
+
+				if (*cursor == '[') {
+
+					cursor++;
+					SkipSpaces();
+					uint32 index = 0u;
+					ok = IsDigit(*cursor);
+					while (IsDigit(*cursor)) {
+						index = (index * 10u) + static_cast<uint32>(*cursor - '0');
+						cursor++;
+					}
+					if (ok) {
+						SkipSpaces();
+						ok = (*cursor == ']') && (index < variableSizes[variableIdx]) && (variableIdx != outputVariable);
+					}
+					if (ok) {
+						cursor++;
+						leaf.scalar = true;
+						leaf.element = index;
+						statementScalarReads.push_back(variableIdx);
+					}
+
+				} else if (variableSizes[variableIdx] < statementElements) {
+
+					statementElements = variableSizes[variableIdx];
+
+				}
+
+				if (ok) {
+					node = AddLeaf(leaf);
+				}
+			}
+
+		}
+
+	} else {
+
+		ok = false;
+
+	}
+
+	return ok;
+
+}
+
+bool MathExpressionVectorProgram::ParseIdentifier(StreamString &identifier) {
+
+	bool ok = IsIdentifierStart(*cursor);
+
+	while (IsIdentifierStart(*cursor) || IsDigit(*cursor)) {
+
+		identifier += *cursor;
+		cursor++;
+
+	}
+
+	return ok;
+
+}
+
+void MathExpressionVectorProgram::SkipSpaces() {
+
+	while ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\n') || (*cursor == '\r')) {
+		cursor++;
+	}
+
+}
+
+int32 MathExpressionVectorProgram::AddNode(const OpCode op, const int32 first, const int32 second, const int32 third) {
+
+	Node node;
+	node.op = op;
+	node.leaf = false;
+	node.scalar = false;
+	node.variable = -1;
+	node.element = 0u;
+	node.version = 0u;
+	node.value = 0.0;
+	node.function = NULL_PTR(float64 (*)(float64));
+	node.child[0] = first;
+	node.child[1] = second;
+	node.child[2] = third;
+
+	return FindOrAddNode(node);
+
+}
+
+int32 MathExpressionVectorProgram::AddLeaf(const Node &leaf) {
+
+	Node node = leaf;
+	node.op = OpCopy;
+	node.leaf = true;
+	node.function = NULL_PTR(float64 (*)(float64));
+	node.child[0] = -1;
+	node.child[1] = -1;
+	node.child[2] = -1;
+
+	return FindOrAddNode(node);
+
+}
+
+int32 MathExpressionVectorProgram::FindOrAddNode(const Node &node) {
+
+	int32 found = -1;
+
+	for (uint32 i = 0u; (i < nodes.size()) && (found < 0); i++) {
+
+		const Node &other = nodes[i];
+		bool same = (other.leaf == node.leaf) && (other.op == node.op) && (other.function == node.function);
+		same = same && (other.child[0] == node.child[0]) && (other.child[1] == node.child[1]) && (other.child[2] == node.child[2]);
+		if (same && node.leaf) {
+			same = (other.scalar == node.scalar) && (other.variable == node.variable) && (other.element == node.element) && (other.version == node.version);
+			if (same && (node.variable < 0)) {
+				// Bitwise, so that 0 and -0 are different constants
+				same = (memcmp(&other.value, &node.value, sizeof(float64)) == 0);
+			}
+		}
+		if (same) {
+			found = static_cast<int32>(i);
+		}
+
+	}
+
+	if (found < 0) {
+
+		nodes.push_back(node);
+		found = static_cast<int32>(nodes.size() - 1u);
+
+	}
+
+	return found;
+
+}
+
+MathExpressionVectorProgram::Operand MathExpressionVectorProgram::Emit(const int32 node, const Operand &output) {
+
+	const uint32 nodeIdx = static_cast<uint32>(node);
+	const Node current = nodes[nodeIdx];
+	const bool toOutput = (output.base != NULL_PTR(float64*));
+	Operand result = NoOperand();
+	bool written = false;
+
+	if (nodeEmitted[nodeIdx]) {
+
+		// Subexpression already computed by this program
+		result = nodeOperand[nodeIdx];
+
+	} else if (current.leaf) {
+
+		if (current.variable < 0) {
+
+			result.constant = static_cast<int32>(constants.size());
+			result.scalar = true;
+			constants.push_back(current.value);
+
+		} else if (current.scalar) {
+
+			// Signal elements with a constant index are read in place
+			result.base = variableMemory[current.variable] + current.element;
+			result.scalar = true;
+
+		} else {
+
+			result.base = variableMemory[current.variable];
+			result.advance = 1u;
+
+		}
+
+		nodeEmitted[nodeIdx] = true;
+		nodeOperand[nodeIdx] = result;
+
+	} else {
+
+		Instruction instruction;
+		instruction.function = current.function;
+		OpCode op = current.op;
+
+		/// a*b+c, c+a*b and a*b-c are fused in a single instruction, unless a*b is shared.
+		int32 sources[3] = { current.child[0], current.child[1], current.child[2] };
+		if ((op == OpAdd) || (op == OpSubtract)) {
+
+			const uint32 left = static_cast<uint32>(current.child[0]);
+			const uint32 right = static_cast<uint32>(current.child[1]);
+
+			if ((!nodes[left].leaf) && (nodes[left].op == OpMultiply) && (nodeUses[left] == 1u) && (!nodeEmitted[left])) {
+
+				op = (op == OpAdd) ? OpMultiplyAdd : OpMultiplySubtract;
+				sources[0] = nodes[left].child[0];
+				sources[1] = nodes[left].child[1];
+				sources[2] = current.child[1];
+
+			} else if ((op == OpAdd) && (!nodes[right].leaf) && (nodes[right].op == OpMultiply) && (nodeUses[right] == 1u) && (!nodeEmitted[right])) {
+
+				op = OpMultiplyAdd;
+				sources[0] = nodes[right].child[0];
+				sources[1] = nodes[right].child[1];
+				sources[2] = current.child[0];
+
+			}
+
+		}
+
+		uint32 numberOfSources = 0u;
+		for (uint32 i = 0u; (i < 3u) && (sources[i] >= 0); i++) {
+
+			instruction.source[i] = Emit(sources[i], NoOperand());
+			numberOfSources++;
+
+		}
+
+		// The sources are read before the destination is written (see VectorKernel),
+		// so the destination can reuse a source register.
+		for (uint32 i = 0u; i < numberOfSources; i++) {
+			Consume(sources[i]);
+		}
+
+		// Unused sources read the first one (the loads are optimised away)
+		for (uint32 i = numberOfSources; i < 3u; i++) {
+			instruction.source[i] = instruction.source[0];
+			instruction.source[i].scalar = true;
+		}
+
+		if (toOutput) {
+			instruction.destination = output;
+			written = true;
+		} else {
+			instruction.destination = NoOperand();
+			instruction.destination.reg = NewRegister();
+			instruction.destination.temporary = true;
+		}
+
+		instruction.kernel = SelectKernel(op, instruction);
+		program.push_back(instruction);
+
+		result = instruction.destination;
+		nodeEmitted[nodeIdx] = true;
+		nodeOperand[nodeIdx] = result;
+
+	}
+
+	if (toOutput && !written) {
+
+		// The statement is a single operand or a shared subexpression
+		Instruction copy;
+		copy.function = NULL_PTR(float64 (*)(float64));
+		copy.destination = output;
+		copy.source[0] = result;
+		copy.source[1] = result;
+		copy.source[2] = result;
+		copy.source[1].scalar = true;
+		copy.source[2].scalar = true;
+		copy.kernel = SelectKernel(OpCopy, copy);
+		program.push_back(copy);
+
+		result = output;
+
+	}
+
+	return result;
+
+}
+
+MathExpressionVectorProgram::Kernel MathExpressionVectorProgram::SelectKernel(const OpCode op, const Instruction &instruction) {
+
+	const bool scalarA = instruction.source[0].scalar;
+	const bool scalarB = instruction.source[1].scalar;
+	const bool scalarC = instruction.source[2].scalar;
+	Kernel kernel = NULL_PTR(Kernel);
+
+	switch (op) {
+	case OpCopy:
+		kernel = SelectVectorKernel<VectorCopy>(scalarA, scalarB, scalarC);
+		break;
+	case OpNegate:
+		kernel = SelectVectorKernel<VectorNegate>(scalarA, scalarB, scalarC);
+		break;
+	case OpAdd:
+		kernel = SelectVectorKernel<VectorAdd>(scalarA, scalarB, scalarC);
+		break;
+	case OpSubtract:
+		kernel = SelectVectorKernel<VectorSubtract>(scalarA, scalarB, scalarC);
+		break;
+	case OpMultiply:
+		kernel = SelectVectorKernel<VectorMultiply>(scalarA, scalarB, scalarC);
+		break;
+	case OpDivide:
+		kernel = SelectVectorKernel<VectorDivide>(scalarA, scalarB, scalarC);
+		break;
+	case OpMultiplyAdd:
+		kernel = SelectVectorKernel<VectorMultiplyAdd>(scalarA, scalarB, scalarC);
+		break;
+	case OpMultiplySubtract:
+		kernel = SelectVectorKernel<VectorMultiplySubtract>(scalarA, scalarB, scalarC);
+		break;
+	case OpFunction:
+		if (scalarA) {
+			kernel = &VectorFunctionKernel<0u>;
+		} else {
+			kernel = &VectorFunctionKernel<1u>;
+		}
+		break;
+	}
+
+	return kernel;
+
+}
+
+void MathExpressionVectorProgram::Consume(const int32 node) {
+
+	const uint32 nodeIdx = static_cast<uint32>(node);
+
+	if (nodeUses[nodeIdx] > 0u) {
+		nodeUses[nodeIdx]--;
+	}
+	if ((nodeUses[nodeIdx] == 0u) && nodeEmitted[nodeIdx]) {
+		ReleaseRegister(nodeOperand[nodeIdx]);
+	}
+
+}
+
+int32 MathExpressionVectorProgram::NewRegister() {
+
+	int32 reg;
+
+	if (freeRegisters.size() > 0u) {
+
+		reg = freeRegisters.back();
+		freeRegisters.pop_back();
+
+	} else {
+
+		reg = static_cast<int32>(numberOfRegisters);
+		numberOfRegisters++;
+
+	}
+
+	return reg;
+
+}
+
+void MathExpressionVectorProgram::ReleaseRegister(const Operand &operand) {
+
+	if (operand.temporary) {
+
+		bool released = false;
+		for (uint32 i = 0u; i < freeRegisters.size(); i++) {
+			released = released || (freeRegisters[i] == operand.reg);
+		}
+		if (!released) {
+			freeRegisters.push_back(operand.reg);
+		}
+
+	}
+
+}
+
+void MathExpressionVectorProgram::Resolve(Operand &operand) {
+
+	if (operand.reg >= 0) {
+
+		operand.base = &registers[static_cast<uint32>(operand.reg) * ChunkSize];
+		operand.advance = 0u;
+
+	} else if (operand.constant >= 0) {
+
+		operand.base = &constants[static_cast<uint32>(operand.constant)];
+		operand.advance = 0u;
+
+	}
+
+}
+
+MathExpressionVectorProgram::Operand MathExpressionVectorProgram::NoOperand() {
+
+	Operand operand;
+	operand.base = NULL_PTR(float64*);
+	operand.advance = 0u;
+	operand.scalar = false;
+	operand.reg = -1;
+	operand.constant = -1;
+	operand.temporary = false;
+
+	return operand;
+
+}
+
+}
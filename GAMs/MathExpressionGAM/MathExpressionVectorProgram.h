@@ -0,0 +1,389 @@
+/**
+ * @file MathExpressionVectorProgram.h
+ * @brief Header file for class MathExpressionVectorProgram
+ * @date 19/10/2026
+ * @author nn
+ *
+ * @copyright Copyright 2015 F4E | European Joint Undertaking for ITER and
+ * the Development of Fusion Energy ('Fusion for Energy').
+ * Licensed under the EUPL, Version 1.1 or - as soon they will be approved
+ * by the European Commission - subsequent versions of the EUPL (the "Licence")
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at: http://ec.europa.eu/idabc/eupl
+ *
+ * @warning Unless required by applicable law or agreed to in writing,
+ * software distributed under the Licence is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+ * or implied. See the Licence permissions and limitations under the Licence.
+
+ * @details This header file contains the declaration of the class MathExpressionVectorProgram
+ * with all of its public, protected and private members. It may also include
+ * definitions for inline methods which need to be visible to the compiler.
+ */
+
+#ifndef MATHEXPRESSIONVECTORPROGRAM_H_
+#define MATHEXPRESSIONVECTORPROGRAM_H_
+
+/*---------------------------------------------------------------------------*/
+/*                        Standard header includes                           */
+/*---------------------------------------------------------------------------*/
+
+#include <vector>
+
+/*---------------------------------------------------------------------------*/
+/*                        Project header includes                            */
+/*---------------------------------------------------------------------------*/
+
+#include "StreamString.h"
+
+/*---------------------------------------------------------------------------*/
+/*                           Class declaration                               */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+/**
+ * @brief Flat evaluator for element-wise vector expressions.
+ * @details Used by MathExpressionGAM in place of exprtk for the statements
+ * that have the form
+ *
+ * <pre>
+ * Out := <expression>;
+ * </pre>
+ *
+ * where <expression> only contains:
+ * - whole signals (element-wise operands),
+ * - signal elements with a constant index, e.g. In2[0] (broadcast to all the elements),
+ * - numeric constants,
+ * - the operators + - * / (binary and unary) and parentheses,
+ * - the functions sqrt, abs, exp, log, sin, cos, tan and tanh.
+ *
+ * As in exprtk, the number of elements that are computed is the size of the
+ * smallest vector in the assignment. Elements of the output itself (e.g.
+ * Out := Out[0] * x) are left to exprtk, as they are overwritten while the
+ * program runs.
+ *
+ * A program holds a sequence of statements with the same number of elements.
+ * Identical subexpressions (the same operation on the same values) are
+ * computed once and shared by all the statements of the program. A statement
+ * that reads an element of a variable written by the program, or that writes
+ * a variable whose elements are read by the program, cannot be added, as the
+ * results would depend on the chunk order.
+ *
+ * The statements are lowered to a list of register instructions (with a*b+c
+ * and a*b-c fused in a single instruction) that is run over the vectors in
+ * chunks of ChunkSize elements, so that the registers of a chunk stay in the
+ * L1 cache. The kernel of each instruction is selected in Compile() for its
+ * operation and for the kind (vector or scalar) of each operand, so that
+ * Execute() does no dispatch and scalars are read in place. The kernels
+ * process blocks of 4 elements that the compiler vectorises.
+ */
+class MathExpressionVectorProgram {
+public:
+
+	/**
+	 * Number of elements processed by each instruction in one go.
+	 */
+	static const uint32 ChunkSize = 256u;
+
+	/**
+	 * @brief Constructor. NOOP.
+	 */
+	MathExpressionVectorProgram();
+
+	/**
+	 * @brief Destructor. NOOP.
+	 */
+	~MathExpressionVectorProgram();
+
+	/**
+	 * @brief Sets the variables that the statements can use.
+	 * @param[in] names the names of the variables.
+	 * @param[in] memory the float64 memory the variables are bound to.
+	 * @param[in] sizes the number of elements of the variables.
+	 * @param[in] numberOfVariables the number of variables.
+	 * @details The arrays must outlive the calls to AddStatement() and Compile().
+	 */
+	void SetVariables(const StreamString * const names,
+					  float64 * const * const memory,
+					  const uint32 * const sizes,
+					  const uint32 numberOfVariables);
+
+	/**
+	 * @brief Parses a statement and appends it to the program.
+	 * @param[in] expression the statement text.
+	 * @param[in] outputIdx index of the variable that is assigned.
+	 * @return false if the statement is not a purely element-wise assignment to
+	 * the variable \a outputIdx or cannot be added to this program (different
+	 * number of elements, or element reads of variables written by the program).
+	 * The program is then left unchanged.
+	 * @pre SetVariables().
+	 */
+	bool AddStatement(const char8 * const expression,
+					  const uint32 outputIdx);
+
+	/**
+	 * @brief Lowers the statements to the instructions.
+	 * @pre AddStatement() returned true at least once.
+	 */
+	void Compile();
+
+	/**
+	 * @return the number of statements in the program.
+	 */
+	uint32 GetNumberOfStatements() const;
+
+	/**
+	 * @return the number of subexpressions computed once and used more than once.
+	 * @pre Compile().
+	 */
+	uint32 GetNumberOfSharedSubexpressions() const;
+	
+	/**
+	 * @return the number of instructions, i.e. of operations computed for each
+	 * element (a*b+c and a*b-c count as one).
+	 * @pre Compile().
+	 */
+	uint32 GetNumberOfInstructions() const;
+
+	/**
+	 * @brief Evaluates the statements and writes the results to the output memory.
+	 * @pre Compile().
+	 */
+	void Execute();
+
+	/**
+	 * @brief Evaluates the elements [begin, end) of the statements, using the
+	 * registers in \a bank instead of the ones of the program.
+	 * @details Disjoint ranges can be evaluated at the same time by different
+	 * threads, each one with its own bank: the statements of a program do not
+	 * depend on the order in which the elements are computed.
+	 * @param[in] begin first element, a multiple of ChunkSize.
+	 * @param[in] end one past the last element.
+	 * @param[in] bank GetRegisterBankSize() elements of memory for the registers.
+	 * @pre Compile().
+	 */
+	void ExecuteRange(const uint32 begin,
+					  const uint32 end,
+					  float64 * const bank) const;
+
+	/**
+	 * @return the number of elements that are computed.
+	 * @pre Compile().
+	 */
+	uint32 GetNumberOfElements() const;
+
+	/**
+	 * @return the number of elements of the memory needed for the registers.
+	 * @pre Compile().
+	 */
+	uint32 GetRegisterBankSize() const;
+
+private:
+
+	/**
+	 * Instruction codes.
+	 */
+	enum OpCode {
+		OpCopy,
+		OpNegate,
+		OpAdd,
+		OpSubtract,
+		OpMultiply,
+		OpDivide,
+		OpMultiplyAdd,
+		OpMultiplySubtract,
+		OpFunction
+	};
+
+	/**
+	 * Node of the parsed statements. Identical nodes are stored once.
+	 */
+	struct Node {
+		OpCode          op;				//!< Operation (for inner nodes).
+		bool            leaf;			//!< True for variables and constants.
+		bool            scalar;			//!< True if the leaf is a single value applied to all the elements.
+		int32           variable;		//!< Variable of a leaf (-1 for constants).
+		uint32          element;		//!< Element of a scalar variable leaf.
+		uint32          version;		//!< Number of statements that had written the variable when the leaf was parsed.
+		float64         value;			//!< Value of a constant leaf.
+		float64       (*function)(float64);	//!< Function of OpFunction nodes.
+		int32           child[3];		//!< Operands (-1 if unused).
+	};
+
+	/**
+	 * Operand of an instruction. For the chunk starting at element offset the
+	 * operand is read from base + offset * advance, with stride 1 (vectors) or
+	 * 0 (scalars: constants and signal elements, read in place).
+	 */
+	struct Operand {
+		float64* base;
+		uint32   advance;
+		bool     scalar;
+		int32    reg;		//!< Register index, resolved to base at the end of Compile() (-1 if none).
+		int32    constant;	//!< Constant index, resolved to base at the end of Compile() (-1 if none).
+		bool     temporary;	//!< True if the register can be reused once read.
+	};
+
+	/**
+	 * Kernel of an instruction, specialised on the operation and on the operand strides.
+	 */
+	typedef void (*Kernel)(float64 * const d,
+						   const float64 * const a,
+						   const float64 * const b,
+						   const float64 * const c,
+						   const uint32 n,
+						   float64 (* const function)(float64));
+
+	/**
+	 * Register instruction.
+	 */
+	struct Instruction {
+		Kernel     kernel;
+		float64  (*function)(float64);
+		Operand    destination;
+		Operand    source[3];
+	};
+
+	/**
+	 * @name Parser
+	 */
+	//@{
+	bool ParseSum(int32 &node);
+	bool ParseProduct(int32 &node);
+	bool ParseUnary(int32 &node);
+	bool ParsePrimary(int32 &node);
+	bool ParseIdentifier(StreamString &identifier);
+	void SkipSpaces();
+	int32 AddNode(const OpCode op, const int32 first, const int32 second, const int32 third);
+	int32 AddLeaf(const Node &leaf);
+	int32 FindOrAddNode(const Node &node);
+	//@}
+
+	/**
+	 * @brief Emits the instructions of a node, or reuses its result if already emitted.
+	 * @param[in] node the node to emit.
+	 * @param[in] output the output operand (NULL base to write to a register).
+	 * @return where the result of the node can be read.
+	 */
+	Operand Emit(const int32 node, const Operand &output);
+
+	/**
+	 * @brief Selects the kernel of an instruction for its operation and operand kinds.
+	 */
+	static Kernel SelectKernel(const OpCode op, const Instruction &instruction);
+
+	/**
+	 * @brief Marks one use of the result of a node, releasing its register after the last one.
+	 */
+	void Consume(const int32 node);
+
+	/**
+	 * @brief Reserves a register, reusing the released ones.
+	 */
+	int32 NewRegister();
+
+	/**
+	 * @brief Releases the register of a temporary operand.
+	 */
+	void ReleaseRegister(const Operand &operand);
+
+	/**
+	 * @brief Resolves the register and constant indices to addresses.
+	 */
+	void Resolve(Operand &operand);
+
+	/**
+	 * @brief Returns an operand that reads nothing.
+	 */
+	static Operand NoOperand();
+
+	/**
+	 * @brief Address of an operand for the chunk starting at \a offset, with
+	 * the registers in \a bank.
+	 */
+	static inline float64 *Address(const Operand &operand,
+								   const uint32 offset,
+								   float64 * const bank);
+
+	/**
+	 * Variables.
+	 */
+	const StreamString* variableNames;
+	float64* const* variableMemory;
+	const uint32* variableSizes;
+	uint32 numVariables;
+
+	/**
+	 * Per variable: number of statements that write it, and whether its elements are read.
+	 */
+	std::vector<uint32> variableVersion;
+	std::vector<bool> variableReadAsScalar;
+
+	/**
+	 * Parser state.
+	 */
+	const char8* cursor;
+	uint32 outputVariable;
+	uint32 statementElements;
+	std::vector<uint32> statementScalarReads;
+
+	/**
+	 * Parsed statements: root node and assigned variable.
+	 */
+	std::vector<Node> nodes;
+	std::vector<int32> statementRoot;
+	std::vector<uint32> statementOutput;
+
+	/**
+	 * Lowering state, per node.
+	 */
+	std::vector<uint32> nodeUses;
+	std::vector<bool> nodeEmitted;
+	std::vector<Operand> nodeOperand;
+
+	/**
+	 * Number of elements that are computed.
+	 */
+	uint32 numberOfElements;
+
+	/**
+	 * Number of subexpressions used more than once.
+	 */
+	uint32 numberOfSharedSubexpressions;
+
+	/**
+	 * The compiled program.
+	 */
+	std::vector<Instruction> program;
+
+	/**
+	 * Register memory, ChunkSize elements for each register.
+	 */
+	std::vector<float64> registers;
+	uint32 numberOfRegisters;
+	std::vector<int32> freeRegisters;
+
+	/**
+	 * Constants of the statements.
+	 */
+	std::vector<float64> constants;
+};
+
+} /* Namespace MARTe */
+
+/*---------------------------------------------------------------------------*/
+/*                        Inline method definitions                          */
+/*---------------------------------------------------------------------------*/
+
+namespace MARTe {
+
+float64 *MathExpressionVectorProgram::Address(const Operand &operand,
+											  const uint32 offset,
+											  float64 * const bank) {
+	return (operand.reg >= 0) ? (bank + (static_cast<uint32>(operand.reg) * ChunkSize)) : (operand.base + (offset * operand.advance));
+}
+
+} /* Namespace MARTe */
+
+#endif
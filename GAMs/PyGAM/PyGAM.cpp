@@ -36,6 +36,7 @@
 
 #include "PyGAM.h"
 #include "AdvancedErrorManagement.h"
+#include "MemoryOperationsHelper.h"
 #include <signal.h>
 
 /*---------------------------------------------------------------------------*/
@@ -46,6 +47,9 @@ namespace MARTe {
 
 PyGAM::PyGAM() : GAM(){
 	
+	inPlaceOutputFlag = 0;
+	pArguments = NULL;
+	
 }
 
 PyGAM::~PyGAM() {
@@ -106,6 +110,14 @@ bool PyGAM::Initialise(StructuredDataI & data) {
 		realtimeCheckFlag = 1;
 	}
 	
+	ok = data.Read("InPlaceOutputs", inPlaceOutputFlag);
+	paramOk = (inPlaceOutputFlag == 0 || inPlaceOutputFlag == 1);		// inPlaceOutputFlag can be either 0 or 1.
+	if (!ok || !paramOk) {
+		REPORT_ERROR(ErrorManagement::Debug,
+					 "InPlaceOutputs not set (or incorrect format). By default it will be set to 0.");
+		inPlaceOutputFlag = 0;
+	}
+	
 	ok = data.Read("FileName", fileName);
 	if (!ok) {
 		REPORT_ERROR(ErrorManagement::ParametersError,
@@ -586,6 +598,7 @@ bool PyGAM::Setup() {
 		GetSignalNumberOfElements(InputSignals, inputIdx, GAMNumberOfElements);
 		
 		pyInputStruct[inputIdx].GAMNumOfElts = GAMNumberOfElements;
+		GetSignalByteSize(InputSignals, inputIdx, pyInputStruct[inputIdx].size);
 		
 		ok = (pyNumberOfElements == GAMNumberOfElements);
 		if (!ok) {
@@ -645,6 +658,7 @@ bool PyGAM::Setup() {
 		GetSignalNumberOfElements(OutputSignals, outputIdx, GAMNumberOfElements);
 		
 		pyOutputStruct[outputIdx].GAMNumOfElts = GAMNumberOfElements;
+		GetSignalByteSize(OutputSignals, outputIdx, pyOutputStruct[outputIdx].size);
 		
 		ok = (pyNumberOfElements == GAMNumberOfElements);
 		if (!ok) {
@@ -693,6 +707,63 @@ bool PyGAM::Setup() {
 		goto error;
 	}
 	
+	// When the outputs are written in place, execute() receives
+	// the input arrays followed by the output arrays.
+	if (inPlaceOutputFlag == 1) {
+		
+		pArguments = PyTuple_New(pyNumOfInputs + pyNumOfOutputs);
+		ok = (pArguments != NULL);
+		if (!ok) {
+			REPORT_ERROR(ErrorManagement::Exception, "Failed to create argument tuple.");
+			goto error;
+		}
+		
+		for (uint32 argIdx = 0; argIdx < pyNumOfInputs + pyNumOfOutputs; argIdx++) {
+			
+			PyObject* argArray = (argIdx < pyNumOfInputs) ? PyTuple_GetItem(pInputs, argIdx) : PyTuple_GetItem(pOutputs, argIdx - pyNumOfInputs);
+			
+			// PyTuple_SetItem() steals the reference, the array also stays in its own tuple.
+			Py_INCREF(argArray);
+			PyTuple_SetItem(pArguments, argIdx, argArray);
+			
+		}
+		
+	}
+	
+	// Dry run with the outputs written in place: execute() must accept the
+	// input and output arrays. Note that this writes the output signals.
+	if ((realtimeCheckFlag == 1) && (inPlaceOutputFlag == 1)) {
+		
+		PyObject* pDryRunValue = PyObject_CallObject(pFunc, pArguments);
+		ok = (pDryRunValue != NULL);
+		if (!ok) {
+			REPORT_ERROR(ErrorManagement::Exception, "Dry run of Python execute() function failed.");
+			goto error;
+		}
+		
+		Py_DECREF(pDryRunValue);
+		
+	}
+	
+	// Dry run: execute() is called once on the current inputs, so that the
+	// tuple it returns is checked here instead of at every cycle.
+	if ((realtimeCheckFlag == 1) && (inPlaceOutputFlag == 0)) {
+		
+		PyObject* pDryRunOutputs = PyObject_CallObject(pFunc, pInputs);
+		ok = (pDryRunOutputs != NULL);
+		if (!ok) {
+			REPORT_ERROR(ErrorManagement::Exception, "Dry run of Python execute() function failed.");
+			goto error;
+		}
+		
+		ok = CheckOutputs(pDryRunOutputs);
+		Py_DECREF(pDryRunOutputs);
+		if (!ok) {
+			return ok;
+		}
+		
+	}
+	
 	PyPrint(pInputs);
 	PyPrint(pOutputs);
 	
@@ -754,15 +825,56 @@ bool PyGAM::Execute() {
 	// This is not needed, since input tuple is told to map GAM input memory and
 	// its reference count never changes afterwards, so its memory address remains the same.
 	
+	/***********************************************************************//**
+	*
+	* 2a. Outputs written in place: the output arrays wrap the GAM memory,
+	*     so that nothing needs to be checked nor copied back.
+	*
+	***************************************************************************/
+	
+	if (inPlaceOutputFlag == 1) {
+		
+		pValue = PyObject_CallObject(pFunc, pArguments);
+		ok = (pValue != NULL);
+		if (!ok) {
+			
+			// The error is only reported: the interpreter and pFunc must stay
+			// alive for the next cycles.
+			PyErr_Fetch(&pErrorType, &pErrorValue, &pTraceback);
+			
+			PyObject* pStr = PyObject_Str(pErrorValue);
+			
+			REPORT_ERROR(ErrorManagement::Exception,
+						 "Call of Python execute() function failed. PyErr reported: %s",
+						 (pStr != NULL) ? PyUnicode_AsUTF8(pStr) : "unknown");
+			
+			Py_XDECREF(pStr);
+			Py_XDECREF(pErrorType);
+			Py_XDECREF(pErrorValue);
+			Py_XDECREF(pTraceback);
+			PyErr_Clear();
+			
+			return ok;
+			
+		}
+		
+		// The return value (usually None) is not used.
+		Py_DECREF(pValue);
+		
+		return ok;
+		
+	}
+	
 	/***********************************************************************//**
 	* 
 	* 2. Call of the execute() method of the Python code.
 	* 
 	***************************************************************************/
 	
+	// The tuple returned at the previous cycle is released.
+	Py_XDECREF(pOutputs);
 	pOutputs = PyObject_CallObject(pFunc, pInputs);
 	
-	// TODO: this checks should be moved away from the execute method (maybe a phony execute() call in Setup()?)
 	ok = (pOutputs != NULL);
 	if (!ok) {
 		
@@ -773,98 +885,31 @@ bool PyGAM::Execute() {
 		
 	}
 	
-	ok = PyTuple_Check(pOutputs);
+	// The contents of the tuple were checked by the dry run in Setup(),
+	// only what is needed to access it safely is checked here.
+	ok = (PyTuple_Check(pOutputs) && (static_cast<uint32>(PyTuple_GET_SIZE(pOutputs)) == pyNumOfOutputs));
 	if (!ok) {
 		
 		REPORT_ERROR(ErrorManagement::Exception,
-					 "Python output is not a tuple.");
-		goto error;
+					 "Python output is not a tuple of %i elements.",
+					 pyNumOfOutputs);
 		
-	}
-	
-	/***********************************************************************//**
-	* 
-	* 3. Check that the output tuple has the correct dimensions
-	*    and is made of the correct type.
-	* 
-	***************************************************************************/
-	
-	if (realtimeCheckFlag == 1) {
-		
-		uint32 realtimeNumberOfOutputs = PyTuple_Size(pOutputs);
-		ok = (realtimeNumberOfOutputs == pyNumOfOutputs);
-		if (!ok) {
-			REPORT_ERROR(ErrorManagement::Exception,
-						 "Unexpected number of outputs from Python execute() function. GAM expected: (%i), Python returned: (%i).",
-						 pyNumOfOutputs,
-						realtimeNumberOfOutputs
-						);
-			return ok; 
-		}
-		
-		for (uint32 outputIdx = 0; outputIdx < pyNumOfOutputs; outputIdx++) {
-			
-			// Get the type of the current output.
-			uint32 outputType = PyArray_TYPE((PyArrayObject*) PyTuple_GetItem(pOutputs, outputIdx));
-			
-			// Compare with the stored type (whose coherence was already checked
-			// both against MARTe2 configuration file and Python).
-			ok = (outputType == pyOutputStruct[outputIdx].enumType);
-			
-			// Error logging.
-			if (!ok) {
-				
-				// Generate a string from the numpy type.
-				PyObject* objRepresentation = PyObject_Repr((PyObject*) PyArray_DescrFromType(outputType));
-				PyObject* str = PyUnicode_AsEncodedString(objRepresentation, "utf-8", "~E~");
-				const char *typeBytes = PyBytes_AS_STRING(str);
-				
-				// Generate a string from MARTe2 type.
-				StreamString typeStr = TypeDescriptor::GetTypeNameFromTypeDescriptor(pyOutputStruct[outputIdx].GAMType);
-				
-				REPORT_ERROR(ErrorManagement::Exception,
-							"Output no. %i: unexpected output type from Python execute() function. GAM expected: (%s), Python returned: (%s).",
-							outputIdx,
-							typeStr.Buffer(),
-							typeBytes
-							);
-				
-				REPORT_ERROR(ErrorManagement::Information,
-							"NumPy always upcasts the result of an operation to float64 when an integer is involved.");
-				
-				return ok;
-			}
-			
-			// Get number of elements of the current output.
-			uint32 pyNumberOfElements = PyArray_SIZE((PyArrayObject*) PyTuple_GetItem(pOutputs, outputIdx));
-			ok = (pyNumberOfElements == pyOutputStruct[outputIdx].GAMNumOfElts);
-			
-			if (!ok) {
-				
-				REPORT_ERROR(ErrorManagement::Exception,
-							 "Output no. %i: unexpected output number of elements from Python execute() function. GAM expected: (%i), Python returned: (%i).",
-							 outputIdx,
-							 pyOutputStruct[outputIdx].GAMNumOfElts,
-							 pyNumberOfElements
-				);
-				
-			}
-			
-		}
+		// Not a Python error: the interpreter must stay alive for the next cycles.
+		return ok;
 		
 	}
 	
 	/***********************************************************************//**
 	* 
-	* 4. Copy data from the output tuple to the GAM memory.
+	* 3. Copy data from the output tuple to the GAM memory.
 	* 
 	***************************************************************************/
-
- 	RefreshData(OutputSignals);
+	
+	ok = RefreshData(OutputSignals);
 	
 	/***********************************************************************//**
 	* 
-	* 5. Return and error handling.
+	* 4. Return and error handling.
 	* 
 	***************************************************************************/
 	
@@ -893,6 +938,95 @@ bool PyGAM::Execute() {
 	
 } // Execute()
 
+bool PyGAM::CheckOutputs(PyObject* outputs) {
+	
+	bool ok = PyTuple_Check(outputs);
+	if (!ok) {
+		
+		REPORT_ERROR(ErrorManagement::Exception,
+					 "Python output is not a tuple.");
+		return ok;
+		
+	}
+	
+	uint32 realtimeNumberOfOutputs = PyTuple_Size(outputs);
+	ok = (realtimeNumberOfOutputs == pyNumOfOutputs);
+	if (!ok) {
+		REPORT_ERROR(ErrorManagement::Exception,
+					 "Unexpected number of outputs from Python execute() function. GAM expected: (%i), Python returned: (%i).",
+					 pyNumOfOutputs,
+					 realtimeNumberOfOutputs
+					);
+		return ok; 
+	}
+	
+	for (uint32 outputIdx = 0; (outputIdx < pyNumOfOutputs) && ok; outputIdx++) {
+		
+		PyObject* output = PyTuple_GetItem(outputs, outputIdx);
+		
+		ok = PyArray_Check(output);
+		if (!ok) {
+			REPORT_ERROR(ErrorManagement::Exception,
+						 "Output no. %i: Python execute() function did not return a NumPy array.",
+						 outputIdx);
+			return ok;
+		}
+		
+		// Get the type of the current output.
+		uint32 outputType = PyArray_TYPE((PyArrayObject*) output);
+		
+		// Compare with the stored type (whose coherence was already checked
+		// both against MARTe2 configuration file and Python).
+		ok = (outputType == pyOutputStruct[outputIdx].enumType);
+		
+		// Error logging.
+		if (!ok) {
+			
+			// Generate a string from the numpy type.
+			PyObject* objRepresentation = PyObject_Repr((PyObject*) PyArray_DescrFromType(outputType));
+			PyObject* str = PyUnicode_AsEncodedString(objRepresentation, "utf-8", "~E~");
+			const char *typeBytes = PyBytes_AS_STRING(str);
+			
+			// Generate a string from MARTe2 type.
+			StreamString typeStr = TypeDescriptor::GetTypeNameFromTypeDescriptor(pyOutputStruct[outputIdx].GAMType);
+			
+			REPORT_ERROR(ErrorManagement::Exception,
+						"Output no. %i: unexpected output type from Python execute() function. GAM expected: (%s), Python returned: (%s).",
+						outputIdx,
+						typeStr.Buffer(),
+						typeBytes
+						);
+						
+			REPORT_ERROR(ErrorManagement::Information,
+						"NumPy always upcasts the result of an operation to float64 when an integer is involved.");
+						
+			Py_XDECREF(objRepresentation);
+			Py_XDECREF(str);
+			
+			return ok;
+		}
+		
+		// Get number of elements of the current output.
+		uint32 pyNumberOfElements = PyArray_SIZE((PyArrayObject*) output);
+		ok = (pyNumberOfElements == pyOutputStruct[outputIdx].GAMNumOfElts);
+		
+		if (!ok) {
+			
+			REPORT_ERROR(ErrorManagement::Exception,
+						 "Output no. %i: unexpected output number of elements from Python execute() function. GAM expected: (%i), Python returned: (%i).",
+						 outputIdx,
+						 pyOutputStruct[outputIdx].GAMNumOfElts,
+						 pyNumberOfElements
+			);
+			
+		}
+		
+	}
+	
+	return ok;
+	
+} // CheckOutputs()
+
 PyObject* PyGAM::CreateArgTuple(const SignalDirection direction, PyArgumentStruct* pyStruct) {
 	
 	bool ok = false;
@@ -975,6 +1109,11 @@ PyObject* PyGAM::CreateArgTuple(const SignalDirection direction, PyArgumentStruc
 			// Input tuple is created so that its data section is pointing to the memory of the GAM.
 			myArray = PyArray_SimpleNewFromData(2, dims, pyStruct[argIdx].enumType, GetInputSignalMemory(argIdx));
 			
+		} else if ((direction==OutputSignals) && (inPlaceOutputFlag == 1)) {
+			
+			// Outputs written in place by execute() map the memory of the GAM as the inputs.
+			myArray = PyArray_SimpleNewFromData(2, dims, pyStruct[argIdx].enumType, GetOutputSignalMemory(argIdx));
+			
 		} else if (direction==OutputSignals) {
 			
 			// For the output tuple this unuseful, since every time it is   
@@ -1002,8 +1141,6 @@ bool PyGAM::RefreshData(const SignalDirection direction) {
 	
 	PyArgumentStruct* pyStruct;
 	
-	TypeDescriptor argType;
-	
 	switch (direction) {
 		
 		case InputSignals:
@@ -1030,102 +1167,67 @@ bool PyGAM::RefreshData(const SignalDirection direction) {
 		
 	}
 	
-	for (uint32 argIdx = 0; argIdx < numberOfArgs; argIdx++) {
+	for (uint32 argIdx = 0; (argIdx < numberOfArgs) && ok; argIdx++) {
 		
 		PyObject* temp = PyTuple_GetItem(argTuple, argIdx);
 		
-		//argType = GetSignalType(direction, argIdx);
-		argType = pyStruct[argIdx].GAMType;
+		// An array of the GAM type, contiguous and with the GAM number of elements
+		// is copied as a whole. Anything else is first converted by NumPy
+		// in a single call (type, layout or a Python sequence).
+		bool direct = PyArray_Check(temp);
+		if (direct) {
+			
+			PyArrayObject* tempArray = (PyArrayObject*) temp;
+			direct = ((static_cast<uint32>(PyArray_TYPE(tempArray)) == pyStruct[argIdx].enumType)
+					  && (PyArray_IS_C_CONTIGUOUS(tempArray))
+					  && (static_cast<uint32>(PyArray_SIZE(tempArray)) == pyStruct[argIdx].GAMNumOfElts));
+			
+		}
 		
-		for (uint32 elemIdx = 0; elemIdx < pyStruct[argIdx].dimensions[0]*pyStruct[argIdx].dimensions[1]; elemIdx++) {
+		PyArrayObject* argArray = NULL;
+		if (direct) {
 			
-			//Now assign
+			argArray = (PyArrayObject*) temp;
+			Py_INCREF(argArray);
 			
-			if (argType==UnsignedInteger8Bit) {
-				
-				PyMemCopy<uint8>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==UnsignedInteger16Bit) {
-				
-				PyMemCopy<uint16>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==UnsignedInteger32Bit) {
-				
-				PyMemCopy<uint32>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==UnsignedInteger64Bit) {
-				
-				PyMemCopy<uint64>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==SignedInteger8Bit) {
-				
-				PyMemCopy<int8>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==SignedInteger16Bit) {
-				
-				PyMemCopy<int16>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==SignedInteger32Bit) {
-				
-				PyMemCopy<int32>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==SignedInteger64Bit) {
-				
-				PyMemCopy<int64>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==Float32Bit) {
-				
-				PyMemCopy<float32>(direction, argIdx, elemIdx, temp);
-				
-			} else if (argType==Float64Bit) {
-				
-				PyMemCopy<float64>(direction, argIdx, elemIdx, temp);
-				
-			}  else {
-				
+		} else {
+			
+			// PyArray_FromAny() steals the reference to the descriptor.
+			argArray = (PyArrayObject*) PyArray_FromAny(temp, PyArray_DescrFromType(pyStruct[argIdx].enumType), 0, 0,
+														NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_FORCECAST, NULL);
+			ok = (argArray != NULL);
+			if (ok) {
+				ok = (static_cast<uint32>(PyArray_SIZE(argArray)) == pyStruct[argIdx].GAMNumOfElts);
+			}
+			if (!ok) {
 				REPORT_ERROR(ErrorManagement::Exception,
-							 "Error while refreshing data between model and GAM.");
-				
+							 "Argument no. %i: cannot be converted to %i elements of type %s.",
+							 argIdx,
+							 pyStruct[argIdx].GAMNumOfElts,
+							 TypeDescriptor::GetTypeNameFromTypeDescriptor(pyStruct[argIdx].GAMType));
+				PyErr_Clear();
+			}
+			
+		}
+		
+		if (ok) {
+			
+			if (direction == InputSignals) {
+				ok = MemoryOperationsHelper::Copy(PyArray_DATA(argArray), pyStruct[argIdx].GAMAddress, pyStruct[argIdx].size);
+			} else {
+				ok = MemoryOperationsHelper::Copy(pyStruct[argIdx].GAMAddress, PyArray_DATA(argArray), pyStruct[argIdx].size);
 			}
 			
 		}
 		
+		Py_XDECREF(argArray);
+		
 	}
 	
 	return ok;
 	
 } // RefreshData
 
-template <typename T>
-void PyGAM::PyMemCopy(const SignalDirection direction, uint32 argIdx, uint32 elemIdx, PyObject* temp) {
-	
-	switch (direction) {
-		
-		case InputSignals:
-			
-			//*( (T*)PyArray_GETPTR1((PyArrayObject*) temp, elemIdx) ) = *( ( (T*)GetInputSignalMemory(argIdx) ) + elemIdx); // Alternative approach (has some problems with vectors)
-			
-			*(((T*) PyArray_DATA((PyArrayObject*) temp)) + elemIdx) = *(((T*) GetInputSignalMemory(argIdx)) + elemIdx);
-			
-			break;
-			
-		case OutputSignals:
-			
-			//*(((T*) GetOutputSignalMemory(argIdx)) + elemIdx) = *( (T*)PyArray_GETPTR1((PyArrayObject*) temp, elemIdx) ); // Alternative approach (has some problems with vectors)
-			
-			*(((T*) GetOutputSignalMemory(argIdx)) + elemIdx) = *(((T*) PyArray_DATA((PyArrayObject*) temp)) + elemIdx);
-			
-			break;
-			
-		default:
-			
-			REPORT_ERROR(ErrorManagement::Exception,
-						 "Unsupported data direction.");
-			
-	}
-	
-} // PyMemCopy
-
 uint32 PyGAM::NumPyEnumTypeFromMARTe2Type(TypeDescriptor MARTe2Type) {
 	
 	uint32 enumType;
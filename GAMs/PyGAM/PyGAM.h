@@ -61,15 +61,39 @@ namespace MARTe {
 * 
 * By default the GAM checks that the output tuple returned by the Python code
 * is coherent with the layout of the output signals as declared in the
-* configuration file at every cycle. This check can be disabled to improve
-* performances by setting RealtimeOutputCheck parameter to 0.
+* configuration file. The check is done once in Setup(), with a dry run of
+* execute() on the initial values of the inputs, so that Python code keeping
+* a state sees one more call. The dry run can be skipped by setting
+* RealtimeOutputCheck parameter to 0.
 * If no RealtimeOutputCheck parameter is specified, the GAM assumes it to be 1.
 * 
+* At every cycle each returned array which matches the type and the number
+* of elements of its output signal and is contiguous is copied into the GAM
+* memory with a single copy. Any other returned value is first converted by
+* NumPy to the type of the signal.
+* 
+* With InPlaceOutputs = 1 the outputs are not returned by the Python code
+* but written in place: like the inputs, the output arrays are NumPy arrays
+* that wrap the GAM memory of the output signals, and they are passed to
+* execute() after the inputs. The function writes them with out[...] = ...
+* (assigning a new array to the name would only rebind the local variable)
+* and its return value is ignored. No array is allocated nor copied at each
+* cycle. With RealtimeOutputCheck = 1 the dry run of Setup() calls
+* execute(x, y) on the GAM memory, so it fails Setup() if the function does
+* not accept the inputs followed by the outputs, and it writes the output
+* signals before the first cycle:
+* 
+* <pre>
+* def execute(x, y):
+*     y[...] = Kp * x
+* </pre>
+* 
 * <pre>
 * +MyGAM = {
 *     Class               = PyGAM
 *     FileName            = "pythonModuleName"
-*     RealtimeOutputCheck = 1                   // Set to 0 to disable checks on the output tuple.
+*     RealtimeOutputCheck = 1                   // Set to 0 to skip the dry run checking the output tuple in Setup().
+*     InPlaceOutputs      = 0                   // Set to 1 to have execute() write the outputs in place. Default 0.
 *     Parameters = {
 *         param1 = 1
 *         param2 = {1, 2}
@@ -136,6 +160,7 @@ private:
 	//@{
 	StreamString fileName;
 	uint8         realtimeCheckFlag;
+	uint8         inPlaceOutputFlag;					//!< 1 if execute() writes the outputs in place.
 	//@}
 	
 	/**
@@ -152,6 +177,7 @@ private:
 	
 	PyObject *pInputs;									//!< PyObject tuple holding input values.  @details A tuple is needed since only tuples are allowed as input of PyObject_CallObject().
 	PyObject *pOutputs;									//!< PyObject tuple holding output values. @details A tuple is needed since only tuples are allowed as input of PyObject_CallObject().
+	PyObject *pArguments;								//!< PyObject tuple holding the input and then the output arrays, passed to execute() when the outputs are written in place.
 	//@}
 	
 	/**
@@ -187,31 +213,33 @@ private:
 	 * @warning    PyObject_CallObject() changes the memory location of the tuple
 	 *             it uses as output, so if the tuple created by this function is
 	 *             used as output, then its addresses must be re-retrieved on each
-	 *             cycle.
+	 *             cycle. This does not apply when the outputs are written in
+	 *             place, in which case the output arrays wrap the GAM memory.
 	 */
 	PyObject* CreateArgTuple(const SignalDirection   direction,
 							       PyArgumentStruct* pyStruct);
 	
 	/**
 	 * @brief      Refreshes data.
-	 * @details    This methon updates input or output tuple.
+	 * @details    This methon updates input or output tuple. Each argument is
+	 *             copied with a single copy, after a conversion by NumPy if
+	 *             its type or layout do not match the signal.
 	 * @param[in]  
 	 * @param[out]
+	 * @return     false if an argument cannot be converted to its signal.
 	 * @warning    CallObject() returns a new reference of the tuple that is used
 	 *             as its output, so this is required only for the output tuple.
 	 */
 	bool RefreshData(const SignalDirection direction);
 	
 	/**
-	 * @brief Actual refreshing (templated).
-	 * 
+	 * @brief      Checks a tuple returned by execute() against the output signals.
+	 * @details    Number of outputs, type and number of elements of each of them.
+	 *             Called by Setup() on the result of a dry run of execute().
+	 * @return     true if the tuple matches the output signals.
 	 */
-	template <typename T>
-	void PyMemCopy(const     SignalDirection direction,
-				   uint32    argIdx,
-				   uint32    elemIdx,
-				   PyObject* temp);
-	
+	bool CheckOutputs(PyObject* outputs);
+
 	/**
 	 * @brief      Returns the PyArray enumerated type from a MARTe2 TypeDescriptor.
 	 * @return     PyArray enumerated type. 0 on fail.